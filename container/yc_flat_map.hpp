@@ -0,0 +1,230 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "../ycutil.hpp"
+
+namespace yc
+{
+    /**
+     * \brief open addressing (linear probing) hash map. session id 처럼 작은 key 를 위한 map 입니다.
+     * 원소가 하나의 배열에 들어있어 std::unordered_map 처럼 node 를 따라가지 않습니다.
+     * 삭제는 tombstone 없이 뒤의 원소를 당겨오므로 probe 길이가 늘어나지 않습니다.
+     * [*** 중요! ***] 삽입 / 삭제 / rehash 후에는 iterator 와 pointer 가 무효화됩니다.
+     * [*** 중요! ***] Key, Value 는 default constructible 해야 합니다. key 는 iterator 로 수정하면 안됩니다.
+     */
+    template <typename Key, typename Value, typename Hash = std::hash<Key>>
+    class flat_hash_map {
+    public:
+        using key_type = Key;
+        using mapped_type = Value;
+        using value_type = std::pair<Key, Value>;
+        using reference = value_type&;
+        using const_reference = const value_type&;
+        using difference_type = std::ptrdiff_t;
+        using size_type = size_t;
+
+    private:
+        static constexpr size_t min_capacity = 16;
+
+        // 사용 중인 slot 은 0이 아닌 값. 나머지 bit 에 hash 일부를 넣어 key 비교를 줄인다.
+        std::vector<uint8_t> ctrl_;
+        std::vector<value_type> slots_;
+        size_t size_ = 0;
+        size_t mask_ = 0;
+
+        static uint8_t tag_of(const size_t h) { return static_cast<uint8_t>(h >> 57) | 0x80; }
+
+        static size_t hash_of(const Key& key) {
+            // 약한 std::hash(정수는 identity) 를 섞어 linear probing 의 뭉침을 줄인다.
+            size_t h = Hash{}(key);
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdull;
+            h ^= h >> 33;
+            return h;
+        }
+
+        size_t find_index(const Key& key) const {
+            if (ctrl_.empty()) return npos;
+            const size_t h = hash_of(key);
+            const uint8_t tag = tag_of(h);
+            for (size_t i = h & mask_;; i = (i + 1) & mask_) {
+                if (ctrl_[i] == 0) return npos;
+                if (ctrl_[i] == tag && slots_[i].first == key) return i;
+            }
+        }
+
+        void rehash(const size_t capacity) {
+            std::vector<uint8_t> old_ctrl(capacity, 0);
+            std::vector<value_type> old_slots(capacity);
+            old_ctrl.swap(ctrl_);
+            old_slots.swap(slots_);
+            mask_ = capacity - 1;
+            for (size_t i = 0; i < old_ctrl.size(); ++i) {
+                if (old_ctrl[i] == 0) continue;
+                const size_t h = hash_of(old_slots[i].first);
+                size_t j = h & mask_;
+                while (ctrl_[j]) j = (j + 1) & mask_;
+                ctrl_[j] = tag_of(h);
+                slots_[j] = std::move(old_slots[i]);
+            }
+        }
+
+        template <bool Const>
+        class iterator_t {
+            using map_type = std::conditional_t<Const, const flat_hash_map, flat_hash_map>;
+            map_type* map_ = nullptr;
+            size_t i_ = 0;
+
+            void skip() {
+                while (i_ < map_->ctrl_.size() && map_->ctrl_[i_] == 0) ++i_;
+            }
+            friend class flat_hash_map;
+            friend class iterator_t<!Const>;
+
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = flat_hash_map::value_type;
+            using difference_type = std::ptrdiff_t;
+            using reference = std::conditional_t<Const, const value_type&, value_type&>;
+            using pointer = std::conditional_t<Const, const value_type*, value_type*>;
+
+            iterator_t() = default;
+            iterator_t(map_type* map, const size_t i) : map_(map), i_(i) { skip(); }
+            template <bool C = Const> requires C
+            iterator_t(const iterator_t<false>& other) : map_(other.map_), i_(other.i_) {}
+
+            reference operator*() const { return map_->slots_[i_]; }
+            pointer operator->() const { return &map_->slots_[i_]; }
+            iterator_t& operator++() {
+                ++i_;
+                skip();
+                return *this;
+            }
+            iterator_t operator++(int) {
+                auto r = *this;
+                ++*this;
+                return r;
+            }
+            bool operator==(const iterator_t& other) const { return i_ == other.i_; }
+        };
+
+    public:
+        using iterator = iterator_t<false>;
+        using const_iterator = iterator_t<true>;
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        flat_hash_map() = default;
+
+        /**
+         * \brief n 개를 rehash 없이 넣을 수 있도록 공간을 잡습니다. load factor 는 7/8 이하로 유지됩니다.
+         */
+        void reserve(const size_t n) {
+            const size_t need = std::bit_ceil(std::max(min_capacity, n + n / 7 + 1));
+            if (need > ctrl_.size()) rehash(need);
+        }
+
+        template <typename... Args>
+        std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args) {
+            if ((size_ + 1) * 8 > ctrl_.size() * 7) rehash(std::max(min_capacity, ctrl_.size() * 2));
+            const size_t h = hash_of(key);
+            const uint8_t tag = tag_of(h);
+            size_t i = h & mask_;
+            for (; ctrl_[i]; i = (i + 1) & mask_) {
+                if (ctrl_[i] == tag && slots_[i].first == key) return { iterator(this, i), false };
+            }
+            ctrl_[i] = tag;
+            slots_[i] = value_type(key, Value(std::forward<Args>(args)...));
+            ++size_;
+            return { iterator(this, i), true };
+        }
+
+        std::pair<iterator, bool> insert(const value_type& value) { return try_emplace(value.first, value.second); }
+
+        std::pair<iterator, bool> insert_or_assign(const Key& key, Value value) {
+            auto r = try_emplace(key);
+            r.first->second = std::move(value);
+            return r;
+        }
+
+        Value& operator[](const Key& key) { return try_emplace(key).first->second; }
+
+        iterator find(const Key& key) {
+            const size_t i = find_index(key);
+            return i == npos ? end() : iterator(this, i);
+        }
+        const_iterator find(const Key& key) const {
+            const size_t i = find_index(key);
+            return i == npos ? end() : const_iterator(this, i);
+        }
+
+        /**
+         * \return key 가 없으면 nullptr
+         */
+        Value* get(const Key& key) {
+            const size_t i = find_index(key);
+            return i == npos ? nullptr : &slots_[i].second;
+        }
+        const Value* get(const Key& key) const {
+            const size_t i = find_index(key);
+            return i == npos ? nullptr : &slots_[i].second;
+        }
+
+        [[nodiscard]] bool contains(const Key& key) const { return find_index(key) != npos; }
+
+        /**
+         * \return 지운 원소 수 (0 또는 1)
+         */
+        size_t erase(const Key& key) {
+            size_t i = find_index(key);
+            if (i == npos) return 0;
+            // backward shift deletion: 뒤에 이어진 원소 중 자기 자리보다 뒤에 밀려있던 것을 당겨온다.
+            for (size_t j = (i + 1) & mask_; ctrl_[j]; j = (j + 1) & mask_) {
+                const size_t home = hash_of(slots_[j].first) & mask_;
+                if (((j - home) & mask_) >= ((j - i) & mask_)) {
+                    ctrl_[i] = ctrl_[j];
+                    slots_[i] = std::move(slots_[j]);
+                    i = j;
+                }
+            }
+            ctrl_[i] = 0;
+            slots_[i] = value_type();
+            --size_;
+            return 1;
+        }
+
+        void clear() {
+            std::fill(ctrl_.begin(), ctrl_.end(), 0);
+            std::fill(slots_.begin(), slots_.end(), value_type());
+            size_ = 0;
+        }
+
+        iterator begin() { return iterator(this, 0); }
+        iterator end() { return iterator(this, ctrl_.size()); }
+        const_iterator begin() const { return const_iterator(this, 0); }
+        const_iterator end() const { return const_iterator(this, ctrl_.size()); }
+        const_iterator cbegin() const { return begin(); }
+        const_iterator cend() const { return end(); }
+
+        size_type size() const { return size_; }
+        size_type max_size() const { return slots_.max_size(); }
+        bool empty() const { return size_ == 0; }
+        size_t capacity() const { return ctrl_.size(); }
+
+        bool operator==(const flat_hash_map& other) const {
+            if (size_ != other.size_) return false;
+            for (auto& [k, v] : *this) {
+                const Value* o = other.get(k);
+                if (o == nullptr || !(*o == v)) return false;
+            }
+            return true;
+        }
+    };
+
+    static_assert(Container<flat_hash_map<int64_t, int>>);
+}
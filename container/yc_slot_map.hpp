@@ -0,0 +1,165 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "../ycutil.hpp"
+
+namespace yc
+{
+    /**
+     * \brief slot_map 의 원소를 가리키는 handle. 원소가 지워지면 generation 이 달라져 더이상 유효하지 않습니다.
+     */
+    struct slot_handle_t {
+        uint32_t index = std::numeric_limits<uint32_t>::max();
+        uint32_t generation = 0;
+
+        bool operator==(const slot_handle_t&) const = default;
+    };
+
+    /**
+     * \brief generational slot map.
+     * 원소는 하나의 연속된 배열(dense)에 모여 있어 순회가 pointer 를 따라가지 않고,
+     * handle 은 원소가 옮겨져도 유효하며, 삽입 / 삭제 / 조회가 모두 O(1) 입니다.
+     * 삭제는 마지막 원소를 빈 자리로 옮기므로 순회 순서는 유지되지 않습니다.
+     */
+    template <typename T>
+    class slot_map {
+        struct slot_t {
+            // 사용 중이면 data_ 의 위치, 비어있으면 다음 빈 slot.
+            uint32_t index;
+            // 홀수이면 사용 중.
+            uint32_t generation;
+        };
+        static constexpr uint32_t npos = std::numeric_limits<uint32_t>::max();
+
+        std::vector<T> data_;
+        // data_[i] 를 가리키는 slot 번호.
+        std::vector<uint32_t> owner_;
+        std::vector<slot_t> slots_;
+        uint32_t free_head_ = npos;
+
+    public:
+        using value_type = T;
+        using reference = T&;
+        using const_reference = const T&;
+        using iterator = typename std::vector<T>::iterator;
+        using const_iterator = typename std::vector<T>::const_iterator;
+        using difference_type = typename std::vector<T>::difference_type;
+        using size_type = typename std::vector<T>::size_type;
+        using handle_type = slot_handle_t;
+
+        slot_map() = default;
+
+        void reserve(const size_type n) {
+            data_.reserve(n);
+            owner_.reserve(n);
+            slots_.reserve(n);
+        }
+
+        template <typename... Args>
+        slot_handle_t emplace(Args&&... args) {
+            uint32_t s = free_head_;
+            if (s == npos) {
+                s = static_cast<uint32_t>(slots_.size());
+                slots_.push_back(slot_t{ npos, 0 });
+            }
+            else {
+                free_head_ = slots_[s].index;
+            }
+            auto& slot = slots_[s];
+            slot.index = static_cast<uint32_t>(data_.size());
+            ++slot.generation;
+            data_.emplace_back(std::forward<Args>(args)...);
+            owner_.push_back(s);
+            return slot_handle_t{ s, slot.generation };
+        }
+
+        slot_handle_t insert(const T& value) { return emplace(value); }
+        slot_handle_t insert(T&& value) { return emplace(std::move(value)); }
+
+        [[nodiscard]] bool contains(const slot_handle_t h) const {
+            return h.index < slots_.size() && slots_[h.index].generation == h.generation && (h.generation & 1);
+        }
+
+        /**
+         * \return handle 이 유효하지 않으면 nullptr
+         */
+        T* get(const slot_handle_t h) {
+            return contains(h) ? &data_[slots_[h.index].index] : nullptr;
+        }
+        const T* get(const slot_handle_t h) const {
+            return contains(h) ? &data_[slots_[h.index].index] : nullptr;
+        }
+
+        T& operator[](const slot_handle_t h) { return data_[slots_[h.index].index]; }
+        const T& operator[](const slot_handle_t h) const { return data_[slots_[h.index].index]; }
+
+        /**
+         * \return 지웠으면 true, handle 이 이미 유효하지 않았으면 false
+         */
+        bool erase(const slot_handle_t h) {
+            if (!contains(h)) return false;
+            auto& slot = slots_[h.index];
+            const uint32_t pos = slot.index;
+            const uint32_t last = static_cast<uint32_t>(data_.size() - 1);
+            if (pos != last) {
+                data_[pos] = std::move(data_[last]);
+                owner_[pos] = owner_[last];
+                slots_[owner_[pos]].index = pos;
+            }
+            data_.pop_back();
+            owner_.pop_back();
+            ++slot.generation;
+            slot.index = free_head_;
+            free_head_ = h.index;
+            return true;
+        }
+
+        /**
+         * \brief dense 배열의 i 번째 원소를 가리키는 handle.
+         */
+        slot_handle_t handle_at(const size_type i) const {
+            const uint32_t s = owner_[i];
+            return slot_handle_t{ s, slots_[s].generation };
+        }
+
+        void clear() {
+            data_.clear();
+            owner_.clear();
+            slots_.clear();
+            free_head_ = npos;
+        }
+
+        T* data() { return data_.data(); }
+        const T* data() const { return data_.data(); }
+
+        iterator begin() { return data_.begin(); }
+        iterator end() { return data_.end(); }
+        const_iterator begin() const { return data_.begin(); }
+        const_iterator end() const { return data_.end(); }
+        const_iterator cbegin() const { return data_.cbegin(); }
+        const_iterator cend() const { return data_.cend(); }
+
+        size_type size() const { return data_.size(); }
+        size_type max_size() const { return std::min<size_type>(data_.max_size(), npos - 1); }
+        bool empty() const { return data_.empty(); }
+
+        /**
+         * \brief 살아있는 원소만 비교합니다. 같은 handle 이 양쪽에서 모두 유효하고 같은 값을 가리키면 같습니다.
+         * 순회 순서, 빈 slot 과 free list 는 비교하지 않습니다.
+         */
+        bool operator==(const slot_map& other) const {
+            if (size() != other.size()) return false;
+            for (size_type i = 0; i < data_.size(); ++i) {
+                const T* o = other.get(handle_at(i));
+                if (o == nullptr || !(*o == data_[i])) return false;
+            }
+            return true;
+        }
+    };
+
+    static_assert(Container<slot_map<int>>);
+}
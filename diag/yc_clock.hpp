@@ -0,0 +1,44 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+ * \brief trace / metrics 가 hot path 에서 쓰는 시계.
+ * now_ticks 는 rdtsc 한번이라 steady_clock::now 보다 훨씬 쌉니다. tick 을 시간으로 바꾸는 것은 export 할 때 합니다.
+ */
+namespace yc_clock
+{
+    inline uint64_t now_ticks() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+    struct origin_t {
+        std::chrono::steady_clock::time_point time = std::chrono::steady_clock::now();
+        uint64_t ticks = now_ticks();
+    };
+
+    /**
+     * \brief 프로그램 시작 시각. tick 과 steady_clock 의 기준점입니다.
+     */
+    inline const origin_t origin {};
+
+    /**
+     * \brief 프로그램 시작부터 지금까지를 재서 tick 하나의 ns 를 구합니다. 오래 실행될수록 정확합니다.
+     */
+    inline double ns_per_tick() {
+        const auto time = std::chrono::steady_clock::now();
+        const uint64_t ticks = now_ticks();
+        if (ticks <= origin.ticks) return 1.0;
+        const double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(time - origin.time).count());
+        return ns / static_cast<double>(ticks - origin.ticks);
+    }
+}
@@ -0,0 +1,400 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "yc_clock.hpp"
+#include "../thread/lf_queue.hpp"
+
+/**
+ * \brief hot path 용 비동기 logger.
+ * YC_LOG_INFO("resend seq {} rtt {}", seq, rtt); 처럼 사용합니다.
+ * - YC_LOG_LEVEL 보다 낮은 level 의 log 는 컴파일 단계에서 사라집니다.
+ * - 호출한 thread 는 인자를 record 에 복사해 자기 spsc_ring 에 넣기만 합니다. 할당도 formatting 도 하지 않습니다.
+ * - formatting 과 출력은 background thread 가 합니다.
+ * - 같은 호출 위치의 log 는 초당 rate_limit 개까지만 남기고, 나머지는 다음 log 에 생략한 수를 붙입니다.
+ * 인자는 정수, 실수, bool, enum, pointer, 문자열(inline_string_size 까지 복사)만 받습니다.
+ */
+#ifndef YC_LOG_LEVEL
+// 0 trace, 1 debug, 2 info, 3 warn, 4 error, 5 off
+#define YC_LOG_LEVEL 2
+#endif
+
+namespace yc_log
+{
+    enum class level_t : int {
+        trace,
+        debug,
+        info,
+        warn,
+        error,
+        off,
+    };
+
+    constexpr size_t max_args = 6;
+    constexpr size_t inline_string_size = 30;
+    constexpr size_t ring_capacity = 1024;
+    constexpr uint32_t default_rate_limit = 20;
+
+    inline const char* level_name(const level_t level) {
+        static constexpr const char* names[] = { "TRACE", "DEBUG", "INFO", "WARN", "ERROR", "OFF" };
+        return names[static_cast<int>(level)];
+    }
+
+    /**
+     * \brief log 를 호출한 위치. 호출 위치마다 static 으로 하나씩 만들어집니다.
+     */
+    struct site_t {
+        level_t level;
+        const char* file;
+        int line;
+        const char* format;
+        // 초당 남길 log 수. 0 이면 제한하지 않는다.
+        uint32_t rate_limit = default_rate_limit;
+
+        std::atomic<uint64_t> window { 0 };
+        std::atomic<uint32_t> count { 0 };
+        std::atomic<uint32_t> suppressed { 0 };
+    };
+
+    namespace detail
+    {
+        enum class arg_type : uint8_t {
+            i64,
+            u64,
+            f64,
+            boolean,
+            pointer,
+            string,
+        };
+
+        struct arg_t {
+            arg_type type;
+            uint8_t len;
+            char s[inline_string_size];
+            union {
+                int64_t i;
+                uint64_t u;
+                double d;
+                const void* p;
+            };
+        };
+
+        struct record_t {
+            const site_t* site;
+            uint64_t ticks;
+            uint32_t thread;
+            uint32_t suppressed;
+            uint8_t arg_count;
+            arg_t args[max_args];
+        };
+
+        inline void set_string(arg_t& a, const std::string_view v) {
+            a.type = arg_type::string;
+            a.len = static_cast<uint8_t>(std::min(v.size(), inline_string_size));
+            std::memcpy(a.s, v.data(), a.len);
+        }
+
+        template <typename T>
+        void capture(arg_t& a, const T& v) {
+            using U = std::decay_t<T>;
+            if constexpr (std::is_same_v<U, bool>) {
+                a.type = arg_type::boolean;
+                a.u = v;
+            }
+            else if constexpr (std::is_enum_v<U>) {
+                a.type = arg_type::i64;
+                a.i = static_cast<int64_t>(v);
+            }
+            else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>) {
+                a.type = arg_type::i64;
+                a.i = v;
+            }
+            else if constexpr (std::is_integral_v<U>) {
+                a.type = arg_type::u64;
+                a.u = v;
+            }
+            else if constexpr (std::is_floating_point_v<U>) {
+                a.type = arg_type::f64;
+                a.d = v;
+            }
+            else if constexpr (std::is_convertible_v<const U&, std::string_view>) {
+                set_string(a, std::string_view(v));
+            }
+            else if constexpr (std::is_pointer_v<U>) {
+                a.type = arg_type::pointer;
+                a.p = static_cast<const void*>(v);
+            }
+            else {
+                static_assert(std::is_void_v<U>, "yc_log: unsupported argument type");
+            }
+        }
+
+        // 호출한 thread 하나가 쓰고 background thread 가 읽는 buffer.
+        struct producer_t {
+            yc_lf::spsc_ring<record_t> ring { ring_capacity };
+            uint32_t thread;
+            std::atomic<uint64_t> pushed { 0 };
+            std::atomic<uint64_t> popped { 0 };
+            std::atomic<uint64_t> dropped { 0 };
+            // thread 가 끝났고 ring 을 다 비웠으면 지운다.
+            std::atomic<bool> closed { false };
+
+            explicit producer_t(const uint32_t thread) : thread(thread) { }
+        };
+
+        inline void append_arg(std::string& out, const arg_t& a) {
+            char buf[32];
+            switch (a.type) {
+            case arg_type::i64: out += std::to_string(a.i); break;
+            case arg_type::u64: out += std::to_string(a.u); break;
+            case arg_type::f64:
+                std::snprintf(buf, sizeof(buf), "%g", a.d);
+                out += buf;
+                break;
+            case arg_type::boolean: out += a.u ? "true" : "false"; break;
+            case arg_type::pointer:
+                std::snprintf(buf, sizeof(buf), "%p", a.p);
+                out += buf;
+                break;
+            case arg_type::string: out.append(a.s, a.len); break;
+            }
+        }
+
+        /**
+         * \brief format 의 {} 를 순서대로 인자로 바꿉니다. {{ 와 }} 는 { 와 } 가 됩니다.
+         * 인자가 모자라면 남은 {} 를 그대로 두어 잘못된 호출이 log 에 드러나게 합니다. 남는 인자는 무시합니다.
+         */
+        inline void format_to(std::string& out, const char* format, const arg_t* args, const size_t count) {
+            size_t next = 0;
+            for (const char* p = format; *p; ++p) {
+                if (p[0] == '{' && p[1] == '{') {
+                    out += '{';
+                    ++p;
+                }
+                else if (p[0] == '}' && p[1] == '}') {
+                    out += '}';
+                    ++p;
+                }
+                else if (p[0] == '{' && p[1] == '}') {
+                    if (next < count) append_arg(out, args[next++]);
+                    else out += "{}";
+                    ++p;
+                }
+                else {
+                    out += *p;
+                }
+            }
+        }
+
+        class logger_t {
+            std::mutex mutex_;
+            std::vector<std::shared_ptr<producer_t>> producers_;
+            uint32_t next_thread_ = 0;
+            using sink_t = std::function<void(level_t, std::string_view)>;
+            // drain 이 lock 밖에서 쓰므로 바꿀 때는 통째로 교체한다.
+            std::shared_ptr<const sink_t> sink_;
+            std::thread thread_;
+            std::atomic<bool> started_ { false };
+            // 끝난 drain 횟수. flush 가 버린 record 알림까지 출력되었는지 확인할 때 쓴다.
+            std::atomic<uint64_t> drain_passes_ { 0 };
+            // background thread 만 쓰는 buffer. 1ms 마다 도는 drain 이 한가할 때 할당하지 않도록 재사용한다.
+            std::vector<std::shared_ptr<producer_t>> drain_producers_;
+            std::string drain_line_;
+            // rate limit 의 1초를 tick 으로. background thread 가 yc_clock 으로 보정한다.
+            std::atomic<uint64_t> ticks_per_second_ { 3'000'000'000ull };
+
+            static void write_line(const sink_t& sink, const record_t& r, std::string& line) {
+                const double ms = static_cast<double>(r.ticks - yc_clock::origin.ticks) * yc_clock::ns_per_tick() / 1e6;
+                char head[96];
+                std::snprintf(head, sizeof(head), "[%.3f][%s][%u] %s:%d ", ms, level_name(r.site->level), r.thread,
+                              r.site->file, r.site->line);
+                line.assign(head);
+                format_to(line, r.site->format, r.args, r.arg_count);
+                if (r.suppressed) line += " (" + std::to_string(r.suppressed) + " suppressed)";
+                sink(r.site->level, line);
+            }
+
+            // 한바퀴 돌며 모든 ring 을 비운다. 처리한 record 수를 반환한다.
+            size_t drain() {
+                auto& producers = drain_producers_;
+                auto& line = drain_line_;
+                std::shared_ptr<const sink_t> sink;
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    producers.assign(producers_.begin(), producers_.end());
+                    sink = sink_;
+                }
+                size_t n = 0;
+                for (auto& p : producers) {
+                    while (const record_t* r = p->ring.front()) {
+                        write_line(*sink, *r, line);
+                        p->ring.pop_front();
+                        p->popped.fetch_add(1, std::memory_order_release);
+                        ++n;
+                    }
+                    if (const uint64_t dropped = p->dropped.exchange(0, std::memory_order_relaxed)) {
+                        (*sink)(level_t::warn, "[yc_log] thread " + std::to_string(p->thread) + " dropped " + std::to_string(dropped) + " records");
+                    }
+                }
+                // capacity 는 남기고, 끝난 thread 의 producer 를 붙잡지 않도록 참조만 놓는다.
+                producers.clear();
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    std::erase_if(producers_, [](const auto& p) {
+                        return p->closed.load(std::memory_order_acquire) && p->ring.empty();
+                    });
+                }
+                drain_passes_.fetch_add(1, std::memory_order_release);
+                return n;
+            }
+
+            void run() {
+                while (true) {
+                    if (drain() == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    ticks_per_second_.store(static_cast<uint64_t>(1e9 / yc_clock::ns_per_tick()), std::memory_order_relaxed);
+                }
+            }
+
+        public:
+            logger_t() : sink_(std::make_shared<const sink_t>([](level_t, const std::string_view line) {
+                std::fwrite(line.data(), 1, line.size(), stderr);
+                std::fputc('\n', stderr);
+            })) { }
+
+            static logger_t& instance() {
+                static auto* logger = new logger_t();
+                return *logger;
+            }
+
+            std::shared_ptr<producer_t> add_producer() {
+                if (!started_.exchange(true)) {
+                    // logger 는 프로그램이 끝날 때까지 살아있으므로 thread 도 끝나지 않는다.
+                    thread_ = std::thread([this] { run(); });
+                    thread_.detach();
+                }
+                std::lock_guard<std::mutex> lock(mutex_);
+                producers_.push_back(std::make_shared<producer_t>(next_thread_++));
+                return producers_.back();
+            }
+
+            void set_sink(sink_t sink) {
+                auto next = std::make_shared<const sink_t>(std::move(sink));
+                std::lock_guard<std::mutex> lock(mutex_);
+                sink_ = std::move(next);
+            }
+
+            uint64_t ticks_per_second() const { return ticks_per_second_.load(std::memory_order_relaxed); }
+
+            /**
+             * \brief 지금까지 들어온 record 와 버린 record 알림이 모두 출력될 때까지 기다립니다.
+             * [*** 중요! ***] sink 안에서 호출하면 안 됩니다.
+             */
+            void flush() {
+                std::vector<std::pair<std::shared_ptr<producer_t>, uint64_t>> targets;
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    for (auto& p : producers_) targets.emplace_back(p, p->pushed.load(std::memory_order_acquire));
+                }
+                for (auto& [p, pushed] : targets) {
+                    while (p->popped.load(std::memory_order_acquire) < pushed) std::this_thread::yield();
+                }
+                if (!started_.load(std::memory_order_acquire)) return;
+                // 버린 수는 ring 을 비운 뒤에 알린다. 진행 중인 drain 은 그 수를 이미 읽었을 수 있으므로
+                // 지금 이후에 시작한 drain 이 끝날 때까지, 즉 두번 더 끝날 때까지 기다린다.
+                const uint64_t pass = drain_passes_.load(std::memory_order_acquire);
+                while (drain_passes_.load(std::memory_order_acquire) < pass + 2) std::this_thread::yield();
+            }
+        };
+
+        struct producer_holder_t {
+            std::shared_ptr<producer_t> producer = logger_t::instance().add_producer();
+            ~producer_holder_t() { producer->closed.store(true, std::memory_order_release); }
+        };
+
+        inline producer_t& local_producer() {
+            thread_local producer_holder_t holder;
+            return *holder.producer;
+        }
+
+        // 이번 1초 window 에 남길 수 있으면 true. 새 window 가 시작되면 지난 window 에서 생략한 수를 suppressed 로 돌려준다.
+        inline bool allow(site_t& site, const uint64_t ticks, uint32_t& suppressed) {
+            suppressed = 0;
+            if (site.rate_limit == 0) return true;
+            const uint64_t w = ticks / logger_t::instance().ticks_per_second();
+            uint64_t current = site.window.load(std::memory_order_relaxed);
+            if (w != current && site.window.compare_exchange_strong(current, w, std::memory_order_relaxed)) {
+                site.count.store(0, std::memory_order_relaxed);
+                suppressed = site.suppressed.exchange(0, std::memory_order_relaxed);
+            }
+            if (site.count.load(std::memory_order_relaxed) < site.rate_limit &&
+                site.count.fetch_add(1, std::memory_order_relaxed) < site.rate_limit) return true;
+            site.suppressed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+
+    /**
+     * \brief 인자를 복사해 현재 thread 의 buffer 에 넣습니다. 보통 YC_LOG_* macro 로 호출합니다.
+     * buffer 가 가득 차 있으면 버리고 버린 수를 나중에 알립니다.
+     */
+    template <typename... Args>
+    void write(site_t& site, const Args&... args) {
+        static_assert(sizeof...(Args) <= max_args, "yc_log: too many arguments");
+        const uint64_t ticks = yc_clock::now_ticks();
+        uint32_t suppressed;
+        if (!detail::allow(site, ticks, suppressed)) return;
+
+        auto& p = detail::local_producer();
+        detail::record_t r;
+        r.site = &site;
+        r.ticks = ticks;
+        r.thread = p.thread;
+        r.suppressed = suppressed;
+        r.arg_count = static_cast<uint8_t>(sizeof...(Args));
+        size_t i = 0;
+        (detail::capture(r.args[i++], args), ...);
+        if (p.ring.try_push(r)) p.pushed.fetch_add(1, std::memory_order_release);
+        else p.dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief 출력 방법을 바꿉니다. 기본은 stderr 입니다. background thread 에서 호출됩니다.
+     */
+    inline void set_sink(std::function<void(level_t, std::string_view)> sink) {
+        detail::logger_t::instance().set_sink(std::move(sink));
+    }
+
+    inline void flush() {
+        detail::logger_t::instance().flush();
+    }
+}
+
+/**
+ * \brief 초당 rate_limit 개까지만 남기는 log. rate_limit 이 0 이면 제한하지 않습니다.
+ */
+#define YC_LOG_RATE(level, rate_limit, format, ...) \
+do { \
+    if constexpr (static_cast<int>(level) >= YC_LOG_LEVEL) { \
+        static yc_log::site_t yc_log_site_ { level, __FILE__, __LINE__, format, rate_limit }; \
+        yc_log::write(yc_log_site_ __VA_OPT__(,) __VA_ARGS__); \
+    } \
+} while (0)
+
+#define YC_LOG(level, format, ...) YC_LOG_RATE(level, yc_log::default_rate_limit, format __VA_OPT__(,) __VA_ARGS__)
+#define YC_LOG_TRACE(format, ...) YC_LOG(yc_log::level_t::trace, format __VA_OPT__(,) __VA_ARGS__)
+#define YC_LOG_DEBUG(format, ...) YC_LOG(yc_log::level_t::debug, format __VA_OPT__(,) __VA_ARGS__)
+#define YC_LOG_INFO(format, ...) YC_LOG(yc_log::level_t::info, format __VA_OPT__(,) __VA_ARGS__)
+#define YC_LOG_WARN(format, ...) YC_LOG(yc_log::level_t::warn, format __VA_OPT__(,) __VA_ARGS__)
+#define YC_LOG_ERROR(format, ...) YC_LOG(yc_log::level_t::error, format __VA_OPT__(,) __VA_ARGS__)
@@ -0,0 +1,477 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "yc_clock.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+/**
+ * \brief counter / gauge / latency histogram registry.
+ * 기록(add, record)은 lock 이 없고, lock 은 metric 을 처음 등록할 때와 export 할 때만 잡습니다.
+ * 등록한 metric 의 참조는 프로그램이 끝날 때까지 유효하므로 함수 안의 static 참조로 잡아두고 사용합니다.
+ *     static auto& resend = yc_metrics::counter("yc_rudp_resend_total", "재전송한 패킷 수");
+ *     resend.add();
+ * export 는 Prometheus text format 입니다. (save: textfile collector 용 파일, unix_socket_exporter_t: UNIX socket)
+ * YC_METRICS_DISABLED 를 정의하면 hook 으로 들어간 YC_METRICS(...) 구문이 사라집니다.
+ */
+namespace yc_metrics
+{
+    constexpr size_t counter_shards = 16;
+    constexpr size_t histogram_shards = 4;
+
+    namespace detail
+    {
+        // thread 마다 고정된 shard 번호. 같은 thread 의 기록은 항상 같은 cache line 으로 간다.
+        inline size_t shard_index() {
+            static std::atomic<size_t> next { 0 };
+            thread_local const size_t index = next.fetch_add(1, std::memory_order_relaxed);
+            return index;
+        }
+
+        /**
+         * \brief path 옆에 겹치지 않는 이름의 빈 임시 파일을 만듭니다. 여러 process 가 같은 path 에 save 해도 서로의 임시 파일을 덮지 않습니다.
+         * \return 만든 파일의 경로. 실패하면 빈 문자열
+         */
+        inline std::string create_temp_file(const std::string& path) {
+#if defined(__unix__) || defined(__APPLE__)
+            std::string tmp = path + ".XXXXXX";
+            const int fd = mkstemp(tmp.data());
+            if (fd < 0) return {};
+            // mkstemp 는 0600 으로 만든다. textfile collector 가 다른 사용자로 돌아도 읽을 수 있게 한다.
+            fchmod(fd, 0644);
+            ::close(fd);
+            return tmp;
+#else
+            std::random_device rd;
+            for (int attempt = 0; attempt < 16; ++attempt) {
+                std::string tmp = path + "." + std::to_string(rd()) + ".tmp";
+                if (std::ifstream(tmp)) continue;
+                if (std::ofstream(tmp)) return tmp;
+            }
+            return {};
+#endif
+        }
+    }
+
+    /**
+     * \brief 단조 증가하는 counter. thread 마다 다른 cache line 에 더하고 읽을 때 합칩니다.
+     */
+    class counter_t {
+        struct alignas(64) cell_t {
+            std::atomic<uint64_t> value { 0 };
+        };
+        std::array<cell_t, counter_shards> cells_;
+
+    public:
+        void add(const uint64_t n = 1) {
+            cells_[detail::shard_index() % counter_shards].value.fetch_add(n, std::memory_order_relaxed);
+        }
+
+        uint64_t value() const {
+            uint64_t sum = 0;
+            for (auto& c : cells_) sum += c.value.load(std::memory_order_relaxed);
+            return sum;
+        }
+    };
+
+    /**
+     * \brief 현재 값을 나타내는 gauge. (queue 깊이 등)
+     */
+    class gauge_t {
+        std::atomic<int64_t> value_ { 0 };
+
+    public:
+        void set(const int64_t v) { value_.store(v, std::memory_order_relaxed); }
+        void add(const int64_t n) { value_.fetch_add(n, std::memory_order_relaxed); }
+        int64_t value() const { return value_.load(std::memory_order_relaxed); }
+    };
+
+    /**
+     * \brief HDR 방식의 log-linear histogram.
+     * 2의 거듭제곱 구간마다 16개의 bucket 으로 나누므로 0 ~ 2^64 전체를 상대 오차 1/16 이내로 기록합니다.
+     * 기록은 relaxed fetch_add 두번이며, thread 들은 histogram_shards 개의 shard 에 나눠 기록합니다.
+     */
+    class histogram_t {
+    public:
+        static constexpr int sub_bucket_bits = 4;
+        static constexpr size_t sub_bucket_count = size_t{1} << sub_bucket_bits;
+        static constexpr size_t bucket_count = sub_bucket_count + (64 - sub_bucket_bits) * sub_bucket_count;
+
+        static constexpr size_t bucket_of(const uint64_t v) {
+            if (v < sub_bucket_count) return static_cast<size_t>(v);
+            const int exp = std::bit_width(v) - 1;
+            const size_t sub = static_cast<size_t>(v >> (exp - sub_bucket_bits)) - sub_bucket_count;
+            return sub_bucket_count + static_cast<size_t>(exp - sub_bucket_bits) * sub_bucket_count + sub;
+        }
+
+        /**
+         * \brief bucket 에 들어가는 가장 큰 값.
+         * 2^53 이 넘는 값은 double 로 정확히 나타낼 수 없어 이웃 bucket 과 같아지므로 정수로 계산합니다.
+         */
+        static constexpr uint64_t bucket_upper(const size_t b) {
+            if (b < sub_bucket_count) return b;
+            const size_t exp = (b - sub_bucket_count) / sub_bucket_count + sub_bucket_bits;
+            const size_t sub = (b - sub_bucket_count) % sub_bucket_count;
+            // 마지막 bucket 은 2^64 - 1 이다. shift 가 2^64 로 넘치면 0 이 되고 1 을 빼면 그 값이 된다.
+            return (static_cast<uint64_t>(sub_bucket_count + sub + 1) << (exp - sub_bucket_bits)) - 1;
+        }
+
+        struct snapshot_t {
+            std::array<uint64_t, bucket_count> buckets {};
+            uint64_t count = 0;
+            uint64_t sum = 0;
+
+            /**
+             * \param q 0 ~ 1
+             * \return q 분위수가 들어있는 bucket 의 가장 큰 값. 기록이 없으면 0
+             */
+            double percentile(const double q) const {
+                if (count == 0) return 0;
+                const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * static_cast<double>(count))));
+                uint64_t seen = 0;
+                for (size_t b = 0; b < bucket_count; ++b) {
+                    seen += buckets[b];
+                    if (seen >= rank) return static_cast<double>(bucket_upper(b));
+                }
+                return static_cast<double>(bucket_upper(bucket_count - 1));
+            }
+        };
+
+    private:
+        struct alignas(64) shard_t {
+            std::atomic<uint64_t> sum { 0 };
+            std::array<std::atomic<uint64_t>, bucket_count> buckets {};
+        };
+        std::unique_ptr<shard_t[]> shards_ { new shard_t[histogram_shards] };
+
+    public:
+        void record(const uint64_t v) {
+            auto& s = shards_[detail::shard_index() % histogram_shards];
+            s.buckets[bucket_of(v)].fetch_add(1, std::memory_order_relaxed);
+            s.sum.fetch_add(v, std::memory_order_relaxed);
+        }
+
+        void record(const std::chrono::nanoseconds d) {
+            record(static_cast<uint64_t>(std::max<int64_t>(0, d.count())));
+        }
+
+        snapshot_t snapshot() const {
+            snapshot_t r;
+            for (size_t i = 0; i < histogram_shards; ++i) {
+                auto& s = shards_[i];
+                r.sum += s.sum.load(std::memory_order_relaxed);
+                for (size_t b = 0; b < bucket_count; ++b) {
+                    const uint64_t n = s.buckets[b].load(std::memory_order_relaxed);
+                    r.buckets[b] += n;
+                    r.count += n;
+                }
+            }
+            return r;
+        }
+    };
+
+    /**
+     * \brief 실행 시간을 yc_clock tick 으로 기록하는 histogram. export 할 때 ns 로 바꿔 내보냅니다.
+     * steady_clock::now 를 두번 부르는 것보다 훨씬 싸므로 packet handler 처럼 짧은 구간에 사용합니다.
+     */
+    class latency_histogram_t : public histogram_t {
+    public:
+        void record_ticks(const uint64_t ticks) { record(ticks); }
+    };
+
+    /**
+     * \brief scope 의 실행 시간을 latency histogram 에 기록합니다.
+     */
+    class scoped_timer_t {
+        latency_histogram_t& histogram_;
+        uint64_t start_;
+
+    public:
+        explicit scoped_timer_t(latency_histogram_t& h) : histogram_(h), start_(yc_clock::now_ticks()) { }
+        ~scoped_timer_t() { histogram_.record_ticks(yc_clock::now_ticks() - start_); }
+        scoped_timer_t(const scoped_timer_t&) = delete;
+        scoped_timer_t& operator=(const scoped_timer_t&) = delete;
+    };
+
+    enum class metric_type {
+        counter,
+        gauge,
+        summary,
+    };
+
+    class registry_t {
+        struct series_t {
+            std::string labels;
+            void* metric;
+            // latency_histogram_t 이면 tick 을 ns 로 바꿔서 내보낸다.
+            bool is_ticks;
+        };
+        struct family_t {
+            metric_type type;
+            std::string help;
+            std::vector<series_t> series;
+        };
+
+        std::mutex mutex_;
+        // 이름순으로 export 한다.
+        std::map<std::string, family_t> families_;
+        // metric 주소가 바뀌지 않도록 deque 에 보관한다.
+        std::deque<counter_t> counters_;
+        std::deque<gauge_t> gauges_;
+        std::deque<histogram_t> histograms_;
+        std::deque<latency_histogram_t> latencies_;
+
+        template <typename Metric>
+        Metric& get_or_add(std::deque<Metric>& storage, const metric_type type, const std::string& name,
+                           const std::string& help, const std::string& labels) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto& family = families_[name];
+            if (family.series.empty()) {
+                family.type = type;
+                family.help = help;
+            }
+            for (auto& s : family.series) {
+                if (s.labels == labels) return *static_cast<Metric*>(s.metric);
+            }
+            auto& m = storage.emplace_back();
+            family.series.push_back(series_t{ labels, static_cast<void*>(&m), std::is_same_v<Metric, latency_histogram_t> });
+            return m;
+        }
+
+    public:
+        static registry_t& instance() {
+            static auto* registry = new registry_t();
+            return *registry;
+        }
+
+        /**
+         * \param labels Prometheus label 목록. ex) lane="tick",id="3"
+         */
+        counter_t& counter(const std::string& name, const std::string& help, const std::string& labels = "") {
+            return get_or_add(counters_, metric_type::counter, name, help, labels);
+        }
+        gauge_t& gauge(const std::string& name, const std::string& help, const std::string& labels = "") {
+            return get_or_add(gauges_, metric_type::gauge, name, help, labels);
+        }
+        histogram_t& histogram(const std::string& name, const std::string& help, const std::string& labels = "") {
+            return get_or_add(histograms_, metric_type::summary, name, help, labels);
+        }
+        /**
+         * \param name 내보내는 단위는 ns 이므로 _ns 로 끝나는 이름을 사용하세요.
+         */
+        latency_histogram_t& latency(const std::string& name, const std::string& help, const std::string& labels = "") {
+            return get_or_add(latencies_, metric_type::summary, name, help, labels);
+        }
+
+        /**
+         * \brief Prometheus text exposition format 으로 씁니다. histogram 은 summary(0.5/0.9/0.99/0.999, sum, count) 로 나갑니다.
+         */
+        void write_prometheus(std::ostream& os) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const double ns_per_tick = yc_clock::ns_per_tick();
+            for (auto& [name, family] : families_) {
+                static constexpr const char* type_names[] = { "counter", "gauge", "summary" };
+                os << "# HELP " << name << " " << family.help << "\n";
+                os << "# TYPE " << name << " " << type_names[static_cast<int>(family.type)] << "\n";
+                for (auto& s : family.series) {
+                    const std::string braced = s.labels.empty() ? "" : "{" + s.labels + "}";
+                    switch (family.type) {
+                    case metric_type::counter:
+                        os << name << braced << " " << static_cast<counter_t*>(s.metric)->value() << "\n";
+                        break;
+                    case metric_type::gauge:
+                        os << name << braced << " " << static_cast<gauge_t*>(s.metric)->value() << "\n";
+                        break;
+                    case metric_type::summary: {
+                        const auto snap = s.is_ticks ? static_cast<latency_histogram_t*>(s.metric)->snapshot()
+                                                     : static_cast<histogram_t*>(s.metric)->snapshot();
+                        const double scale = s.is_ticks ? ns_per_tick : 1.0;
+                        const std::string prefix = s.labels.empty() ? "" : s.labels + ",";
+                        for (const double q : { 0.5, 0.9, 0.99, 0.999 }) {
+                            os << name << "{" << prefix << "quantile=\"" << q << "\"} " << snap.percentile(q) * scale << "\n";
+                        }
+                        os << name << "_sum" << braced << " " << static_cast<double>(snap.sum) * scale << "\n";
+                        os << name << "_count" << braced << " " << snap.count << "\n";
+                        break;
+                    }
+                    }
+                }
+            }
+        }
+
+        std::string to_string() {
+            std::ostringstream os;
+            write_prometheus(os);
+            return os.str();
+        }
+    };
+
+    inline counter_t& counter(const std::string& name, const std::string& help, const std::string& labels = "") {
+        return registry_t::instance().counter(name, help, labels);
+    }
+    inline gauge_t& gauge(const std::string& name, const std::string& help, const std::string& labels = "") {
+        return registry_t::instance().gauge(name, help, labels);
+    }
+    inline histogram_t& histogram(const std::string& name, const std::string& help, const std::string& labels = "") {
+        return registry_t::instance().histogram(name, help, labels);
+    }
+    inline latency_histogram_t& latency(const std::string& name, const std::string& help, const std::string& labels = "") {
+        return registry_t::instance().latency(name, help, labels);
+    }
+
+    /**
+     * \brief packet id 처럼 0 ~ N-1 의 번호마다 하나씩 필요한 metric.
+     * 번호마다 label_key="번호" 로 등록하며, 처음 사용하는 번호만 등록하므로 쓰지 않는 번호는 비용이 없습니다.
+     */
+    template <typename Metric, size_t N>
+    class indexed_t {
+        std::string name_;
+        std::string help_;
+        std::string label_key_;
+        std::array<std::atomic<Metric*>, N> slots_ {};
+
+        Metric& add(const size_t i) {
+            const std::string labels = label_key_ + "=\"" + std::to_string(i) + "\"";
+            Metric* m;
+            if constexpr (std::is_same_v<Metric, counter_t>) m = &registry_t::instance().counter(name_, help_, labels);
+            else if constexpr (std::is_same_v<Metric, gauge_t>) m = &registry_t::instance().gauge(name_, help_, labels);
+            else if constexpr (std::is_same_v<Metric, latency_histogram_t>) m = &registry_t::instance().latency(name_, help_, labels);
+            else m = &registry_t::instance().histogram(name_, help_, labels);
+            // registry 가 같은 label 에 같은 metric 을 돌려주므로 여러 thread 가 동시에 등록해도 결과는 같다.
+            slots_[i].store(m, std::memory_order_release);
+            return *m;
+        }
+
+    public:
+        indexed_t(std::string name, std::string help, std::string label_key)
+            : name_(std::move(name)), help_(std::move(help)), label_key_(std::move(label_key)) { }
+
+        Metric& operator[](const size_t i) {
+            if (Metric* m = slots_[i].load(std::memory_order_acquire)) return *m;
+            return add(i);
+        }
+    };
+
+    /**
+     * \brief 현재 값을 path 에 씁니다. 임시 파일에 쓴 뒤 rename 하므로 읽는 쪽이 반쯤 쓰인 파일을 보지 않습니다.
+     * \return 쓰기에 실패하면 false
+     */
+    inline bool save(const std::string& path) {
+        const std::string tmp = detail::create_temp_file(path);
+        if (tmp.empty()) return false;
+        {
+            std::ofstream f(tmp, std::ios::trunc);
+            if (f) registry_t::instance().write_prometheus(f);
+            f.close();
+            if (!f) {
+                std::remove(tmp.c_str());
+                return false;
+            }
+        }
+        if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+            std::remove(tmp.c_str());
+            return false;
+        }
+        return true;
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    /**
+     * \brief UNIX domain socket 에 연결할 때마다 현재 값을 보내고 연결을 닫습니다.
+     * ex) socat - UNIX-CONNECT:/tmp/yc_metrics.sock
+     */
+    class unix_socket_exporter_t {
+        int fd_ = -1;
+        std::string path_;
+        std::atomic<bool> stop_ { false };
+        std::thread thread_;
+
+        void serve() {
+            while (!stop_.load(std::memory_order_relaxed)) {
+                pollfd p { fd_, POLLIN, 0 };
+                if (::poll(&p, 1, 100) <= 0) continue;
+                const int client = ::accept(fd_, nullptr, nullptr);
+                if (client < 0) continue;
+                const std::string text = registry_t::instance().to_string();
+                size_t sent = 0;
+                while (sent < text.size()) {
+                    const auto n = ::send(client, text.data() + sent, text.size() - sent, 0);
+                    if (n <= 0) break;
+                    sent += static_cast<size_t>(n);
+                }
+                ::close(client);
+            }
+        }
+
+    public:
+        unix_socket_exporter_t() = default;
+        ~unix_socket_exporter_t() { stop(); }
+        unix_socket_exporter_t(const unix_socket_exporter_t&) = delete;
+        unix_socket_exporter_t& operator=(const unix_socket_exporter_t&) = delete;
+
+        /**
+         * \return socket 을 만들지 못하면 false
+         */
+        bool start(const std::string& path) {
+            if (thread_.joinable()) return false;
+            sockaddr_un addr {};
+            if (path.size() >= sizeof(addr.sun_path)) return false;
+            addr.sun_family = AF_UNIX;
+            std::copy(path.begin(), path.end(), addr.sun_path);
+
+            fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd_ < 0) return false;
+            ::unlink(path.c_str());
+            if (::bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(fd_, 4) != 0) {
+                ::close(fd_);
+                fd_ = -1;
+                return false;
+            }
+            path_ = path;
+            stop_.store(false, std::memory_order_relaxed);
+            thread_ = std::thread([this] { serve(); });
+            return true;
+        }
+
+        void stop() {
+            if (!thread_.joinable()) return;
+            stop_.store(true, std::memory_order_relaxed);
+            thread_.join();
+            ::close(fd_);
+            ::unlink(path_.c_str());
+            fd_ = -1;
+        }
+    };
+#endif
+}
+
+#ifndef YC_METRICS_DISABLED
+#define YC_METRICS(...) __VA_ARGS__
+#else
+#define YC_METRICS(...)
+#endif
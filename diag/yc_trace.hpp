@@ -0,0 +1,216 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "yc_clock.hpp"
+
+/**
+ * \brief 구간(zone) 단위 tracing.
+ * YC_TRACE_ZONE("name") 을 scope 안에 두면 scope 의 시작 / 끝 시각이 현재 thread 의 ring buffer 에 기록됩니다.
+ * YC_TRACE_ENABLED 가 정의되지 않으면 아무 코드도 만들지 않습니다.
+ * 기록된 구간은 write_chrome_json / save 로 chrome://tracing, Perfetto 에서 열 수 있는 json 으로 내보냅니다.
+ */
+namespace yc_trace
+{
+#ifndef YC_TRACE_BUFFER_EVENTS
+    // thread 하나가 보관하는 최근 event 수. 2의 거듭제곱이어야 한다.
+    constexpr size_t buffer_events = 1 << 16;
+#else
+    constexpr size_t buffer_events = YC_TRACE_BUFFER_EVENTS;
+#endif
+    static_assert((buffer_events & (buffer_events - 1)) == 0, "YC_TRACE_BUFFER_EVENTS must be a power of two");
+
+    namespace detail
+    {
+        // 기록 중에 export 해도 data race 가 되지 않도록 필드는 relaxed atomic 으로 둔다. x86 에서는 일반 store 와 같다.
+        struct event_t {
+            std::atomic<const char*> name { nullptr };
+            std::atomic<uint64_t> begin { 0 };
+            std::atomic<uint64_t> end { 0 };
+        };
+
+        /**
+         * \brief thread 하나가 쓰고 exporter 가 읽는 ring buffer. 가득 차면 오래된 event 부터 덮어씁니다.
+         */
+        struct thread_buffer_t {
+            alignas(64) std::atomic<uint64_t> head { 0 };
+            uint32_t tid;
+            std::string name;
+            std::unique_ptr<event_t[]> events { new event_t[buffer_events] };
+
+            explicit thread_buffer_t(const uint32_t tid) : tid(tid), name("thread " + std::to_string(tid)) { }
+
+            void record(const char* zone, const uint64_t begin, const uint64_t end) {
+                const uint64_t h = head.load(std::memory_order_relaxed);
+                auto& e = events[h & (buffer_events - 1)];
+                // seq_lock::publish 와 같은 fence. exporter 가 아래에서 덮어쓴 값을 읽었다면
+                // 그 뒤 acquire fence 후에 읽는 head 는 h 이상이므로 이 자리를 버린다.
+                std::atomic_thread_fence(std::memory_order_release);
+                e.name.store(zone, std::memory_order_relaxed);
+                e.begin.store(begin, std::memory_order_relaxed);
+                e.end.store(end, std::memory_order_relaxed);
+                head.store(h + 1, std::memory_order_release);
+            }
+        };
+
+        // thread 가 끝나도 기록은 export 때까지 남아야 하므로 buffer 는 registry 가 소유한다.
+        struct registry_t {
+            std::mutex mutex;
+            std::vector<std::unique_ptr<thread_buffer_t>> buffers;
+
+            static registry_t& instance() {
+                static auto* registry = new registry_t();
+                return *registry;
+            }
+
+            thread_buffer_t* add() {
+                std::lock_guard<std::mutex> lock(mutex);
+                buffers.push_back(std::make_unique<thread_buffer_t>(static_cast<uint32_t>(buffers.size())));
+                return buffers.back().get();
+            }
+        };
+
+        inline thread_buffer_t& local_buffer() {
+            thread_local thread_buffer_t* buffer = registry_t::instance().add();
+            return *buffer;
+        }
+
+        /**
+         * \brief s 를 json 문자열 안에 넣을 수 있게 씁니다. ", \ 와 제어 문자를 escape 합니다.
+         */
+        inline void write_json_string(std::ostream& os, const std::string_view s) {
+            for (const char ch : s) {
+                switch (ch) {
+                case '"': os << "\\\""; break;
+                case '\\': os << "\\\\"; break;
+                case '\n': os << "\\n"; break;
+                case '\r': os << "\\r"; break;
+                case '\t': os << "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(ch) < 0x20) {
+                        static constexpr char hex[] = "0123456789abcdef";
+                        os << "\\u00" << hex[ch >> 4] << hex[ch & 0xf];
+                    }
+                    else os << ch;
+                }
+            }
+        }
+    }
+
+    /**
+     * \brief 생성부터 소멸까지를 하나의 구간으로 기록합니다. 보통 YC_TRACE_ZONE 으로 사용합니다.
+     * \param name 구간 이름. 문자열 literal 처럼 프로그램이 끝날 때까지 살아있어야 합니다.
+     */
+    class zone_t {
+        const char* name_;
+        uint64_t begin_;
+
+    public:
+        explicit zone_t(const char* name) : name_(name), begin_(yc_clock::now_ticks()) { }
+        ~zone_t() { detail::local_buffer().record(name_, begin_, yc_clock::now_ticks()); }
+        zone_t(const zone_t&) = delete;
+        zone_t& operator=(const zone_t&) = delete;
+    };
+
+    /**
+     * \brief trace viewer 에 표시될 현재 thread 의 이름을 정합니다.
+     */
+    inline void set_thread_name(std::string name) {
+        auto& r = detail::registry_t::instance();
+        auto& b = detail::local_buffer();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        b.name = std::move(name);
+    }
+
+    /**
+     * \brief 기록된 구간을 Chrome trace event format(json) 으로 씁니다.
+     * 기록 중에 호출해도 되지만, 읽는 동안 덮어써진 event 는 버립니다.
+     */
+    inline void write_chrome_json(std::ostream& os) {
+        auto& r = detail::registry_t::instance();
+        std::lock_guard<std::mutex> lock(r.mutex);
+
+        const uint64_t origin = yc_clock::origin.ticks;
+        const double us_per_tick = yc_clock::ns_per_tick() / 1000.0;
+
+        const auto flags = os.flags();
+        const auto precision = os.precision();
+        // ts, dur 는 us 단위. 긴 trace 에서도 ns 해상도를 잃지 않도록 고정 소수점으로 쓴다.
+        os << std::fixed << std::setprecision(3);
+        os << "{\"traceEvents\":[\n";
+        bool first = true;
+        auto separator = [&] {
+            if (!first) os << ",\n";
+            first = false;
+        };
+        for (auto& b : r.buffers) {
+            separator();
+            os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << b->tid
+               << ",\"args\":{\"name\":\"";
+            detail::write_json_string(os, b->name);
+            os << "\"}}";
+
+            const uint64_t head = b->head.load(std::memory_order_acquire);
+            const uint64_t start = head > buffer_events ? head - buffer_events : 0;
+            for (uint64_t i = start; i < head; ++i) {
+                const auto& e = b->events[i & (buffer_events - 1)];
+                const char* name = e.name.load(std::memory_order_relaxed);
+                const uint64_t begin = e.begin.load(std::memory_order_relaxed);
+                const uint64_t end = e.end.load(std::memory_order_relaxed);
+                // 읽는 사이 writer 가 한바퀴 돌아 이 자리를 쓰기 시작했다면 버린다. (seq_lock 과 같은 fence)
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (b->head.load(std::memory_order_relaxed) - i >= buffer_events) continue;
+                if (name == nullptr || begin < origin) continue;
+                separator();
+                os << "{\"name\":\"";
+                detail::write_json_string(os, name);
+                os << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << b->tid
+                   << ",\"ts\":" << static_cast<double>(begin - origin) * us_per_tick
+                   << ",\"dur\":" << static_cast<double>(end - begin) * us_per_tick << "}";
+            }
+        }
+        os << "\n]}\n";
+        os.flags(flags);
+        os.precision(precision);
+    }
+
+    /**
+     * \return 파일을 열지 못하면 false
+     */
+    inline bool save(const std::string& path) {
+        std::ofstream f(path);
+        if (!f) return false;
+        write_chrome_json(f);
+        return static_cast<bool>(f);
+    }
+
+    /**
+     * \brief 모든 thread 의 기록을 지웁니다. 다른 thread 가 기록 중이 아닐 때 호출해야 합니다.
+     */
+    inline void clear() {
+        auto& r = detail::registry_t::instance();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (auto& b : r.buffers) {
+            for (size_t i = 0; i < buffer_events; ++i) b->events[i].name.store(nullptr, std::memory_order_relaxed);
+            b->head.store(0, std::memory_order_release);
+        }
+    }
+}
+
+#define YC_TRACE_CONCAT_IMPL(a, b) a##b
+#define YC_TRACE_CONCAT(a, b) YC_TRACE_CONCAT_IMPL(a, b)
+
+#ifdef YC_TRACE_ENABLED
+#define YC_TRACE_ZONE(name) const yc_trace::zone_t YC_TRACE_CONCAT(yc_trace_zone_, __LINE__)(name)
+#else
+#define YC_TRACE_ZONE(name) ((void)0)
+#endif
@@ -0,0 +1,238 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "yc_math.hpp"
+#include "../container/yc_flat_map.hpp"
+
+namespace yc_physics
+{
+	struct aabb_t {
+		yc_math::vec3_t min;
+		yc_math::vec3_t max;
+
+		[[nodiscard]] bool overlaps(const aabb_t& other) const {
+			return min.x <= other.max.x && other.min.x <= max.x &&
+				min.y <= other.max.y && other.min.y <= max.y &&
+				min.z <= other.max.z && other.min.z <= max.z;
+		}
+	};
+
+	/**
+	 * \brief uniform grid broadphase. x, y 평면을 cell_size 격자로 나누고 AABB 가 걸친 cell 마다 proxy 를 넣습니다.
+	 * 높이(z) 는 나누지 않고 후보 pair 의 AABB 검사에서만 봅니다. 지형 위를 걷는 body 들은 대부분 x, y 로 퍼지기 때문입니다.
+	 * update 는 걸친 cell 범위가 바뀔 때만 cell 을 옮기므로 cell 안에서 움직이는 body 는 AABB 만 갱신합니다.
+	 * cell 은 hash map 에 있어 world 크기에 제한이 없고, 비어도 지우지 않아 다시 들어올 때 할당하지 않습니다.
+	 * max_cells_per_proxy 보다 많은 cell 에 걸치는 큰 AABB 는 cell 대신 overflow 목록에 넣고 모든 proxy 와 직접 비교합니다.
+	 * 좌표에 NaN / inf 가 있는 AABB 는 어디에도 넣지 않으므로 pair 나 query 결과에 나오지 않습니다.
+	 * [*** 중요! ***] cell_size 는 body 크기보다 약간 크게 잡습니다. 너무 작으면 body 하나가 많은 cell 에 들어가고, 너무 크면 cell 안의 후보가 늘어납니다.
+	 *
+	 * grid.update(id, box);
+	 * grid.for_each_pair([](uint32_t a, uint32_t b) { ... });
+	 */
+	class spatial_hash_grid_t {
+	public:
+		using proxy_id_t = uint32_t;
+		// 이보다 많은 cell 에 걸치는 AABB 는 overflow 목록에 들어간다.
+		static constexpr int64_t max_cells_per_proxy = 256;
+
+	private:
+		// proxy 가 들어있는 곳.
+		enum class placement_t : uint8_t {
+			cells,
+			overflow,
+			// NaN / inf 좌표. 어떤 검사에도 나오지 않는다.
+			none,
+		};
+		struct cell_range_t {
+			int32_t x0, y0, x1, y1;
+			placement_t placement;
+			bool operator==(const cell_range_t&) const = default;
+		};
+		struct proxy_t {
+			aabb_t box;
+			cell_range_t cells;
+		};
+
+		double cell_size_;
+		double inv_cell_size_;
+		std::vector<proxy_t> proxies;
+		yc::flat_hash_map<uint64_t, std::vector<proxy_id_t>> cells;
+		std::vector<proxy_id_t> overflow;
+
+		[[nodiscard]] int32_t cell_coord(const double v) const {
+			// 아주 먼 좌표도 int 범위 안의 cell 로 보낸다. NaN / inf 는 cells_of 에서 먼저 걸러진다.
+			constexpr double limit = 1 << 30;
+			const double c = std::floor(v * inv_cell_size_);
+			if (!(c > -limit)) return -(1 << 30);
+			if (!(c < limit)) return 1 << 30;
+			return static_cast<int32_t>(c);
+		}
+		static bool is_finite(const aabb_t& box) {
+			return std::isfinite(box.min.x) && std::isfinite(box.min.y) && std::isfinite(box.min.z) &&
+				std::isfinite(box.max.x) && std::isfinite(box.max.y) && std::isfinite(box.max.z);
+		}
+		[[nodiscard]] cell_range_t cells_of(const aabb_t& box) const {
+			if (!is_finite(box)) return { 0, 0, -1, -1, placement_t::none };
+			const cell_range_t range { cell_coord(box.min.x), cell_coord(box.min.y), cell_coord(box.max.x), cell_coord(box.max.y), placement_t::cells };
+			const int64_t w = static_cast<int64_t>(range.x1) - range.x0 + 1;
+			const int64_t h = static_cast<int64_t>(range.y1) - range.y0 + 1;
+			if (w > max_cells_per_proxy || h > max_cells_per_proxy || w * h > max_cells_per_proxy) {
+				return { 0, 0, -1, -1, placement_t::overflow };
+			}
+			return range;
+		}
+		static uint64_t cell_key(const int32_t x, const int32_t y) {
+			return static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32 | static_cast<uint32_t>(y);
+		}
+
+		void insert_cells(const proxy_id_t id, const cell_range_t& range) {
+			if (range.placement == placement_t::overflow) overflow.push_back(id);
+			for (int32_t y = range.y0; y <= range.y1; ++y)
+				for (int32_t x = range.x0; x <= range.x1; ++x) cells[cell_key(x, y)].push_back(id);
+		}
+		static void erase_id(std::vector<proxy_id_t>& bucket, const proxy_id_t id) {
+			const auto it = std::find(bucket.begin(), bucket.end(), id);
+			if (it == bucket.end()) return;
+			*it = bucket.back();
+			bucket.pop_back();
+		}
+		void erase_cells(const proxy_id_t id, const cell_range_t& range) {
+			if (range.placement == placement_t::overflow) erase_id(overflow, id);
+			for (int32_t y = range.y0; y <= range.y1; ++y) {
+				for (int32_t x = range.x0; x <= range.x1; ++x) {
+					if (auto* bucket = cells.get(cell_key(x, y))) erase_id(*bucket, id);
+				}
+			}
+		}
+		// 들어있는 곳은 그대로 두고 id 만 바꾼다.
+		void rename_cells(const proxy_id_t from, const proxy_id_t to, const cell_range_t& range) {
+			auto rename = [&](std::vector<proxy_id_t>& bucket) {
+				const auto it = std::find(bucket.begin(), bucket.end(), from);
+				if (it != bucket.end()) *it = to;
+			};
+			if (range.placement == placement_t::overflow) rename(overflow);
+			for (int32_t y = range.y0; y <= range.y1; ++y) {
+				for (int32_t x = range.x0; x <= range.x1; ++x) {
+					if (auto* bucket = cells.get(cell_key(x, y))) rename(*bucket);
+				}
+			}
+		}
+
+		// 두 범위가 함께 걸친 cell 중 가장 작은 cell 에서만 true. 여러 cell 을 공유해도 한번만 보고하기 위해 쓴다.
+		static bool is_first_shared_cell(const cell_range_t& a, const cell_range_t& b, const int32_t x, const int32_t y) {
+			return x == std::max(a.x0, b.x0) && y == std::max(a.y0, b.y0);
+		}
+
+	public:
+		explicit spatial_hash_grid_t(const double cell_size = 4.0)
+			: cell_size_(cell_size), inv_cell_size_(1.0 / cell_size) { }
+
+		[[nodiscard]] double cell_size() const { return cell_size_; }
+		[[nodiscard]] size_t size() const { return proxies.size(); }
+		[[nodiscard]] const aabb_t& get_aabb(const proxy_id_t id) const { return proxies[id].box; }
+
+		/**
+		 * \brief proxy 를 추가합니다. id 는 0부터 추가한 순서대로 붙습니다.
+		 */
+		proxy_id_t add(const aabb_t& box) {
+			const auto id = static_cast<proxy_id_t>(proxies.size());
+			const auto range = cells_of(box);
+			proxies.push_back({ box, range });
+			insert_cells(id, range);
+			return id;
+		}
+
+		/**
+		 * \brief proxy 의 AABB 를 바꿉니다. 걸친 cell 범위가 그대로면 cell 은 건드리지 않습니다.
+		 */
+		void update(const proxy_id_t id, const aabb_t& box) {
+			auto& proxy = proxies[id];
+			proxy.box = box;
+			const auto range = cells_of(box);
+			if (range == proxy.cells) return;
+			erase_cells(id, proxy.cells);
+			insert_cells(id, range);
+			proxy.cells = range;
+		}
+
+		/**
+		 * \brief proxy 를 지웁니다. 마지막 proxy 가 id 자리로 옮겨지므로, 지우기 전 마지막 id 는 더이상 쓰지 않습니다.
+		 * id 를 다른 배열의 index 로 쓰고 있다면 그 배열도 같은 방식(마지막 원소를 옮겨오기)으로 지워야 합니다.
+		 */
+		void remove(const proxy_id_t id) {
+			erase_cells(id, proxies[id].cells);
+			const auto last = static_cast<proxy_id_t>(proxies.size() - 1);
+			if (id != last) {
+				rename_cells(last, id, proxies[last].cells);
+				proxies[id] = proxies[last];
+			}
+			proxies.pop_back();
+		}
+
+		/**
+		 * \brief AABB 가 겹치는 proxy 쌍마다 f(a, b) 를 한번씩 부릅니다. 항상 a < b 입니다.
+		 * [*** 중요! ***] f 안에서 add / update / remove 를 부르면 안 됩니다.
+		 */
+		template <typename F>
+		void for_each_pair(F&& f) const {
+			// overflow proxy 는 다른 모든 proxy 와 비교한다. 둘 다 overflow 이면 작은 id 쪽에서 한번만 본다.
+			for (const proxy_id_t o : overflow) {
+				const auto& po = proxies[o];
+				for (proxy_id_t b = 0; b < proxies.size(); ++b) {
+					const auto& pb = proxies[b];
+					if (b == o || pb.cells.placement == placement_t::none) continue;
+					if (pb.cells.placement == placement_t::overflow && b < o) continue;
+					if (po.box.overlaps(pb.box)) f(std::min(o, b), std::max(o, b));
+				}
+			}
+			for (proxy_id_t a = 0; a < proxies.size(); ++a) {
+				const auto& pa = proxies[a];
+				for (int32_t y = pa.cells.y0; y <= pa.cells.y1; ++y) {
+					for (int32_t x = pa.cells.x0; x <= pa.cells.x1; ++x) {
+						const auto* bucket = cells.get(cell_key(x, y));
+						if (!bucket) continue;
+						for (const proxy_id_t b : *bucket) {
+							if (b <= a) continue;
+							const auto& pb = proxies[b];
+							if (!is_first_shared_cell(pa.cells, pb.cells, x, y)) continue;
+							if (pa.box.overlaps(pb.box)) f(a, b);
+						}
+					}
+				}
+			}
+		}
+
+		/**
+		 * \brief box 와 AABB 가 겹치는 proxy 마다 f(id) 를 한번씩 부릅니다.
+		 */
+		template <typename F>
+		void query(const aabb_t& box, F&& f) const {
+			const auto range = cells_of(box);
+			if (range.placement == placement_t::none) return;
+			if (range.placement == placement_t::overflow) {
+				for (proxy_id_t id = 0; id < proxies.size(); ++id) {
+					const auto& proxy = proxies[id];
+					if (proxy.cells.placement != placement_t::none && box.overlaps(proxy.box)) f(id);
+				}
+				return;
+			}
+			for (const proxy_id_t id : overflow) {
+				if (box.overlaps(proxies[id].box)) f(id);
+			}
+			for (int32_t y = range.y0; y <= range.y1; ++y) {
+				for (int32_t x = range.x0; x <= range.x1; ++x) {
+					const auto* bucket = cells.get(cell_key(x, y));
+					if (!bucket) continue;
+					for (const proxy_id_t id : *bucket) {
+						const auto& proxy = proxies[id];
+						if (!is_first_shared_cell(range, proxy.cells, x, y)) continue;
+						if (box.overlaps(proxy.box)) f(id);
+					}
+				}
+			}
+		}
+	};
+}
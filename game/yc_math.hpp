@@ -1,7 +1,10 @@
 #pragma once
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
 #include <optional>
+#include <utility>
 
 namespace yc_math
 {
@@ -141,40 +144,53 @@ namespace yc_math
             return start + t * line_dir;
         }
 
-        [[nodiscard]] std::optional<vec3_t> closest_point(const line_segment_t& other) const {
+        /**
+         * \brief 두 선분에서 서로 가장 가까운 점. first 는 이 선분 위, second 는 other 위의 점입니다.
+         * 평행한 선분과 길이가 0인 선분(점)도 처리합니다.
+         */
+        [[nodiscard]] std::pair<vec3_t, vec3_t> closest_points(const line_segment_t& other) const {
+            constexpr double eps = std::numeric_limits<double>::epsilon();
             const vec3_t u = end - start;
             const vec3_t v = other.end - other.start;
             const vec3_t w = start - other.start;
+            const double a = dot(u, u);
+            const double e = dot(v, v);
+            const double f = dot(v, w);
 
-            const double a = dot(u,u);
-            const double b = dot(u,v);
-            if (std::abs(b) < std::numeric_limits<double>::epsilon()) {
-                // Lines are parallel
-                return {};
+            double s = 0, t = 0;
+            if (a <= eps && e <= eps) {
+                // 둘 다 점
+            } else if (a <= eps) {
+                t = std::clamp(f / e, 0.0, 1.0);
+            } else {
+                const double c = dot(u, w);
+                if (e <= eps) {
+                    s = std::clamp(-c / a, 0.0, 1.0);
+                } else {
+                    const double b = dot(u, v);
+                    const double det = a * e - b * b;
+                    // 평행하면 어느 점이든 같으므로 start 에서 시작한다.
+                    s = det > eps * a * e ? std::clamp((b * f - c * e) / det, 0.0, 1.0) : 0.0;
+                    // s 를 clamp 했으면 t 를 다시 구하고, t 가 범위를 벗어나면 clamp 한 t 로 s 를 다시 구한다.
+                    t = (b * s + f) / e;
+                    if (t < 0) {
+                        t = 0;
+                        s = std::clamp(-c / a, 0.0, 1.0);
+                    } else if (t > 1) {
+                        t = 1;
+                        s = std::clamp((b - c) / a, 0.0, 1.0);
+                    }
+                }
             }
-            const double c = dot(v,v);
-            const double d = dot(u,w);
-            const double e = dot(v,w);
-            const double det = a*c - b*b;
-            double s = b*e - c*d;
-            double t = b*d - a*e;
-            if (s < 0) {
-                s = 0;
-            } else if (s > det) {
-                s = det;
-            }
-            if (t < 0) {
-                t = 0;
-            } else if (t > det) {
-                t = det;
-            }
-            return std::make_optional(start + (s/det)*u);
+            return {start + s * u, other.start + t * v};
         }
+
+        [[nodiscard]] vec3_t closest_point(const line_segment_t& other) const { return closest_points(other).first; }
     };
     
     inline bool col(const line_segment_t& a, const line_segment_t& b, const double radius) {
-        if(!a.closest_point(b).has_value()) return false;
-        return distance(a.closest_point(b).value(), b.closest_point(a).value()) < radius;
+        const auto [p, q] = a.closest_points(b);
+        return distance(p, q) < radius;
     }
 }
 
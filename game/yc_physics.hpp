@@ -1,13 +1,26 @@
 #pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <memory_resource>
 #include <unordered_map>
 #include <vector>
 #include <ranges>
-#include <format>
+#include <span>
 #include <functional>
 #include <unordered_set>
 #include <variant>
 
 #include "yc_math.hpp"
+#include "yc_simd.hpp"
+#include "yc_broadphase.hpp"
+#include "../memory/yc_arena.hpp"
+#include "../diag/yc_trace.hpp"
+#include "../diag/yc_metrics.hpp"
+#include "../diag/yc_log.hpp"
+#include "../thread_pool.hpp"
 
 namespace yc_physics
 {
@@ -47,201 +60,284 @@ namespace yc_physics
 		return shape_t(capsule_t(half_height, radius));
 	}
 
+	/**
+	 * \brief heightmap 충돌용 terrain.
+	 * 높이는 입력받은 uint8 그대로 보관하고 vertex 위치는 필요할 때 계산합니다.
+	 * meshing 결과 triangle 은 vertex index(y * width + x) 3개로 저장하고,
+	 * cell 은 자기를 덮는 triangle 2개 중 첫번째 index 만 가집니다.
+	 * 데이터는 build 로 만든 storage 나 cache 파일의 mapping(yc_terrain_cache.hpp) 을 span 으로 가리킵니다.
+	 */
 	struct terrain_t {
-		struct cell_t {
-			vec3_t root_pos;
-			vec3_t vertex[4];
-			int height[4];
-			int all_height = -1;
-			std::vector<triangle_t*> triangles;
-			bool is_print = false;
+		// 모든 cell 은 정확히 하나의 사각형(triangle 2개)에 속한다.
+		static constexpr uint32_t triangles_per_cell = 2;
+
+		// build 로 만든 데이터. cache 에서 읽은 terrain 은 비어 있다.
+		struct storage_t {
+			std::vector<uint8_t> heights;
+			std::vector<uint32_t> triangle_indices;
+			std::vector<uint32_t> cell_first_triangle;
 		};
 
-		std::vector<cell_t> cells;
-		std::vector<vec3_t> vertex;
-		std::vector<size_t> index_buffs;
-		std::vector<triangle_t> triangles;
-		std::vector<triangle_t> interpolated_triangles;
+		std::span<const uint8_t> heights;
+		// meshing 결과. triangle 하나당 vertex index 3개.
+		std::span<const uint32_t> triangle_indices;
+		// cell 별 첫 triangle index. cell 의 triangle 은 [first, first + triangles_per_cell) 이다.
+		std::span<const uint32_t> cell_first_triangle;
 
-		int width, height;
-		double scale;
+		int width = 0, height = 0;
+		double scale = 1.0;
 
 		vec3_t root_pos;
 
-		[[nodiscard]] bool is_cell_all_height_same(const size_t i) const {
-			const int h = cells[i].height[0];
-			return (h == cells[i].height[1]) &&
-				(h == cells[i].height[2]) &&
-				(h == cells[i].height[3]);
-		}
+	private:
+		storage_t storage;
+		// span 이 storage 가 아닌 곳(mmap 등)을 가리킬 때 그 memory 를 살려둔다.
+		std::shared_ptr<const void> backing;
 
-		bool build(const uint8_t* heightmap, const int in_width, const int in_height, const double in_scale) {
+	public:
+		terrain_t() = default;
+		// span 이 자기 storage 를 가리키므로 복사하면 안 된다. vector 의 move 는 buffer 를 그대로 옮기므로 move 는 된다.
+		terrain_t(const terrain_t&) = delete;
+		terrain_t& operator=(const terrain_t&) = delete;
+		terrain_t(terrain_t&&) = default;
+		terrain_t& operator=(terrain_t&&) = default;
+
+		/**
+		 * \brief build 없이 외부 memory 의 데이터를 그대로 사용합니다. cache loader 가 사용합니다.
+		 * \param keep_alive 데이터가 살아있는 동안 들고 있을 객체. terrain 이 소멸하거나 다시 build 할 때 놓습니다.
+		 */
+		void attach(const int in_width, const int in_height, const double in_scale,
+		            const std::span<const uint8_t> in_heights,
+		            const std::span<const uint32_t> in_triangle_indices,
+		            const std::span<const uint32_t> in_cell_first_triangle,
+		            std::shared_ptr<const void> keep_alive) {
+			storage = {};
 			width = in_width;
 			height = in_height;
 			scale = in_scale;
+			heights = in_heights;
+			triangle_indices = in_triangle_indices;
+			cell_first_triangle = in_cell_first_triangle;
+			backing = std::move(keep_alive);
+		}
 
-			vertex.clear();
-			vertex.reserve(width * height);
-			for (int i = 0; i < width * height; i++) {
-				auto h = heightmap[i] - 128;
-				int x = i % width;
-				int y = i / width;
-				vertex.emplace_back(root_pos + vec3_t{x * scale, y * scale, h * scale});
-			}
-			//make triangles form vertex index
-			index_buffs.clear();
-			index_buffs.reserve(width * height * 6);
-			for (int x = 0; x < width - 1; x++) {
-				for (int y = 0; y < height - 1; y++) {
-					size_t i = y * width + x;
-					index_buffs.emplace_back(i);
-					index_buffs.emplace_back(i + 1);
-					index_buffs.emplace_back(i + width);
-					index_buffs.emplace_back(i + 1);
-					index_buffs.emplace_back(i + 1 + width);
-					index_buffs.emplace_back(i + width);
+		/**
+		 * \return 데이터가 storage 가 아닌 외부 memory(mapping) 에 있으면 true
+		 */
+		[[nodiscard]] bool is_attached() const { return backing != nullptr; }
+
+		[[nodiscard]] int cell_width() const { return std::max(width - 1, 0); }
+		[[nodiscard]] int cell_height() const { return std::max(height - 1, 0); }
+
+		[[nodiscard]] int get_raw_height(const int x, const int y) const {
+			return heights[static_cast<size_t>(y) * width + x];
+		}
+
+		[[nodiscard]] vec3_t get_vertex(const int x, const int y) const {
+			const int h = get_raw_height(x, y) - 128;
+			return root_pos + vec3_t{x * scale, y * scale, h * scale};
+		}
+
+		[[nodiscard]] vec3_t get_vertex(const uint32_t index) const {
+			return get_vertex(static_cast<int>(index % width), static_cast<int>(index / width));
+		}
+
+		[[nodiscard]] size_t triangle_count() const { return triangle_indices.size() / 3; }
+
+		[[nodiscard]] triangle_t get_triangle(const size_t i) const {
+			return {
+				get_vertex(triangle_indices[i * 3]),
+				get_vertex(triangle_indices[i * 3 + 1]),
+				get_vertex(triangle_indices[i * 3 + 2])
+			};
+		}
+
+		[[nodiscard]] uint32_t first_triangle_of(const int cell_x, const int cell_y) const {
+			return cell_first_triangle[static_cast<size_t>(cell_y) * cell_width() + cell_x];
+		}
+
+		/**
+		 * \return cell 의 네 높이가 같으면 그 높이, 아니면 -1
+		 */
+		[[nodiscard]] int get_cell_flat_height(const int cell_x, const int cell_y) const {
+			const int h = get_raw_height(cell_x, cell_y);
+			return (h == get_raw_height(cell_x + 1, cell_y)) &&
+			       (h == get_raw_height(cell_x, cell_y + 1)) &&
+			       (h == get_raw_height(cell_x + 1, cell_y + 1)) ? h : -1;
+		}
+
+		/**
+		 * \brief 합치지 않은 전체 grid 의 index buffer 를 만듭니다. 렌더링용이며 충돌에는 쓰지 않습니다.
+		 * 순서는 x 가 바깥, y 가 안쪽이고 cell 마다 (i, i + 1, i + width), (i + 1, i + 1 + width, i + width) 입니다.
+		 */
+		[[nodiscard]] std::vector<uint32_t> make_grid_index_buffer() const {
+			std::vector<uint32_t> index_buffs;
+			index_buffs.reserve(static_cast<size_t>(cell_width()) * cell_height() * 6);
+			for (int x = 0; x < cell_width(); x++) {
+				for (int y = 0; y < cell_height(); y++) {
+					const uint32_t i = y * width + x;
+					index_buffs.insert(index_buffs.end(), { i, i + 1, i + width, i + 1, i + 1 + width, i + width });
 				}
 			}
-			// make triangles
-			triangles.clear();
-			triangles.reserve(index_buffs.size() / 3);
-			for (size_t i = 0; i < index_buffs.size() / 3; i++) {
-				triangle_t t{};
-				t.a = vertex[index_buffs[i * 3]];
-				t.b = vertex[index_buffs[i * 3 + 1]];
-				t.c = vertex[index_buffs[i * 3 + 2]];
-				triangles.emplace_back(t);
-			}
+			return index_buffs;
+		}
 
-			auto get_cell = [&](const int x, const int y) -> cell_t& { return cells[y * (width - 1) + x]; };
-			auto get_cell_index = [&](const int x, const int y) -> size_t { return y * (width - 1) + x; };
-			auto get_vertex = [&](const int x, const int y) -> vec3_t& { return vertex[y * width + x]; };
-			auto get_vertex_index = [&](const int x, const int y) -> size_t { return y * width + x; };
-			auto get_height = [&](const int x, const int y) -> int { return heightmap[x + y * width]; };
-
-			cells.clear();
-			cells.reserve((width - 1) * (height - 1));
-			for (int i = 0; i < (width - 1) * (height - 1); i++) {
-				int x = i % (width - 1);
-				int y = i / (width - 1);
-				cells.emplace_back(cell_t{
-					get_vertex(x, y) + vec3_t{0.5, 0.5, 0},
-					{
-						get_vertex(x, y),
-						get_vertex(x + 1, y),
-						get_vertex(x, y + 1),
-						get_vertex(x + 1, y + 1)
-					},
-					{
-						get_height(x, y),
-						get_height(x + 1, y),
-						get_height(x, y + 1),
-						get_height(x + 1, y + 1)
-					},
-					-1,
-					{}
-				});
-
-				cells[i].all_height = is_cell_all_height_same(i) ? cells[i].height[0] : -1;
-				if (cells[i].all_height != -1) { cells[i].is_print = true; }
+		/**
+		 * \brief terrain 이 heap 에 들고 있는 데이터의 크기(byte). mapping 은 포함하지 않습니다.
+		 */
+		[[nodiscard]] size_t memory_bytes() const {
+			return storage.heights.capacity() * sizeof(uint8_t) +
+			       storage.triangle_indices.capacity() * sizeof(uint32_t) +
+			       storage.cell_first_triangle.capacity() * sizeof(uint32_t);
+		}
+
+		/**
+		 * \brief heightmap 을 복사하고 같은 높이의 평평한 cell 들을 큰 사각형으로 합쳐 triangle 을 만듭니다.
+		 * \param heightmap in_width * in_height 크기의 높이 값. 128 이 높이 0 입니다.
+		 * \param pool 주어지면 cell 평탄도 계산과 triangle index 기록을 나눠 pool 에서 실행합니다.
+		 * 사각형을 고르는 greedy 단계는 앞에서 합친 cell 에 따라 결과가 달라지므로 항상 호출한 thread 에서 실행합니다.
+		 * pool 의 worker 안에서 호출할 때는 nullptr 를 넘겨야 합니다.
+		 * \return vertex index 가 32bit 를 넘으면 false
+		 */
+		bool build(const uint8_t* heightmap, const int in_width, const int in_height, const double in_scale,
+		           test_thread_pool* pool = nullptr) {
+			YC_TRACE_ZONE("terrain_t::build");
+			if (static_cast<uint64_t>(std::max(in_width, 0)) * std::max(in_height, 0) > std::numeric_limits<uint32_t>::max()) {
+				return false;
 			}
-			std::vector mark(cells.size(), false);
-			auto check_box = [&](int x, int y, int w, int h) {
-				if (x < 0 || y < 0 || w > width - 1 || h > height - 1) return false;
-				for (int i = x; i < w + 1; i++) {
-					for (int j = y; j < h + 1; j++) {
-						if (mark[get_cell_index(i, j)]) return false;
-						if (get_cell(i, j).all_height == -1) return false;
-						if (get_cell(i, j).all_height != get_cell(x, y).all_height) return false;
+			width = in_width;
+			height = in_height;
+			scale = in_scale;
+
+			const int cw = cell_width();
+			const int ch = cell_height();
+			const size_t cell_count = static_cast<size_t>(cw) * ch;
+
+			backing.reset();
+			storage.heights.assign(heightmap, heightmap + static_cast<size_t>(width) * height);
+			heights = storage.heights;
+
+			// cell 이 평평하면 그 높이, 아니면 -1. build 하는 동안만 쓴다.
+			std::vector<int16_t> flat(cell_count);
+			auto fill_flat = [&](const size_t begin, const size_t end) {
+				for (int y = static_cast<int>(begin); y < static_cast<int>(end); y++) {
+					for (int x = 0; x < cw; x++) {
+						flat[static_cast<size_t>(y) * cw + x] = static_cast<int16_t>(get_cell_flat_height(x, y));
 					}
 				}
+			};
+			if (pool) pool->parallel_for(ch, fill_flat);
+			else fill_flat(0, ch);
+
+			auto get_cell_index = [&](const int x, const int y) -> size_t { return static_cast<size_t>(y) * cw + x; };
+			auto get_vertex_index = [&](const int x, const int y) -> uint32_t { return y * width + x; };
+
+			// greedy meshing. 행 우선으로 한번만 훑으며, 아직 합쳐지지 않은 cell 에서 사각형을 키운다.
+			// 키우는 순서는 대각선 -> 오른쪽 열 / 아래 행이고, 사각형이 커질 때 새로 붙는 열 / 행만 검사하므로
+			// 전체 비용은 cell 수에 비례한다.
+			std::vector<uint8_t> mark(cell_count, 0);
+			auto is_mergeable = [&](const int x, const int y, const int base) {
+				const size_t i = get_cell_index(x, y);
+				return !mark[i] && flat[i] == base;
+			};
+			// 열 cx 의 [y0, y1] 이 모두 합칠 수 있는지
+			auto column_mergeable = [&](const int cx, const int y0, const int y1, const int base) {
+				if (cx > cw - 1 || y1 > ch - 1) return false;
+				for (int y = y0; y <= y1; y++) {
+					if (!is_mergeable(cx, y, base)) return false;
+				}
+				return true;
+			};
+			// 행 cy 의 [x0, x1] 이 모두 합칠 수 있는지
+			auto row_mergeable = [&](const int cy, const int x0, const int x1, const int base) {
+				if (cy > ch - 1 || x1 > cw - 1) return false;
+				for (int x = x0; x <= x1; x++) {
+					if (!is_mergeable(x, cy, base)) return false;
+				}
 				return true;
 			};
 
-			interpolated_triangles.reserve(cells.size() * 2);
-			while (std::ranges::count(mark, false)) {
-				for (size_t i = 0; i < cells.size(); i++) {
-					if (!mark[i]) {
-						int x = i % (width - 1);
-						// NOLINT(bugprone-narrowing-conversions, cppcoreguidelines-narrowing-conversions)
-						int y = i / (width - 1);
-						// NOLINT(bugprone-narrowing-conversions, cppcoreguidelines-narrowing-conversions, clang-diagnostic-shorten-64-to-32)
-						int w = x;
-						int h = y;
-
-						bool f = true;
-						bool s = true;
-						bool t = true;
-						while (f || s || t) {
-							if (t && check_box(x, y, w + 1, h + 1)) {
-								w++;
-								h++;
-							}
-							else {
-								t = false;
-								f = check_box(x, y, w + 1, h);
-								s = check_box(x, y, w, h + 1);
-								if (f) w++;
-								if (s) h++;
-							}
-						}
-						if (w == x && h == y) {
-							mark[get_cell_index(x, y)] = true;
-							auto& cell = get_cell(x, y);
-							triangle_t t1{};
-							t1.a = cell.vertex[0];
-							t1.b = cell.vertex[1];
-							t1.c = cell.vertex[2];
-							triangle_t t2{};
-							t2.a = cell.vertex[1];
-							t2.b = cell.vertex[2];
-							t2.c = cell.vertex[3];
-
-							interpolated_triangles.push_back(t1);
-							interpolated_triangles.push_back(t2);
-							auto size = interpolated_triangles.size();
-							cell.triangles.push_back(&interpolated_triangles[size - 2]);
-							cell.triangles.push_back(&interpolated_triangles[size - 1]);
+			// 사각형 하나가 triangle 두개이므로 r 번째 사각형의 index 는 6r 부터, 첫 triangle 은 2r 이다.
+			// greedy 단계는 그 자리에 사각형 (x, y, w, h) 만 적어두고, emit 이 vertex index 와 cell_first 로 바꾼다.
+			// pool 이 있으면 greedy 가 끝난 뒤 사각형을 나눠 한번에 바꾼다.
+			auto& indices = storage.triangle_indices;
+			auto& cell_first = storage.cell_first_triangle;
+			indices.clear();
+			cell_first.resize(cell_count);
+			// 사각형은 서로 겹치지 않고 각자 자기 자리만 쓰므로 나눠서 바꿔도 결과가 같다.
+			// 열 / 행 검사는 mark 만 보므로 greedy 도중에 바꾼 자리는 다시 읽지 않는다.
+			auto emit = [&](const size_t begin, const size_t end) {
+				for (size_t r = begin; r < end; r++) {
+					uint32_t* out = indices.data() + r * 6;
+					const int x = static_cast<int>(out[0]);
+					const int y = static_cast<int>(out[1]);
+					const int w = static_cast<int>(out[2]);
+					const int h = static_cast<int>(out[3]);
+					const auto first = static_cast<uint32_t>(r * 2);
+					for (int l = y; l < h + 1; l++) {
+						for (int k = x; k < w + 1; k++) cell_first[get_cell_index(k, l)] = first;
+					}
+					// 사각형의 네 모서리 vertex. cell 하나일 때도 같은 모양이다.
+					const uint32_t vr[] = {
+						get_vertex_index(x, y),
+						get_vertex_index(w + 1, y),
+						get_vertex_index(x, h + 1),
+						get_vertex_index(w + 1, h + 1)
+					};
+					out[0] = vr[0];
+					out[1] = vr[1];
+					out[2] = vr[2];
+					out[3] = vr[1];
+					out[4] = vr[2];
+					out[5] = vr[3];
+				}
+			};
+			for (int y = 0; y < ch; y++) {
+				for (int x = 0; x < cw; x++) {
+					if (mark[get_cell_index(x, y)]) continue;
+
+					const int base = flat[get_cell_index(x, y)];
+					int w = x;
+					int h = y;
+
+					bool f = base != -1;
+					bool s = f;
+					bool t = f;
+					while (f || s || t) {
+						if (t && column_mergeable(w + 1, y, h + 1, base) && row_mergeable(h + 1, x, w, base)) {
+							w++;
+							h++;
 						}
 						else {
-							cell_t* cell[4] = {
-								&get_cell(x, y),
-								&get_cell(w, y),
-								&get_cell(x, h),
-								&get_cell(w, h)
-							};
-							vec3_t vr[] = {
-								{cell[0]->vertex[0]},
-								{cell[1]->vertex[1]},
-								{cell[2]->vertex[2]},
-								{cell[3]->vertex[3]}
-							};
-
-							triangle_t t1{};
-							t1.a = vr[0];
-							t1.b = vr[1];
-							t1.c = vr[2];
-							triangle_t t2{};
-							t2.a = vr[1];
-							t2.b = vr[2];
-							t2.c = vr[3];
-
-							interpolated_triangles.push_back(t1);
-							interpolated_triangles.push_back(t2);
-							for (int k = x; k < w + 1; k++) {
-								for (int l = y; l < h + 1; l++) {
-									mark[get_cell_index(k, l)] = true;
-									auto size = interpolated_triangles.size();
-									get_cell(k, l).triangles.push_back(&interpolated_triangles[size - 2]);
-									get_cell(k, l).triangles.push_back(&interpolated_triangles[size - 1]);
-								}
-							}
+							// 한번 실패한 방향은 사각형이 커져도 다시 성공하지 않는다.
+							t = false;
+							f = f && column_mergeable(w + 1, y, h, base);
+							s = s && row_mergeable(h + 1, x, w, base);
+							// 오른쪽 / 아래로 동시에 커지면 새 모서리 cell 은 어느 쪽 검사에도 들어가지 않는다.
+							// 모서리를 합칠 수 없으면 오른쪽으로만 키운다.
+							if (f && s && !is_mergeable(w + 1, h + 1, base)) s = false;
+							if (f) w++;
+							if (s) h++;
 						}
-						break;
+					}
+
+					indices.insert(indices.end(), {
+						static_cast<uint32_t>(x), static_cast<uint32_t>(y), static_cast<uint32_t>(w), static_cast<uint32_t>(h), 0, 0
+					});
+					// pool 이 없으면 방금 본 cell 들이 cache 에 있을 때 바로 바꾼다.
+					if (!pool) emit(indices.size() / 6 - 1, indices.size() / 6);
+					for (int l = y; l < h + 1; l++) {
+						for (int k = x; k < w + 1; k++) mark[get_cell_index(k, l)] = true;
 					}
 				}
 			}
 
+			indices.shrink_to_fit();
+
+			if (pool) pool->parallel_for(indices.size() / 6, emit);
+			triangle_indices = indices;
+			cell_first_triangle = cell_first;
+
 			return true;
 		}
 
@@ -254,29 +350,136 @@ namespace yc_physics
 			return h_down + (h_up - h_down) * v;
 		}
 
+		/**
+		 * \brief cell 좌표의 닫힌 범위 [x0, x1] x [y0, y1].
+		 */
+		struct cell_range_t {
+			int x0 = 0, y0 = 0, x1 = -1, y1 = -1;
+			[[nodiscard]] bool empty() const { return x1 < x0 || y1 < y0; }
+		};
+
+		/**
+		 * \brief world 좌표 xy 사각형과 겹치는 cell 범위. terrain 밖은 잘라냅니다.
+		 */
+		[[nodiscard]] cell_range_t overlapping_cells(const double min_x, const double min_y,
+		                                             const double max_x, const double max_y) const {
+			const double lx = (min_x - root_pos.x) / scale;
+			const double ly = (min_y - root_pos.y) / scale;
+			const double hx = (max_x - root_pos.x) / scale;
+			const double hy = (max_y - root_pos.y) / scale;
+			if (hx < 0 || hy < 0 || lx > cell_width() || ly > cell_height()) return {};
+			return {
+				std::max(static_cast<int>(std::floor(lx)), 0),
+				std::max(static_cast<int>(std::floor(ly)), 0),
+				std::min(static_cast<int>(std::floor(hx)), cell_width() - 1),
+				std::min(static_cast<int>(std::floor(hy)), cell_height() - 1)
+			};
+		}
+
+		/**
+		 * \brief 범위 안 cell 들의 triangle index 로 f 를 호출합니다.
+		 * 여러 cell 에 걸친 사각형의 triangle 은 범위 안에서 한번만 방문합니다.
+		 */
+		template <typename F>
+		void for_each_triangle(const cell_range_t& range, F&& f) const {
+			for (int cy = range.y0; cy <= range.y1; ++cy) {
+				for (int cx = range.x0; cx <= range.x1; ++cx) {
+					const uint32_t first = first_triangle_of(cx, cy);
+					// 사각형과 범위가 겹치는 부분도 사각형이므로 그 왼쪽 위 cell 에서만 방문한다.
+					if (cx > range.x0 && first_triangle_of(cx - 1, cy) == first) continue;
+					if (cy > range.y0 && first_triangle_of(cx, cy - 1) == first) continue;
+					for (uint32_t tri = first; tri < first + triangles_per_cell; ++tri) f(tri);
+				}
+			}
+		}
+
+		/**
+		 * \return 범위의 cell 이 모두 하나의 평평한 사각형에 속하면 true. 이때 범위 안의 표면은 한 평면입니다.
+		 * 사각형은 직사각형이므로 범위의 양 끝 cell 이 같은 사각형이면 범위 전체가 그 안에 있습니다.
+		 */
+		[[nodiscard]] bool is_single_flat_quad(const cell_range_t& range) const {
+			if (range.empty()) return false;
+			if (first_triangle_of(range.x0, range.y0) != first_triangle_of(range.x1, range.y1)) return false;
+			return get_cell_flat_height(range.x0, range.y0) != -1;
+		}
+
+		struct surface_sample_t {
+			double height;
+			vec3_t normal;
+		};
+
+		/**
+		 * \return world 좌표 (in_x, in_y) 가 terrain 의 cell 영역 안이면 true
+		 */
+		[[nodiscard]] bool contains(const double in_x, const double in_y) const {
+			const double x = in_x - root_pos.x;
+			const double y = in_y - root_pos.y;
+			return x >= 0 && y >= 0 && x <= cell_width() * scale && y <= cell_height() * scale;
+		}
+
+		/**
+		 * \brief world 좌표 (in_x, in_y) 의 표면 높이와 법선. 충돌 mesh 의 triangle 과 정확히 같은 면입니다.
+		 * cell 은 (x + 1, y) - (x, y + 1) 대각선으로 나뉘며, 합쳐진 사각형은 평평하므로 grid 의 triangle 과 같은 면이 됩니다.
+		 * terrain 밖의 좌표는 가장자리 cell 로 붙입니다.
+		 */
+		[[nodiscard]] surface_sample_t sample_surface(const double in_x, const double in_y) const {
+			if (cell_width() == 0 || cell_height() == 0) return { root_pos.z, {0, 0, 1} };
+			const double gx = std::clamp((in_x - root_pos.x) / scale, 0.0, static_cast<double>(cell_width()));
+			const double gy = std::clamp((in_y - root_pos.y) / scale, 0.0, static_cast<double>(cell_height()));
+			const int cx = std::min(static_cast<int>(gx), cell_width() - 1);
+			const int cy = std::min(static_cast<int>(gy), cell_height() - 1);
+			const double u = gx - cx;
+			const double v = gy - cy;
+
+			const double h00 = get_raw_height(cx, cy);
+			const double h10 = get_raw_height(cx + 1, cy);
+			const double h01 = get_raw_height(cx, cy + 1);
+			const double h11 = get_raw_height(cx + 1, cy + 1);
+			double h, dz_dx, dz_dy;
+			if (u + v <= 1) {
+				// (x, y), (x + 1, y), (x, y + 1) triangle
+				dz_dx = h10 - h00;
+				dz_dy = h01 - h00;
+				h = h00 + dz_dx * u + dz_dy * v;
+			}
+			else {
+				// (x + 1, y), (x, y + 1), (x + 1, y + 1) triangle
+				dz_dx = h11 - h01;
+				dz_dy = h11 - h10;
+				h = h11 - dz_dx * (1 - u) - dz_dy * (1 - v);
+			}
+			// 높이와 x, y 가 같은 scale 을 쓰므로 기울기는 scale 과 상관없다.
+			return { root_pos.z + (h - 128) * scale, normalize(vec3_t{-dz_dx, -dz_dy, 1}) };
+		}
+
+		/**
+		 * \brief world 좌표 (in_x, in_y) 의 표면 높이(world z). 충돌 mesh 의 triangle 위의 값입니다.
+		 */
 		[[nodiscard]] double get_height_interpolation(const double in_x, const double in_y) const {
-			const double real_x = in_x / scale;
-			const double real_y = in_y / scale;
-			int grid_x = static_cast<int>(floor(in_x / scale));
-			int grid_y = static_cast<int>(floor(in_y / scale));
-			grid_x = std::max(0, std::min(width - 1, grid_x));
-			grid_y = std::max(0, std::min(height - 1, grid_y));
-			//Interpolated height data is obtained by analyzing the surrounding nodes.
-
-			//그리드의 중점을 기점으로 4개의 방향중 어느 방향에 있는지 검사한다.
-			const double grid_center_x = (grid_x + 0.5) * scale;
-			const double grid_center_y = (grid_y + 0.5) * scale;
-
-			//left down
-			if (real_x < grid_center_x && real_y < grid_center_y) { }
-			//left up
-			if (real_x < grid_center_x && real_y > grid_center_y) { }
-			//right down
-			if (real_x > grid_center_x && real_y < grid_center_y) { }
-			//right up
-			if (real_x > grid_center_x && real_y > grid_center_y) { }
-
-			return 0;
+			return sample_surface(in_x, in_y).height;
+		}
+
+		/**
+		 * \brief world 좌표 (in_x, in_y) 의 표면 법선.
+		 */
+		[[nodiscard]] vec3_t get_normal(const double in_x, const double in_y) const {
+			return sample_surface(in_x, in_y).normal;
+		}
+
+		/**
+		 * \brief cell 네 꼭지점의 쌍선형 보간 높이(world z). 충돌 mesh 와는 대각선 근처에서 조금 다르지만 더 매끄럽습니다.
+		 */
+		[[nodiscard]] double get_height_bilinear(const double in_x, const double in_y) const {
+			if (cell_width() == 0 || cell_height() == 0) return root_pos.z;
+			const double gx = std::clamp((in_x - root_pos.x) / scale, 0.0, static_cast<double>(cell_width()));
+			const double gy = std::clamp((in_y - root_pos.y) / scale, 0.0, static_cast<double>(cell_height()));
+			const int cx = std::min(static_cast<int>(gx), cell_width() - 1);
+			const int cy = std::min(static_cast<int>(gy), cell_height() - 1);
+			const double h = get_interpolated_height(
+				get_raw_height(cx, cy + 1), get_raw_height(cx + 1, cy + 1),
+				get_raw_height(cx, cy), get_raw_height(cx + 1, cy),
+				gx - cx, gy - cy);
+			return root_pos.z + (h - 128) * scale;
 		}
 	};
 
@@ -290,59 +493,6 @@ namespace yc_physics
 		bool use_physic_simulate = false;
 	};
 
-	inline bool col(const capsule_t& a, const capsule_t& b) {
-		/*
-		const vec3_t a_pos = a.get_pos();
-		const qut_t a_rot = a.get_rot();
-		const vec3_t a_scale = a.get_scale();
-		const double a_half_height = a.half_height * a_scale.z;
-		const double a_radius = a.radius * a_scale.x;
-		const vec3_t b_pos = b.get_pos();
-		const qut_t b_rot = b.get_rot();
-		const vec3_t b_scale = b.get_scale();
-		const double b_half_height = b.half_height * b_scale.z;
-		const double b_radius = b.radius * b_scale.x;
-
-		const auto a_half_len = a_rot * vec3_t(0, 0, a_half_height - a_radius);
-		const auto b_half_len = b_rot * vec3_t(0, 0, b_half_height - b_radius);
-		const line_segment_t a_segment = {a_pos + a_half_len, a_pos - a_half_len};
-		const line_segment_t b_segment = {b_pos + b_half_len, b_pos - b_half_len};
-
-		if (yc_math::col(a_segment, b_segment, a_radius + b_radius)) { return true; }
-		if (distance(a_pos, b_pos) < a_radius + b_radius) { return true; }
-		*/
-		return false;
-	}
-
-	inline std::vector<vec3_t> get_capsule_cells(
-		const capsule_t& capsule,
-		const vec3_t& in_pos,
-		const qut_t& in_rot,
-		const terrain_t& terrain) {
-		std::vector<vec3_t> cells;
-		const vec3_t pos = in_pos - terrain.root_pos;
-		if (pos.x < 0 ||
-			pos.y < 0 ||
-			pos.x >= (terrain.width - 1) * terrain.scale ||
-			pos.y >= (terrain.height - 1) * terrain.scale)
-			return {};
-		const auto s = pos + in_rot * vec3_t(0, 0, capsule.half_height);
-		const auto e = pos - in_rot * vec3_t(0, 0, capsule.half_height);
-		const auto r = capsule.radius;
-		const auto x_min = std::min(s.x, e.x) - r;
-		const auto x_max = std::max(s.x, e.x) + r;
-		const auto y_min = std::min(s.y, e.y) - r;
-		const auto y_max = std::max(s.y, e.y) + r;
-		const int start_x = static_cast<int>(floor(x_min / terrain.scale));
-		const int end_x = static_cast<int>(floor(x_max / terrain.scale));
-		const int start_y = static_cast<int>(floor(y_min / terrain.scale));
-		const int end_y = static_cast<int>(floor(y_max / terrain.scale));
-		for (int x = start_x; x <= end_x; ++x) {
-			for (int y = start_y; y <= end_y; ++y) { cells.push_back(vec3_t(x, y)); }
-		}
-		return cells;
-	}
-
 	inline line_segment_t closest_line_segment(const line_segment_t& line, const triangle_t& triangle) {
 		const vec3_t norm = normalize(cross(triangle.b - triangle.a, triangle.c - triangle.a));
 		const vec3_t midpoint = line.start + 0.5 * (line.end - line.start);
@@ -375,11 +525,16 @@ namespace yc_physics
 		vec3_t penetration_normal;
 		double penetration_depth;
 	};
-	inline vec3_t closest_point_on_line_segment(line_segment_t& line, vec3_t point) {
+	// sphere 중심과 접촉점 사이가 이보다 가까우면 그 방향을 법선으로 쓸 수 없다.
+	constexpr double degenerate_contact_distance = 1e-6;
+	inline vec3_t closest_point_on_line_segment(const line_segment_t& line, vec3_t point) {
 		const vec3_t ab = line.end - line.start;
-		float t = dot(point - line.start, ab) / dot(ab, ab);
+		double t = dot(point - line.start, ab) / dot(ab, ab);
 		return line.start + saturate(t) * ab;
 	}
+	inline vec3_t closest_point_on_line_segment(const vec3_t& a, const vec3_t& b, const vec3_t& point) {
+		return closest_point_on_line_segment(line_segment_t{a, b}, point);
+	}
 	inline std::optional<hit_data_t> col_sphere_n_triangle(const vec3_t& sphere_pos, const triangle_t& triangle, double radius) {
 		vec3_t p0 = triangle.a, p1 = triangle.b, p2 = triangle.c;
 		vec3_t center = sphere_pos;
@@ -436,7 +591,7 @@ namespace yc_physics
 		double penetration_depth = radius - len;
 		return std::make_optional(hit_data_t{penetration_normal, penetration_depth});
 	}
-	vec3_t closest_point_on_triangle(const triangle_t& triangle, const vec3_t& point) {
+	inline vec3_t closest_point_on_triangle(const triangle_t& triangle, const vec3_t& point) {
 		vec3_t p0 = triangle.a, p1 = triangle.b, p2 = triangle.c; // triangle corners
 		vec3_t N = normalize(cross(p1 - p0, p2 - p0)); // plane normal
 		// Determine whether the point is inside all triangle edges: 
@@ -450,8 +605,8 @@ namespace yc_physics
 			// Edge 1:
 			vec3_t point1 = closest_point_on_line_segment(p0, p1, point);
 			vec3_t v1 = point - point1;
-			float distsq = dot(v1, v1);
-			float best_dist = distsq;
+			double distsq = dot(v1, v1);
+			double best_dist = distsq;
 			vec3_t reference_point = point1;
 			// Edge 2:
 			vec3_t point2 = closest_point_on_line_segment(p1, p2, point);
@@ -472,15 +627,38 @@ namespace yc_physics
 			return reference_point;
 		}
 	}
-	inline std::optional<hit_data_t> col_capsule_n_triangle(const capsule_t& capsule, const rigid_body_t& rb,
-															const triangle_t& triangle) {
-		vec3_t tip = rb.pos + rb.rot * vec3_t(0, 0, capsule.half_height);
-		vec3_t base = rb.pos + rb.rot * vec3_t(0, 0, -capsule.half_height);
-		double radius = capsule.radius;
+	/**
+	 * \brief world 좌표의 capsule 축. 여러 triangle 과 검사할 때 한번만 계산합니다.
+	 */
+	struct capsule_segment_t {
+		vec3_t base;
+		vec3_t tip;
+		// base -> tip 단위 벡터
+		vec3_t axis;
+		double radius;
+
+		capsule_segment_t(const capsule_t& capsule, const vec3_t& pos, const qut_t& rot)
+			: base(pos + rot * vec3_t(0, 0, -capsule.half_height)),
+			  tip(pos + rot * vec3_t(0, 0, capsule.half_height)),
+			  axis(normalize(tip - base)),
+			  radius(capsule.radius) { }
+
+		[[nodiscard]] vec3_t min_corner() const {
+			return { std::min(base.x, tip.x) - radius, std::min(base.y, tip.y) - radius, std::min(base.z, tip.z) - radius };
+		}
+		[[nodiscard]] vec3_t max_corner() const {
+			return { std::max(base.x, tip.x) + radius, std::max(base.y, tip.y) + radius, std::max(base.z, tip.z) + radius };
+		}
+	};
+
+	inline std::optional<hit_data_t> col_capsule_n_triangle(const capsule_segment_t& segment, const triangle_t& triangle) {
+		const vec3_t& tip = segment.tip;
+		const vec3_t& base = segment.base;
+		double radius = segment.radius;
 		vec3_t p0 = triangle.a, p1 = triangle.b, p2 = triangle.c; // triangle corners
 		vec3_t N = normalize(cross(p1 - p0, p2 - p0)); // plane normal
 
-		vec3_t CapsuleNormal = normalize(tip - base);
+		const vec3_t& CapsuleNormal = segment.axis;
 		
 		double t = dot(N, (p0 - base) / dot(N, CapsuleNormal));
 		vec3_t reference_point;
@@ -495,65 +673,519 @@ namespace yc_physics
 		// The center of the best sphere candidate:
 		vec3_t center = closest_point_on_line_segment(base, tip, reference_point);
 
-		return col_sphere_n_triangle(center, triangle, radius);
+		auto hit = col_sphere_n_triangle(center, triangle, radius);
+		// 축이 triangle 을 관통하면 sphere 중심이 평면 위에 있어 방향이 정해지지 않는다. capsule 중심이 있는 쪽의 면 법선을 쓴다.
+		if (hit && radius - hit->penetration_depth < degenerate_contact_distance) {
+			const vec3_t mid = (base + tip) * 0.5;
+			hit->penetration_normal = dot(mid - p0, N) < 0 ? N * -1.0 : N;
+		}
+		return hit;
+	}
+
+	inline std::optional<hit_data_t> col_capsule_n_triangle(const capsule_t& capsule, const rigid_body_t& rb,
+															const triangle_t& triangle) {
+		return col_capsule_n_triangle(capsule_segment_t(capsule, rb.pos, rb.rot), triangle);
+	}
+
+	/**
+	 * \brief SIMD 로 한번에 검사할 triangle 묶음(SoA). 배열은 [축][lane] 순서입니다.
+	 * push 로 꼭지점을 넣으면 kernel 이 검사 전에 edge 와 법선을 lane 단위로 한번 계산합니다.
+	 */
+	template <size_t N = 8>
+	struct triangle_batch_t {
+		static constexpr size_t capacity = N;
+
+		alignas(32) double p0[3][N];
+		alignas(32) double p1[3][N];
+		alignas(32) double p2[3][N];
+		// e0 = p1 - p0, e1 = p2 - p1, e2 = p0 - p2
+		alignas(32) double e0[3][N];
+		alignas(32) double e1[3][N];
+		alignas(32) double e2[3][N];
+		alignas(32) double normal[3][N];
+		size_t count = 0;
+
+		[[nodiscard]] bool full() const { return count == N; }
+		void clear() { count = 0; }
+
+		void push(const triangle_t& triangle) {
+			const vec3_t* v[] = { &triangle.a, &triangle.b, &triangle.c };
+			double (*dst[])[N] = { p0, p1, p2 };
+			for (int k = 0; k < 3; ++k) {
+				dst[k][0][count] = v[k]->x;
+				dst[k][1][count] = v[k]->y;
+				dst[k][2][count] = v[k]->z;
+			}
+			++count;
+		}
+
+		/**
+		 * \brief 빈 lane 을 마지막 triangle 로 채우고 edge 와 법선을 계산합니다.
+		 */
+		template <typename Lane>
+		void prepare() {
+			static_assert(N % Lane::width == 0, "batch capacity must be a multiple of the lane width");
+			if (count == 0) return;
+			for (size_t i = count; i < N; ++i) {
+				for (int axis = 0; axis < 3; ++axis) {
+					p0[axis][i] = p0[axis][count - 1];
+					p1[axis][i] = p1[axis][count - 1];
+					p2[axis][i] = p2[axis][count - 1];
+				}
+			}
+			using vec_t = yc_simd::vec3_lanes_t<Lane>;
+			for (size_t i = 0; i < N; i += Lane::width) {
+				const auto a = vec_t::load(p0, i);
+				const auto b = vec_t::load(p1, i);
+				const auto c = vec_t::load(p2, i);
+				(b - a).store(e0, i);
+				(c - b).store(e1, i);
+				(a - c).store(e2, i);
+				normalize(cross(b - a, c - a)).store(normal, i);
+			}
+		}
+	};
+
+	namespace detail
+	{
+		template <typename Lane>
+		using vec_lanes_t = yc_simd::vec3_lanes_t<Lane>;
+
+		// lane 별 hit. hit 이 아닌 lane 의 depth / normal 은 의미가 없다.
+		template <typename Lane>
+		struct lane_hit_t {
+			typename Lane::mask_t hit;
+			Lane depth;
+			vec_lanes_t<Lane> normal;
+		};
+
+		template <typename Lane>
+		vec_lanes_t<Lane> closest_point_on_segment(const vec_lanes_t<Lane>& a, const vec_lanes_t<Lane>& ab,
+		                                           const vec_lanes_t<Lane>& point) {
+			return a + ab * yc_simd::saturate(dot(point - a, ab) / dot(ab, ab));
+		}
+
+		// point 가 (평면에 투영했을 때) triangle 의 세 edge 안쪽인지. closest_point_on_triangle 과 같은 판정.
+		template <typename Lane>
+		typename Lane::mask_t inside_triangle(const vec_lanes_t<Lane>& point, const vec_lanes_t<Lane>& p0,
+		                                      const vec_lanes_t<Lane>& p1, const vec_lanes_t<Lane>& p2,
+		                                      const vec_lanes_t<Lane>& e0, const vec_lanes_t<Lane>& e1,
+		                                      const vec_lanes_t<Lane>& e2, const vec_lanes_t<Lane>& n) {
+			const Lane zero = Lane::broadcast(0.0);
+			return (dot(cross(point - p0, e0), n) <= zero) &
+			       (dot(cross(point - p1, e1), n) <= zero) &
+			       (dot(cross(point - p2, e2), n) <= zero);
+		}
+
+		// col_sphere_n_triangle 의 lane 버전.
+		template <typename Lane>
+		lane_hit_t<Lane> sphere_n_triangle_lanes(const vec_lanes_t<Lane>& center, const Lane radius,
+		                                         const vec_lanes_t<Lane>& p0, const vec_lanes_t<Lane>& p1,
+		                                         const vec_lanes_t<Lane>& p2, const vec_lanes_t<Lane>& e0,
+		                                         const vec_lanes_t<Lane>& e1, const vec_lanes_t<Lane>& e2,
+		                                         const vec_lanes_t<Lane>& n) {
+			const Lane dist = dot(center - p0, n);
+			const auto in_range = abs(dist) <= radius;
+			const auto point0 = center - n * dist;
+			const auto inside = inside_triangle(point0, p0, p1, p2, e0, e1, e2, n);
+
+			// 안쪽이 아니면 edge 1, 2, 3 순서로 처음 radius 안에 들어온 것을 쓴다.
+			const auto d1 = center - closest_point_on_segment(p0, e0, center);
+			const auto d2 = center - closest_point_on_segment(p1, e1, center);
+			const auto d3 = center - closest_point_on_segment(p2, e2, center);
+			const Lane radius_sq = radius * radius;
+			const auto m1 = dot(d1, d1) < radius_sq;
+			const auto m2 = dot(d2, d2) < radius_sq;
+			const auto m3 = dot(d3, d3) < radius_sq;
+			const auto edge_vec = select(m1, d1, select(m2, d2, d3));
+
+			const auto intersection = select(inside, center - point0, edge_vec);
+			const Lane len = sqrt(dot(intersection, intersection));
+			return { in_range & (inside | m1 | m2 | m3), radius - len, intersection / len };
+		}
+
+		// col_capsule_n_triangle 의 lane 버전.
+		template <typename Lane>
+		lane_hit_t<Lane> capsule_n_triangle_lanes(const capsule_segment_t& segment,
+		                                          const vec_lanes_t<Lane>& p0, const vec_lanes_t<Lane>& p1,
+		                                          const vec_lanes_t<Lane>& p2, const vec_lanes_t<Lane>& e0,
+		                                          const vec_lanes_t<Lane>& e1, const vec_lanes_t<Lane>& e2,
+		                                          const vec_lanes_t<Lane>& n) {
+			using vec_t = vec_lanes_t<Lane>;
+			const auto base = vec_t::broadcast(segment.base.x, segment.base.y, segment.base.z);
+			const auto axis = vec_t::broadcast(segment.axis.x, segment.axis.y, segment.axis.z);
+			const auto tip = vec_t::broadcast(segment.tip.x, segment.tip.y, segment.tip.z);
+
+			// capsule 축과 triangle 평면의 교점에서 가장 가까운 triangle 위의 점
+			const Lane n_dot_axis = dot(n, axis);
+			const auto line_plane_intersection = base + axis * (dot(n, p0 - base) / n_dot_axis);
+			const auto inside = inside_triangle(line_plane_intersection, p0, p1, p2, e0, e1, e2, n);
+			const auto q1 = closest_point_on_segment(p0, e0, line_plane_intersection);
+			const auto q2 = closest_point_on_segment(p1, e1, line_plane_intersection);
+			const auto q3 = closest_point_on_segment(p2, e2, line_plane_intersection);
+			const auto v1 = line_plane_intersection - q1;
+			const auto v2 = line_plane_intersection - q2;
+			const auto v3 = line_plane_intersection - q3;
+			const Lane s1 = dot(v1, v1);
+			const Lane s2 = dot(v2, v2);
+			const Lane s3 = dot(v3, v3);
+			const auto pick2 = s2 < s1;
+			const auto best12 = select(pick2, q2, q1);
+			const auto pick3 = s3 < min(s1, s2);
+			const auto edge_point = select(pick3, q3, best12);
+
+			auto reference_point = select(inside, line_plane_intersection, edge_point);
+			// 축과 평면이 평행하면 p0 를 기준으로 한다.
+			reference_point = select(n_dot_axis == Lane::broadcast(0.0), p0, reference_point);
+
+			const auto center = closest_point_on_segment(base, tip - base, reference_point);
+			const Lane radius = Lane::broadcast(segment.radius);
+			auto r = sphere_n_triangle_lanes(center, radius, p0, p1, p2, e0, e1, e2, n);
+
+			// 축이 triangle 을 관통한 경우. col_capsule_n_triangle 과 같이 capsule 중심 쪽의 면 법선을 쓴다.
+			const auto degenerate = radius - r.depth < Lane::broadcast(degenerate_contact_distance);
+			const auto mid = (base + tip) * Lane::broadcast(0.5);
+			const auto back_side = dot(mid - p0, n) < Lane::broadcast(0.0);
+			const auto face_normal = select(back_side, n * Lane::broadcast(-1.0), n);
+			r.normal = select(degenerate, face_normal, r.normal);
+			return r;
+		}
+
+		template <typename Lane, size_t N, typename Kernel>
+		std::optional<hit_data_t> deepest_in_batch(triangle_batch_t<N>& batch, Kernel&& kernel) {
+			if (batch.count == 0) return {};
+			batch.template prepare<Lane>();
+			alignas(32) double hit[N];
+			alignas(32) double depth[N];
+			alignas(32) double normal[3][N];
+			for (size_t i = 0; i < N; i += Lane::width) {
+				const auto r = kernel(vec_lanes_t<Lane>::load(batch.p0, i), vec_lanes_t<Lane>::load(batch.p1, i),
+				                      vec_lanes_t<Lane>::load(batch.p2, i), vec_lanes_t<Lane>::load(batch.e0, i),
+				                      vec_lanes_t<Lane>::load(batch.e1, i), vec_lanes_t<Lane>::load(batch.e2, i),
+				                      vec_lanes_t<Lane>::load(batch.normal, i));
+				select(r.hit, Lane::broadcast(1.0), Lane::broadcast(0.0)).store(&hit[i]);
+				r.depth.store(&depth[i]);
+				r.normal.store(normal, i);
+			}
+			std::optional<hit_data_t> deepest;
+			for (size_t i = 0; i < batch.count; ++i) {
+				if (hit[i] == 0.0) continue;
+				if (!deepest || depth[i] > deepest->penetration_depth) {
+					deepest = hit_data_t{ vec3_t{normal[0][i], normal[1][i], normal[2][i]}, depth[i] };
+				}
+			}
+			return deepest;
+		}
+	}
+
+	/**
+	 * \brief batch 의 triangle 들과 capsule 을 Lane 단위로 한번에 검사해 가장 깊은 hit 을 돌려줍니다.
+	 * col_capsule_n_triangle 과 같은 판정을 하며, 결과는 그 scalar 경로와 반올림 오차 안에서 같습니다.
+	 * \tparam Lane yc_simd::scalar_t / sse2_t / avx2_t. 기본은 compile 옵션에 맞는 native_t
+	 */
+	template <typename Lane = yc_simd::native_t, size_t N>
+	std::optional<hit_data_t> deepest_capsule_n_triangles(const capsule_segment_t& segment, triangle_batch_t<N>& batch) {
+		return detail::deepest_in_batch<Lane>(batch, [&](const auto&... tri) {
+			return detail::capsule_n_triangle_lanes<Lane>(segment, tri...);
+		});
+	}
+
+	/**
+	 * \brief batch 의 triangle 들과 sphere 를 Lane 단위로 한번에 검사해 가장 깊은 hit 을 돌려줍니다.
+	 */
+	template <typename Lane = yc_simd::native_t, size_t N>
+	std::optional<hit_data_t> deepest_sphere_n_triangles(const vec3_t& sphere_pos, const double radius,
+	                                                     triangle_batch_t<N>& batch) {
+		const auto center = detail::vec_lanes_t<Lane>::broadcast(sphere_pos.x, sphere_pos.y, sphere_pos.z);
+		return detail::deepest_in_batch<Lane>(batch, [&](const auto&... tri) {
+			return detail::sphere_n_triangle_lanes<Lane>(center, Lane::broadcast(radius), tri...);
+		});
+	}
+
+	/**
+	 * \brief sphere 와 heightfield 의 충돌. 중심 바로 아래 triangle 의 평면까지 거리로 판단하므로 triangle 을 돌지 않습니다.
+	 * 표면 아래로 완전히 들어간 sphere 도 위로 밀어내는 hit 을 돌려줍니다.
+	 * 중심 아래 triangle 과 다른 triangle 의 모서리에 먼저 닿는 경우(급한 경사, 꺾인 곳)는 놓칠 수 있습니다.
+	 */
+	inline std::optional<hit_data_t> col_sphere_n_heightfield(const vec3_t& sphere_pos, const terrain_t& terrain, const double radius) {
+		if (!terrain.contains(sphere_pos.x, sphere_pos.y)) return {};
+		const auto [surface_height, normal] = terrain.sample_surface(sphere_pos.x, sphere_pos.y);
+		// 수직 거리를 평면까지의 거리로 바꾼다.
+		const double dist = (sphere_pos.z - surface_height) * normal.z;
+		if (dist >= radius) return {};
+		return std::make_optional(hit_data_t{normal, radius - dist});
+	}
+
+	/**
+	 * \brief capsule 과 heightfield 의 충돌. capsule 축을 따라 cell 크기 간격으로 sphere 검사를 하고 가장 깊은 hit 을 돌려줍니다.
+	 * 서 있는 capsule 은 양 끝 두번의 sample 로 끝납니다.
+	 */
+	inline std::optional<hit_data_t> col_capsule_n_heightfield(const capsule_t& capsule, const rigid_body_t& rb,
+	                                                           const terrain_t& terrain) {
+		const vec3_t tip = rb.pos + rb.rot * vec3_t(0, 0, capsule.half_height);
+		const vec3_t base = rb.pos + rb.rot * vec3_t(0, 0, -capsule.half_height);
+		const double horizontal = std::hypot(tip.x - base.x, tip.y - base.y);
+		constexpr int max_samples = 9;
+		const int samples = std::clamp(static_cast<int>(std::ceil(horizontal / terrain.scale)) + 1, 2, max_samples);
+
+		std::optional<hit_data_t> deepest;
+		for (int i = 0; i < samples; ++i) {
+			const vec3_t center = base + (tip - base) * (static_cast<double>(i) / (samples - 1));
+			const auto hit = col_sphere_n_heightfield(center, terrain, capsule.radius);
+			if (hit && (!deepest || hit->penetration_depth > deepest->penetration_depth)) deepest = hit;
+		}
+		return deepest;
 	}
 	
-	inline std::vector<hit_data_t> col(
-		const rigid_body_t& rb,
-		const terrain_t& terrain) {
-		static auto get_cells_fm_terrain_to = [](const terrain_t& in_terrain, const vec3_t& xy) {
-			return &in_terrain.cells[xy.x + xy.y * (in_terrain.width - 1)];
+	/**
+	 * \brief rigid body 와 겹치는 terrain triangle 마다 충돌을 검사하고 hit 마다 on_hit(const hit_data_t&) 를 호출합니다.
+	 * heap 할당을 하지 않습니다. 여러 cell 에 걸친 사각형의 triangle 은 한번만 검사합니다.
+	 * \return hit 수
+	 */
+	template <typename OnHit>
+	size_t for_each_contact(const rigid_body_t& rb, const terrain_t& terrain, OnHit&& on_hit) {
+		YC_TRACE_ZONE("col");
+		size_t count = 0;
+		auto visit = [&](const vec3_t& min, const vec3_t& max, auto&& test) {
+			terrain.for_each_triangle(terrain.overlapping_cells(min.x, min.y, max.x, max.y), [&](const uint32_t tri) {
+				if (const auto hit = test(terrain.get_triangle(tri))) {
+					++count;
+					on_hit(*hit);
+				}
+			});
 		};
-		auto get_cells_to = std::bind_front(get_cells_fm_terrain_to, terrain);
 
-		std::vector<hit_data_t> r;
+		std::visit(loaded{
+			           [&](const capsule_t& capsule) {
+				           const capsule_segment_t segment(capsule, rb.pos, rb.rot);
+				           visit(segment.min_corner(), segment.max_corner(), [&](const triangle_t& triangle) {
+					           return col_capsule_n_triangle(segment, triangle);
+				           });
+			           },
+			           [&](const sphere_t& sphere) {
+				           const vec3_t r{sphere.radius, sphere.radius, sphere.radius};
+				           visit(rb.pos - r, rb.pos + r, [&](const triangle_t& triangle) {
+					           return col_sphere_n_triangle(rb.pos, triangle, sphere.radius);
+				           });
+			           }
+		           }, rb.target);
+		return count;
+	}
+
+	/**
+	 * \brief rigid body 와 terrain 의 충돌을 검사해 out 에 채웁니다. heap 할당을 하지 않습니다.
+	 * \return 찾은 hit 수. out 보다 크면 앞의 out.size() 개만 채워집니다.
+	 */
+	inline size_t col(const rigid_body_t& rb, const terrain_t& terrain, const std::span<hit_data_t> out) {
+		size_t count = 0;
+		for_each_contact(rb, terrain, [&](const hit_data_t& hit) {
+			if (count < out.size()) out[count] = hit;
+			++count;
+		});
+		return count;
+	}
+
+	/**
+	 * \brief rigid body 와 terrain 의 충돌 중 가장 깊은 것. triangle 을 batch 로 모아 SIMD kernel 로 검사합니다.
+	 * heap 할당을 하지 않습니다. physics_world::simulate 는 평평한 사각형 하나 위가 아닌 capsule 에 이 경로를 씁니다.
+	 */
+	inline std::optional<hit_data_t> deepest_contact(const rigid_body_t& rb, const terrain_t& terrain) {
+		YC_TRACE_ZONE("deepest_contact");
+		std::optional<hit_data_t> deepest;
+		triangle_batch_t<> batch;
+		auto visit = [&](const vec3_t& min, const vec3_t& max, auto&& kernel) {
+			auto flush = [&] {
+				const auto hit = kernel(batch);
+				if (hit && (!deepest || hit->penetration_depth > deepest->penetration_depth)) deepest = hit;
+				batch.clear();
+			};
+			terrain.for_each_triangle(terrain.overlapping_cells(min.x, min.y, max.x, max.y), [&](const uint32_t tri) {
+				batch.push(terrain.get_triangle(tri));
+				if (batch.full()) flush();
+			});
+			if (batch.count) flush();
+		};
 
 		std::visit(loaded{
 			           [&](const capsule_t& capsule) {
-				           for (const auto cell : get_capsule_cells(capsule, rb.pos, rb.rot, terrain) | std::views::transform(get_cells_to)) {
-					           for (auto& tri : cell->triangles) {
-					           	   auto hit = col_capsule_n_triangle(capsule, rb, tri);
-					               if(hit) r.push_back(hit.value());
-					           }
-				           }
+				           const capsule_segment_t segment(capsule, rb.pos, rb.rot);
+				           visit(segment.min_corner(), segment.max_corner(), [&](auto& b) {
+					           return deepest_capsule_n_triangles(segment, b);
+				           });
 			           },
-			           [](auto&&) {}
+			           [&](const sphere_t& sphere) {
+				           const vec3_t r{sphere.radius, sphere.radius, sphere.radius};
+				           visit(rb.pos - r, rb.pos + r, [&](auto& b) {
+					           return deepest_sphere_n_triangles(rb.pos, sphere.radius, b);
+				           });
+			           }
 		           }, rb.target);
+		return deepest;
+	}
+
+	/**
+	 * \brief capsule 과 terrain 의 충돌 중 가장 깊은 것.
+	 * capsule AABB 아래가 하나의 평평한 사각형이면 표면이 한 평면이므로 col_capsule_n_heightfield 로 바로 구하고,
+	 * 경사, 꺾인 곳, 벽처럼 면이 여럿이면 triangle 을 검사하는 deepest_contact 를 씁니다.
+	 */
+	inline std::optional<hit_data_t> deepest_capsule_contact(const capsule_t& capsule, const rigid_body_t& rb,
+	                                                         const terrain_t& terrain) {
+		const capsule_segment_t segment(capsule, rb.pos, rb.rot);
+		const vec3_t min = segment.min_corner();
+		const vec3_t max = segment.max_corner();
+		const auto range = terrain.overlapping_cells(min.x, min.y, max.x, max.y);
+		if (range.empty()) return {};
+		if (terrain.is_single_flat_quad(range)) return col_capsule_n_heightfield(capsule, rb, terrain);
+		return deepest_contact(rb, terrain);
+	}
 
+	/**
+	 * \brief rigid body 와 terrain 의 충돌을 검사합니다.
+	 * \param mr 결과를 할당할 memory resource. tick 안에서만 쓸 결과라면 yc_mem::tick_arena::local() 을 넘기고,
+	 * tick 이 끝난 뒤 호출한 쪽에서 reset 하세요. physics_world::step 은 자기 arena 만 reset 하므로 local() 은 건드리지 않습니다.
+	 */
+	inline std::pmr::vector<hit_data_t> col(
+		const rigid_body_t& rb,
+		const terrain_t& terrain,
+		std::pmr::memory_resource* mr = std::pmr::get_default_resource()) {
+		std::pmr::vector<hit_data_t> r(mr);
+		for_each_contact(rb, terrain, [&](const hit_data_t& hit) { r.push_back(hit); });
 		return r;
 	}
 
+	/**
+	 * \brief body 의 world AABB. broadphase 에 넣을 때 사용합니다.
+	 */
+	inline aabb_t get_aabb(const rigid_body_t& rb) {
+		return std::visit(loaded{
+			                  [&](const capsule_t& capsule) {
+				                  const capsule_segment_t segment(capsule, rb.pos, rb.rot);
+				                  return aabb_t{ segment.min_corner(), segment.max_corner() };
+			                  },
+			                  [&](const sphere_t& sphere) {
+				                  const vec3_t r(sphere.radius, sphere.radius, sphere.radius);
+				                  return aabb_t{ rb.pos - r, rb.pos + r };
+			                  }
+		                  }, rb.target);
+	}
+
+	namespace detail
+	{
+		// body 를 선분 + 반지름으로 본다. sphere 는 길이가 0인 선분이다.
+		inline std::pair<line_segment_t, double> get_core_segment(const rigid_body_t& rb) {
+			return std::visit(loaded{
+				                  [&](const capsule_t& capsule) {
+					                  const capsule_segment_t segment(capsule, rb.pos, rb.rot);
+					                  return std::pair{ line_segment_t(segment.base, segment.tip), segment.radius };
+				                  },
+				                  [&](const sphere_t& sphere) {
+					                  return std::pair{ line_segment_t(rb.pos, rb.pos), sphere.radius };
+				                  }
+			                  }, rb.target);
+		}
+	}
+
+	/**
+	 * \brief 두 body(capsule / sphere) 의 충돌. 두 선분의 가장 가까운 점 사이 거리로 판단합니다.
+	 * \return 법선은 b 에서 a 쪽을 향합니다. a 를 normal * depth 만큼 밀면 떨어집니다.
+	 */
+	inline std::optional<hit_data_t> col(const rigid_body_t& a, const rigid_body_t& b) {
+		const auto [a_segment, a_radius] = detail::get_core_segment(a);
+		const auto [b_segment, b_radius] = detail::get_core_segment(b);
+		const auto [pa, pb] = a_segment.closest_points(b_segment);
+		const vec3_t d = pa - pb;
+		const double dist = magnitude(d);
+		const double radius = a_radius + b_radius;
+		if (dist >= radius) return {};
+
+		vec3_t normal;
+		if (dist >= degenerate_contact_distance) normal = d / dist;
+		else {
+			// 두 축이 만나면 방향이 없으므로 중심끼리의 방향, 그것도 없으면 위로 민다.
+			const vec3_t center = a.pos - b.pos;
+			const double len = magnitude(center);
+			normal = len >= degenerate_contact_distance ? center / len : vec3_t(0, 0, 1);
+		}
+		return hit_data_t{ normal, radius - dist };
+	}
+
 	template <size_t TickRate>
 	class physics_world {
 		std::vector<rigid_body_t*> rigid_bodies;
 		std::vector<terrain_t*> terrains;
+		// proxy id 는 rigid_bodies 의 index 와 같다.
+		spatial_hash_grid_t broadphase;
 		std::chrono::time_point<std::chrono::steady_clock> physics_start_time;
 		size_t tick_count;
 		std::chrono::time_point<std::chrono::steady_clock> last_tick_time;
+		// tick 안에서만 쓰는 임시 목록(body pair 등). step 시작에 reset 한다.
+		// 호출한 쪽의 임시 데이터가 있을 수 있는 tick_arena::local() 대신 world 가 따로 가진다.
+		yc_mem::tick_arena tick_scratch{ 16 * 1024 };
 
 	public:
-		std::function<void(std::string)> log;
 		const double dsec = TickRate / 1000.0;
+		// 이 깊이 이하의 충돌은 맞닿은 것으로 보고 밀어내지 않는다.
+		static constexpr double contact_slop = 1e-9;
 
 	private:
+		/**
+		 * \brief 겹친 body 쌍을 밀어냅니다. 둘 다 simulate 하는 body 면 반씩, 하나만 simulate 하면 그쪽만 전부 밉니다.
+		 * pair 는 broadphase 로 찾으므로 body 수에 대해 선형입니다.
+		 */
+		void resolve_body_pairs() {
+			YC_TRACE_ZONE("physics_world::resolve_body_pairs");
+			for (uint32_t i = 0; i < rigid_bodies.size(); ++i) broadphase.update(i, get_aabb(*rigid_bodies[i]));
+			// pair 를 먼저 모으고 밀어낸다. pair 는 위에서 갱신한 AABB 로 정해지므로 순회 중에 미는 것과 결과가 같다.
+			std::pmr::vector<std::pair<uint32_t, uint32_t>> pairs(&tick_scratch);
+			pairs.reserve(rigid_bodies.size());
+			broadphase.for_each_pair([&](const uint32_t ia, const uint32_t ib) {
+				if (!rigid_bodies[ia]->use_physic_simulate && !rigid_bodies[ib]->use_physic_simulate) return;
+				pairs.emplace_back(ia, ib);
+			});
+			for (const auto& [ia, ib] : pairs) {
+				rigid_body_t& a = *rigid_bodies[ia];
+				rigid_body_t& b = *rigid_bodies[ib];
+				const auto hit = col(a, b);
+				if (!hit || hit->penetration_depth <= contact_slop) continue;
+				const double a_share = !b.use_physic_simulate ? 1.0 : a.use_physic_simulate ? 0.5 : 0.0;
+				a.pos += hit->penetration_normal * (hit->penetration_depth * a_share);
+				b.pos -= hit->penetration_normal * (hit->penetration_depth * (1.0 - a_share));
+			}
+		}
+
 		void simulate() {
+			YC_TRACE_ZONE("physics_world::simulate");
+			//update rigid body
+			for (const auto& rb : rigid_bodies) rb->pos += rb->vel * dsec;
+			// body 끼리 먼저 밀어내고, 밀려서 지형에 박힌 body 는 아래에서 지형 밖으로 꺼낸다.
+			resolve_body_pairs();
 			for (const auto& rb : rigid_bodies) {
-				//update rigid body
-				rb->pos += rb->vel * dsec;
 				for (const auto& terrain : terrains) {
 					std::visit(loaded{
 						           [&](capsule_t& capsule) {
-							           log("collision!");
-							           auto hit_result = col(*rb, *terrain);
-							           for (int i = 0; hit_result.size() && i < 10; ++i) {
-                                           const auto& [penetration_normal, penetration_depth] = hit_result.back();
-							           	   rb->pos -= penetration_normal * penetration_depth;
-										   hit_result = col(*rb, *terrain);
+							           // 가장 깊은 충돌부터 밀어낸다. 이미 맞닿아 있기만 한 충돌(깊이 contact_slop 이하)은 무시한다.
+							           // 평지 위에서는 heightfield 검사로 끝나고, 경사나 벽에 닿으면 triangle 을 검사한다.
+							           int i = 0;
+							           for (; i < 10; ++i) {
+								           const auto hit = deepest_capsule_contact(capsule, *rb, *terrain);
+								           if (!hit || hit->penetration_depth <= contact_slop) break;
+								           // 법선은 표면에서 body 쪽을 향한다.
+								           rb->pos += hit->penetration_normal * hit->penetration_depth;
+							           }
+							           if (i) YC_LOG_TRACE("collision! body {} resolved in {} steps", rb, i);
+						           },
+						           [&](sphere_t& sphere) {
+							           // 법선을 따라 밀어내면 한번에 빠져나오지만 밀린 곳의 경사가 다를 수 있어 몇번 반복한다.
+							           int i = 0;
+							           for (; i < 4; ++i) {
+								           const auto hit = col_sphere_n_heightfield(rb->pos, *terrain, sphere.radius);
+								           if (!hit || hit->penetration_depth <= contact_slop) break;
+								           rb->pos += hit->penetration_normal * hit->penetration_depth;
 							           }
+							           if (i) YC_LOG_TRACE("collision! body {} resolved in {} steps", rb, i);
 						           },
 						           [&](auto&&) {
-							           log(std::format("No collision!, Typename : {}",
-							                           typeid(decltype(rb->target)).name()));
+							           YC_LOG_DEBUG("No collision!, body {} shape index : {}", rb, rb->target.index());
 						           }
 					           }, rb->target);
 				}
@@ -561,27 +1193,65 @@ namespace yc_physics
 		}
 
 	public:
-		physics_world(): tick_count(0) {
-			physics_start_time = std::chrono::high_resolution_clock::now();
-			last_tick_time = std::chrono::high_resolution_clock::now();
+		/**
+		 * \param body_cell_size body 끼리 충돌에 쓰는 broadphase 격자 크기. body 지름보다 약간 크게 잡습니다.
+		 */
+		explicit physics_world(const double body_cell_size = 4.0): broadphase(body_cell_size), tick_count(0) {
+			physics_start_time = std::chrono::steady_clock::now();
+			last_tick_time = std::chrono::steady_clock::now();
+		}
+
+		void add_rigid_body(rigid_body_t* rigid) {
+			rigid_bodies.push_back(rigid);
+			broadphase.add(get_aabb(*rigid));
 		}
 
-		void add_rigid_body(rigid_body_t* rigid) { rigid_bodies.push_back(rigid); }
+		/**
+		 * \brief body 를 world 에서 뺍니다. 마지막 body 를 빈 자리로 옮기므로 body 순서는 유지되지 않습니다.
+		 * \return world 에 없는 body 면 false
+		 */
+		bool remove_rigid_body(rigid_body_t* rigid) {
+			const auto it = std::find(rigid_bodies.begin(), rigid_bodies.end(), rigid);
+			if (it == rigid_bodies.end()) return false;
+			// broadphase 도 마지막 proxy 를 빈 자리로 옮기므로 proxy id 와 index 가 계속 같다.
+			broadphase.remove(static_cast<uint32_t>(it - rigid_bodies.begin()));
+			*it = rigid_bodies.back();
+			rigid_bodies.pop_back();
+			return true;
+		}
 		void add_terrain(terrain_t* terrain) { terrains.push_back(terrain); }
 
 		double get_next_physics_time_tick() const { return (tick_count + 1) * dsec; }
 
 		double get_cur_time_sec() const {
 			return std::chrono::duration_cast<std::chrono::milliseconds>(
-				std::chrono::high_resolution_clock::now() - physics_start_time).count() / 1000.0;
+				std::chrono::steady_clock::now() - physics_start_time).count() / 1000.0;
 		}
 
+		/**
+		 * \brief 시간과 상관없이 tick 하나를 진행합니다.
+		 */
+		void step() {
+			YC_METRICS(
+				static auto& tick_ns = yc_metrics::latency("yc_physics_tick_ns", "physics tick 한번에 걸린 시간");
+				const yc_metrics::scoped_timer_t timer(tick_ns);
+			)
+			// 지난 tick 의 임시 목록을 버린다. 사용량이 안정되면 더이상 할당하지 않는다.
+			tick_scratch.reset();
+			simulate();
+			tick_count++;
+		}
+
+		/**
+		 * \brief 한 tick 에 임시 목록으로 쓴 최대 byte 수.
+		 */
+		size_t tick_scratch_peak_bytes() const { return tick_scratch.peak_bytes(); }
+
 		void simulate_physics() {
 			double sec = get_cur_time_sec() - tick_count * dsec;
 			while (sec >= dsec) {
-				simulate();
+				step();
 				sec -= dsec;
-				tick_count++;
 			}
 		}
 	};
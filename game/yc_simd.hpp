@@ -0,0 +1,182 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/**
+ * \brief double lane 묶음 추상화. 같은 kernel 을 scalar / SSE2 / AVX2 로 compile 할 수 있게 합니다.
+ * 모든 lane 타입은 width, mask_t, load / broadcast / store, 사칙연산, 비교(mask 반환), sqrt / abs / min / max, select 를 가집니다.
+ * native_t 는 compile 옵션에서 쓸 수 있는 가장 넓은 타입입니다. (-mavx2 면 AVX2, x86-64 기본은 SSE2)
+ * YC_SIMD_FORCE_SCALAR 를 정의하면 native_t 가 scalar_t 가 됩니다.
+ */
+namespace yc_simd
+{
+    /////// scalar /////
+    struct scalar_mask_t {
+        bool m;
+    };
+    inline scalar_mask_t operator&(const scalar_mask_t a, const scalar_mask_t b) { return {a.m && b.m}; }
+    inline scalar_mask_t operator|(const scalar_mask_t a, const scalar_mask_t b) { return {a.m || b.m}; }
+    inline scalar_mask_t operator~(const scalar_mask_t a) { return {!a.m}; }
+    inline bool any(const scalar_mask_t a) { return a.m; }
+
+    struct scalar_t {
+        using mask_t = scalar_mask_t;
+        static constexpr size_t width = 1;
+        double v;
+
+        static scalar_t load(const double* p) { return {*p}; }
+        static scalar_t broadcast(const double x) { return {x}; }
+        void store(double* p) const { *p = v; }
+    };
+    inline scalar_t operator+(const scalar_t a, const scalar_t b) { return {a.v + b.v}; }
+    inline scalar_t operator-(const scalar_t a, const scalar_t b) { return {a.v - b.v}; }
+    inline scalar_t operator*(const scalar_t a, const scalar_t b) { return {a.v * b.v}; }
+    inline scalar_t operator/(const scalar_t a, const scalar_t b) { return {a.v / b.v}; }
+    inline scalar_mask_t operator<(const scalar_t a, const scalar_t b) { return {a.v < b.v}; }
+    inline scalar_mask_t operator<=(const scalar_t a, const scalar_t b) { return {a.v <= b.v}; }
+    inline scalar_mask_t operator>(const scalar_t a, const scalar_t b) { return {a.v > b.v}; }
+    inline scalar_mask_t operator==(const scalar_t a, const scalar_t b) { return {a.v == b.v}; }
+    inline scalar_t sqrt(const scalar_t a) { return {std::sqrt(a.v)}; }
+    inline scalar_t abs(const scalar_t a) { return {std::fabs(a.v)}; }
+    inline scalar_t min(const scalar_t a, const scalar_t b) { return {a.v < b.v ? a.v : b.v}; }
+    inline scalar_t max(const scalar_t a, const scalar_t b) { return {a.v > b.v ? a.v : b.v}; }
+    inline scalar_t select(const scalar_mask_t m, const scalar_t a, const scalar_t b) { return m.m ? a : b; }
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define YC_SIMD_HAS_SSE2
+    /////// SSE2 (double 2개) /////
+    struct sse2_mask_t {
+        __m128d m;
+    };
+    inline sse2_mask_t operator&(const sse2_mask_t a, const sse2_mask_t b) { return {_mm_and_pd(a.m, b.m)}; }
+    inline sse2_mask_t operator|(const sse2_mask_t a, const sse2_mask_t b) { return {_mm_or_pd(a.m, b.m)}; }
+    inline sse2_mask_t operator~(const sse2_mask_t a) { return {_mm_xor_pd(a.m, _mm_castsi128_pd(_mm_set1_epi32(-1)))}; }
+    inline bool any(const sse2_mask_t a) { return _mm_movemask_pd(a.m) != 0; }
+
+    struct sse2_t {
+        using mask_t = sse2_mask_t;
+        static constexpr size_t width = 2;
+        __m128d v;
+
+        static sse2_t load(const double* p) { return {_mm_loadu_pd(p)}; }
+        static sse2_t broadcast(const double x) { return {_mm_set1_pd(x)}; }
+        void store(double* p) const { _mm_storeu_pd(p, v); }
+    };
+    inline sse2_t operator+(const sse2_t a, const sse2_t b) { return {_mm_add_pd(a.v, b.v)}; }
+    inline sse2_t operator-(const sse2_t a, const sse2_t b) { return {_mm_sub_pd(a.v, b.v)}; }
+    inline sse2_t operator*(const sse2_t a, const sse2_t b) { return {_mm_mul_pd(a.v, b.v)}; }
+    inline sse2_t operator/(const sse2_t a, const sse2_t b) { return {_mm_div_pd(a.v, b.v)}; }
+    inline sse2_mask_t operator<(const sse2_t a, const sse2_t b) { return {_mm_cmplt_pd(a.v, b.v)}; }
+    inline sse2_mask_t operator<=(const sse2_t a, const sse2_t b) { return {_mm_cmple_pd(a.v, b.v)}; }
+    inline sse2_mask_t operator>(const sse2_t a, const sse2_t b) { return {_mm_cmpgt_pd(a.v, b.v)}; }
+    inline sse2_mask_t operator==(const sse2_t a, const sse2_t b) { return {_mm_cmpeq_pd(a.v, b.v)}; }
+    inline sse2_t sqrt(const sse2_t a) { return {_mm_sqrt_pd(a.v)}; }
+    inline sse2_t abs(const sse2_t a) { return {_mm_andnot_pd(_mm_set1_pd(-0.0), a.v)}; }
+    inline sse2_t min(const sse2_t a, const sse2_t b) { return {_mm_min_pd(a.v, b.v)}; }
+    inline sse2_t max(const sse2_t a, const sse2_t b) { return {_mm_max_pd(a.v, b.v)}; }
+    inline sse2_t select(const sse2_mask_t m, const sse2_t a, const sse2_t b) {
+        return {_mm_or_pd(_mm_and_pd(m.m, a.v), _mm_andnot_pd(m.m, b.v))};
+    }
+#endif
+
+#if defined(__AVX2__)
+#define YC_SIMD_HAS_AVX2
+    /////// AVX2 (double 4개) /////
+    struct avx2_mask_t {
+        __m256d m;
+    };
+    inline avx2_mask_t operator&(const avx2_mask_t a, const avx2_mask_t b) { return {_mm256_and_pd(a.m, b.m)}; }
+    inline avx2_mask_t operator|(const avx2_mask_t a, const avx2_mask_t b) { return {_mm256_or_pd(a.m, b.m)}; }
+    inline avx2_mask_t operator~(const avx2_mask_t a) {
+        return {_mm256_xor_pd(a.m, _mm256_castsi256_pd(_mm256_set1_epi32(-1)))};
+    }
+    inline bool any(const avx2_mask_t a) { return _mm256_movemask_pd(a.m) != 0; }
+
+    struct avx2_t {
+        using mask_t = avx2_mask_t;
+        static constexpr size_t width = 4;
+        __m256d v;
+
+        static avx2_t load(const double* p) { return {_mm256_loadu_pd(p)}; }
+        static avx2_t broadcast(const double x) { return {_mm256_set1_pd(x)}; }
+        void store(double* p) const { _mm256_storeu_pd(p, v); }
+    };
+    inline avx2_t operator+(const avx2_t a, const avx2_t b) { return {_mm256_add_pd(a.v, b.v)}; }
+    inline avx2_t operator-(const avx2_t a, const avx2_t b) { return {_mm256_sub_pd(a.v, b.v)}; }
+    inline avx2_t operator*(const avx2_t a, const avx2_t b) { return {_mm256_mul_pd(a.v, b.v)}; }
+    inline avx2_t operator/(const avx2_t a, const avx2_t b) { return {_mm256_div_pd(a.v, b.v)}; }
+    inline avx2_mask_t operator<(const avx2_t a, const avx2_t b) { return {_mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ)}; }
+    inline avx2_mask_t operator<=(const avx2_t a, const avx2_t b) { return {_mm256_cmp_pd(a.v, b.v, _CMP_LE_OQ)}; }
+    inline avx2_mask_t operator>(const avx2_t a, const avx2_t b) { return {_mm256_cmp_pd(a.v, b.v, _CMP_GT_OQ)}; }
+    inline avx2_mask_t operator==(const avx2_t a, const avx2_t b) { return {_mm256_cmp_pd(a.v, b.v, _CMP_EQ_OQ)}; }
+    inline avx2_t sqrt(const avx2_t a) { return {_mm256_sqrt_pd(a.v)}; }
+    inline avx2_t abs(const avx2_t a) { return {_mm256_andnot_pd(_mm256_set1_pd(-0.0), a.v)}; }
+    inline avx2_t min(const avx2_t a, const avx2_t b) { return {_mm256_min_pd(a.v, b.v)}; }
+    inline avx2_t max(const avx2_t a, const avx2_t b) { return {_mm256_max_pd(a.v, b.v)}; }
+    inline avx2_t select(const avx2_mask_t m, const avx2_t a, const avx2_t b) { return {_mm256_blendv_pd(b.v, a.v, m.m)}; }
+#endif
+
+#if defined(YC_SIMD_FORCE_SCALAR)
+    using native_t = scalar_t;
+#elif defined(YC_SIMD_HAS_AVX2)
+    using native_t = avx2_t;
+#elif defined(YC_SIMD_HAS_SSE2)
+    using native_t = sse2_t;
+#else
+    using native_t = scalar_t;
+#endif
+
+    template <typename Lane>
+    Lane saturate(const Lane a) { return min(max(a, Lane::broadcast(0.0)), Lane::broadcast(1.0)); }
+
+    /**
+     * \brief lane 별 3차원 벡터. x, y, z 가 각각 lane 묶음입니다.
+     */
+    template <typename Lane>
+    struct vec3_lanes_t {
+        Lane x, y, z;
+
+        static vec3_lanes_t broadcast(const double bx, const double by, const double bz) {
+            return {Lane::broadcast(bx), Lane::broadcast(by), Lane::broadcast(bz)};
+        }
+        // soa[축][lane] 에서 i 번째 lane 부터 읽는다.
+        template <size_t N>
+        static vec3_lanes_t load(const double (&soa)[3][N], const size_t i) {
+            return {Lane::load(&soa[0][i]), Lane::load(&soa[1][i]), Lane::load(&soa[2][i])};
+        }
+        template <size_t N>
+        void store(double (&soa)[3][N], const size_t i) const {
+            x.store(&soa[0][i]);
+            y.store(&soa[1][i]);
+            z.store(&soa[2][i]);
+        }
+    };
+
+    template <typename Lane>
+    vec3_lanes_t<Lane> operator+(const vec3_lanes_t<Lane>& a, const vec3_lanes_t<Lane>& b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+    template <typename Lane>
+    vec3_lanes_t<Lane> operator-(const vec3_lanes_t<Lane>& a, const vec3_lanes_t<Lane>& b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+    template <typename Lane>
+    vec3_lanes_t<Lane> operator*(const vec3_lanes_t<Lane>& a, const Lane s) { return {a.x * s, a.y * s, a.z * s}; }
+    template <typename Lane>
+    vec3_lanes_t<Lane> operator/(const vec3_lanes_t<Lane>& a, const Lane s) { return {a.x / s, a.y / s, a.z / s}; }
+    template <typename Lane>
+    Lane dot(const vec3_lanes_t<Lane>& a, const vec3_lanes_t<Lane>& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+    template <typename Lane>
+    vec3_lanes_t<Lane> cross(const vec3_lanes_t<Lane>& a, const vec3_lanes_t<Lane>& b) {
+        return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+    }
+    template <typename Lane>
+    vec3_lanes_t<Lane> normalize(const vec3_lanes_t<Lane>& a) { return a / sqrt(dot(a, a)); }
+    template <typename Lane>
+    vec3_lanes_t<Lane> select(const typename Lane::mask_t m, const vec3_lanes_t<Lane>& a, const vec3_lanes_t<Lane>& b) {
+        return {select(m, a.x, b.x), select(m, a.y, b.y), select(m, a.z, b.z)};
+    }
+}
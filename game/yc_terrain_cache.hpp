@@ -0,0 +1,292 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "yc_physics.hpp"
+
+/**
+ * \brief build 한 terrain 을 파일로 저장하고 다시 build 없이 읽어옵니다.
+ * 파일에는 높이와 triangle / cell index 만 있고 위치(root_pos) 와 scale 은 없으므로 어디에 놓든 같은 파일을 씁니다.
+ * POSIX 에서는 파일을 읽기 전용으로 mmap 해서 충돌 검사가 mapping 을 그대로 읽습니다.
+ * 같은 파일을 여는 process 들은 page cache 의 같은 page 를 공유합니다.
+ *
+ * load_or_build_terrain(terrain, "map01.terrain", heightmap, width, height, scale);
+ */
+namespace yc_physics
+{
+	// 2: build 가 합칠 수 없는 모서리 cell 을 사각형에 넣던 문제를 고쳤다. 이전 cache 는 다시 만든다.
+	constexpr uint32_t terrain_cache_version = 2;
+
+	/**
+	 * \brief cache 파일의 맨 앞에 오는 header. 각 section 은 파일 시작 기준 offset 에 있고 64 byte 로 정렬됩니다.
+	 */
+	struct terrain_cache_header_t {
+		char magic[8];
+		uint32_t version;
+		// 0x01020304. 다른 endian 에서 만든 파일을 걸러낸다.
+		uint32_t endian;
+		// 원본 heightmap 의 hash. heightmap 이 바뀌었는지 확인할 때 쓴다.
+		uint64_t source_hash;
+		int32_t width;
+		int32_t height;
+		uint64_t heights_offset;
+		uint64_t heights_count;
+		uint64_t triangle_indices_offset;
+		uint64_t triangle_indices_count;
+		uint64_t cell_first_triangle_offset;
+		uint64_t cell_first_triangle_count;
+		uint64_t file_size;
+	};
+	static_assert(std::is_trivially_copyable_v<terrain_cache_header_t>);
+
+	namespace detail
+	{
+		inline constexpr char terrain_cache_magic[8] = { 'Y', 'C', 'T', 'E', 'R', 'R', 'N', '\0' };
+		constexpr uint32_t terrain_cache_endian = 0x01020304;
+		constexpr uint64_t terrain_cache_alignment = 64;
+
+		inline uint64_t align_cache_offset(const uint64_t offset) {
+			return (offset + terrain_cache_alignment - 1) / terrain_cache_alignment * terrain_cache_alignment;
+		}
+
+		// 파일 전체 또는 읽은 buffer. terrain 의 span 이 가리키는 동안 살아있어야 한다.
+		struct terrain_cache_file_t {
+			const std::byte* data = nullptr;
+			size_t size = 0;
+			std::vector<std::byte> buffer;
+			bool is_mapped = false;
+
+			terrain_cache_file_t() = default;
+			terrain_cache_file_t(const terrain_cache_file_t&) = delete;
+			terrain_cache_file_t& operator=(const terrain_cache_file_t&) = delete;
+
+			~terrain_cache_file_t() {
+#if defined(__unix__) || defined(__APPLE__)
+				if (is_mapped) munmap(const_cast<std::byte*>(data), size);
+#endif
+			}
+		};
+
+		inline std::shared_ptr<terrain_cache_file_t> open_terrain_cache(const std::string& path) {
+			auto file = std::make_shared<terrain_cache_file_t>();
+#if defined(__unix__) || defined(__APPLE__)
+			const int fd = ::open(path.c_str(), O_RDONLY);
+			if (fd < 0) return nullptr;
+			struct stat st {};
+			if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+				::close(fd);
+				return nullptr;
+			}
+			void* p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+			// mapping 은 fd 를 닫아도 유지된다.
+			::close(fd);
+			if (p == MAP_FAILED) return nullptr;
+			file->data = static_cast<const std::byte*>(p);
+			file->size = static_cast<size_t>(st.st_size);
+			file->is_mapped = true;
+#else
+			std::ifstream f(path, std::ios::binary | std::ios::ate);
+			if (!f) return nullptr;
+			file->buffer.resize(static_cast<size_t>(f.tellg()));
+			f.seekg(0);
+			if (!f.read(reinterpret_cast<char*>(file->buffer.data()), static_cast<std::streamsize>(file->buffer.size()))) return nullptr;
+			file->data = file->buffer.data();
+			file->size = file->buffer.size();
+#endif
+			return file;
+		}
+
+		/**
+		 * \brief path 와 같은 directory 에 다른 process / thread 와 겹치지 않는 임시 파일을 만듭니다.
+		 * \return 만든 파일 이름. 만들지 못하면 빈 문자열
+		 */
+		inline std::string create_temp_cache_file(const std::string& path) {
+#if defined(__unix__) || defined(__APPLE__)
+			std::string tmp = path + ".XXXXXX";
+			const int fd = mkstemp(tmp.data());
+			if (fd < 0) return {};
+			// mkstemp 는 0600 으로 만든다. 다른 사용자의 process 도 cache 를 읽을 수 있게 한다.
+			fchmod(fd, 0644);
+			::close(fd);
+			return tmp;
+#else
+			std::random_device rd;
+			for (int attempt = 0; attempt < 16; ++attempt) {
+				std::string tmp = path + "." + std::to_string(rd()) + ".tmp";
+				if (std::ifstream(tmp)) continue;
+				if (std::ofstream(tmp, std::ios::binary)) return tmp;
+			}
+			return {};
+#endif
+		}
+
+		inline bool is_valid_section(const terrain_cache_header_t& header, const uint64_t offset, const uint64_t count,
+		                             const uint64_t element_size) {
+			if (offset % terrain_cache_alignment != 0) return false;
+			if (count > header.file_size / element_size) return false;
+			return offset <= header.file_size && count * element_size <= header.file_size - offset;
+		}
+	}
+
+	/**
+	 * \brief heightmap 과 크기로 cache 가 같은 원본에서 만들어졌는지 확인할 hash 를 만듭니다.
+	 * 8 byte 씩 섞으므로 heightmap 한번 읽는 비용입니다.
+	 */
+	inline uint64_t hash_heightmap(const uint8_t* heightmap, const int width, const int height) {
+		constexpr uint64_t prime = 0x100000001b3ull;
+		uint64_t h = 0xcbf29ce484222325ull;
+		auto mix = [&](const uint64_t v) {
+			h = (h ^ v) * prime;
+			h ^= h >> 29;
+		};
+		mix(static_cast<uint32_t>(width));
+		mix(static_cast<uint32_t>(height));
+		const size_t size = static_cast<size_t>(std::max(width, 0)) * std::max(height, 0);
+		size_t i = 0;
+		for (; i + 8 <= size; i += 8) {
+			uint64_t v;
+			std::memcpy(&v, heightmap + i, 8);
+			mix(v);
+		}
+		for (; i < size; i++) mix(heightmap[i]);
+		return h;
+	}
+
+	/**
+	 * \brief build 한 terrain 을 cache 파일로 저장합니다. 같은 directory 의 임시 파일에 쓴 뒤 rename 하므로
+	 * 다른 process 가 읽고 있는 파일을 덮어써도 그 process 의 mapping 은 깨지지 않습니다.
+	 * 임시 파일 이름은 매번 달라서 여러 process 가 동시에 저장해도 서로의 파일을 덮어쓰지 않습니다.
+	 * \param source_hash hash_heightmap 으로 만든 원본 hash
+	 * \return 파일을 쓰지 못하면 false
+	 */
+	inline bool save_terrain_cache(const terrain_t& terrain, const std::string& path, const uint64_t source_hash) {
+		terrain_cache_header_t header {};
+		std::memcpy(header.magic, detail::terrain_cache_magic, sizeof(header.magic));
+		header.version = terrain_cache_version;
+		header.endian = detail::terrain_cache_endian;
+		header.source_hash = source_hash;
+		header.width = terrain.width;
+		header.height = terrain.height;
+		header.heights_offset = detail::align_cache_offset(sizeof(header));
+		header.heights_count = terrain.heights.size();
+		header.triangle_indices_offset = detail::align_cache_offset(header.heights_offset + header.heights_count);
+		header.triangle_indices_count = terrain.triangle_indices.size();
+		header.cell_first_triangle_offset = detail::align_cache_offset(
+			header.triangle_indices_offset + header.triangle_indices_count * sizeof(uint32_t));
+		header.cell_first_triangle_count = terrain.cell_first_triangle.size();
+		header.file_size = header.cell_first_triangle_offset + header.cell_first_triangle_count * sizeof(uint32_t);
+
+		const std::string tmp = detail::create_temp_cache_file(path);
+		if (tmp.empty()) return false;
+		{
+			std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+			if (!f) {
+				std::remove(tmp.c_str());
+				return false;
+			}
+			auto write_at = [&f](const uint64_t offset, const void* data, const size_t bytes) {
+				static constexpr char zeros[detail::terrain_cache_alignment] {};
+				const auto pos = static_cast<uint64_t>(f.tellp());
+				f.write(zeros, static_cast<std::streamsize>(offset - pos));
+				f.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+			};
+			write_at(0, &header, sizeof(header));
+			write_at(header.heights_offset, terrain.heights.data(), terrain.heights.size_bytes());
+			write_at(header.triangle_indices_offset, terrain.triangle_indices.data(), terrain.triangle_indices.size_bytes());
+			write_at(header.cell_first_triangle_offset, terrain.cell_first_triangle.data(), terrain.cell_first_triangle.size_bytes());
+			f.close();
+			if (!f) {
+				std::remove(tmp.c_str());
+				return false;
+			}
+		}
+		if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+			std::remove(tmp.c_str());
+			return false;
+		}
+		return true;
+	}
+
+	/**
+	 * \brief cache 파일을 mapping 해서 terrain 에 붙입니다. terrain 의 root_pos 는 그대로 둡니다.
+	 * header 와 section 크기를 검사하고, index 들이 범위 안에 있는지 한번 훑어 확인합니다.
+	 * 높이 값과 mesh 모양은 검사하지 않으므로 source_hash 로 원본이 같은지 확인하는 것이 좋습니다.
+	 * \param scale terrain 의 scale
+	 * \param source_hash 주어지면 파일의 원본 hash 와 다를 때 실패합니다.
+	 * \return 파일이 없거나 version / 크기가 맞지 않으면 false. 이때 terrain 은 바뀌지 않습니다.
+	 */
+	inline bool load_terrain_cache(terrain_t& terrain, const std::string& path, const double scale,
+	                               const std::optional<uint64_t> source_hash = std::nullopt) {
+		YC_TRACE_ZONE("load_terrain_cache");
+		auto file = detail::open_terrain_cache(path);
+		if (!file || file->size < sizeof(terrain_cache_header_t)) return false;
+
+		terrain_cache_header_t header;
+		std::memcpy(&header, file->data, sizeof(header));
+		if (std::memcmp(header.magic, detail::terrain_cache_magic, sizeof(header.magic)) != 0) return false;
+		if (header.version != terrain_cache_version || header.endian != detail::terrain_cache_endian) return false;
+		if (source_hash && header.source_hash != *source_hash) return false;
+		if (header.file_size != file->size || header.width < 0 || header.height < 0) return false;
+
+		const uint64_t cell_count = static_cast<uint64_t>(std::max(header.width - 1, 0)) * std::max(header.height - 1, 0);
+		if (header.heights_count != static_cast<uint64_t>(header.width) * header.height) return false;
+		if (header.cell_first_triangle_count != cell_count) return false;
+		if (header.triangle_indices_count % 3 != 0) return false;
+		if (!detail::is_valid_section(header, header.heights_offset, header.heights_count, sizeof(uint8_t)) ||
+			!detail::is_valid_section(header, header.triangle_indices_offset, header.triangle_indices_count, sizeof(uint32_t)) ||
+			!detail::is_valid_section(header, header.cell_first_triangle_offset, header.cell_first_triangle_count, sizeof(uint32_t)))
+			return false;
+
+		const std::byte* base = file->data;
+		const std::span<const uint32_t> triangle_indices {
+			reinterpret_cast<const uint32_t*>(base + header.triangle_indices_offset), header.triangle_indices_count };
+		const std::span<const uint32_t> cell_first_triangle {
+			reinterpret_cast<const uint32_t*>(base + header.cell_first_triangle_offset), header.cell_first_triangle_count };
+
+		// 잘못된 index 는 충돌 검사에서 범위 밖을 읽게 되므로 붙이기 전에 걸러낸다.
+		const uint64_t triangle_count = header.triangle_indices_count / 3;
+		for (const uint32_t index : triangle_indices) {
+			if (index >= header.heights_count) return false;
+		}
+		for (const uint32_t first : cell_first_triangle) {
+			if (first + static_cast<uint64_t>(terrain_t::triangles_per_cell) > triangle_count) return false;
+		}
+
+		terrain.attach(header.width, header.height, scale,
+		               { reinterpret_cast<const uint8_t*>(base + header.heights_offset), header.heights_count },
+		               triangle_indices, cell_first_triangle, std::move(file));
+		return true;
+	}
+
+	/**
+	 * \brief cache 가 같은 heightmap 으로 만들어졌으면 읽고, 아니면 build 해서 cache 를 새로 씁니다.
+	 * cache 를 쓰지 못해도 build 한 terrain 은 사용할 수 있습니다.
+	 * \return build 가 실패한 경우에만 false
+	 */
+	inline bool load_or_build_terrain(terrain_t& terrain, const std::string& path, const uint8_t* heightmap,
+	                                  const int width, const int height, const double scale,
+	                                  test_thread_pool* pool = nullptr) {
+		const uint64_t source_hash = hash_heightmap(heightmap, width, height);
+		if (load_terrain_cache(terrain, path, scale, source_hash)) return true;
+		if (!terrain.build(heightmap, width, height, scale, pool)) return false;
+		if (!save_terrain_cache(terrain, path, source_hash)) {
+			YC_LOG_WARN("terrain cache {} 를 쓰지 못했습니다.", path.c_str());
+		}
+		return true;
+	}
+}
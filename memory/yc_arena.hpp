@@ -0,0 +1,108 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <vector>
+
+namespace yc_mem
+{
+    /**
+     * \brief 한 tick 동안만 사는 임시 데이터를 위한 monotonic arena.
+     * 할당은 pointer 를 밀기만 하고 해제는 아무것도 하지 않습니다. tick 이 끝나면 reset 으로 한번에 되돌립니다.
+     * reset 은 block 을 돌려주지 않고 재사용하므로 사용량이 안정된 뒤에는 global new 를 부르지 않습니다.
+     * std::pmr::memory_resource 이므로 std::pmr::vector 등에 그대로 넘길 수 있습니다.
+     * [*** 중요! ***] thread safe 하지 않습니다. thread 마다 local() 을 사용하세요.
+     */
+    class tick_arena : public std::pmr::memory_resource {
+        struct block_t {
+            std::byte* data;
+            size_t size;
+        };
+
+        std::vector<block_t> blocks_;
+        size_t current_ = 0;
+        size_t offset_ = 0;
+        size_t block_size_;
+        // 이번 tick 에 사용한 byte 수. reset 때 block 을 하나로 합칠 크기를 정한다.
+        size_t used_ = 0;
+        size_t peak_ = 0;
+
+        static std::byte* new_block(const size_t size) {
+            return static_cast<std::byte*>(::operator new(size, std::align_val_t{alignof(std::max_align_t)}));
+        }
+        static void delete_block(const block_t& b) {
+            ::operator delete(b.data, std::align_val_t{alignof(std::max_align_t)});
+        }
+
+    protected:
+        void* do_allocate(const size_t bytes, const size_t alignment) override {
+            while (true) {
+                if (current_ < blocks_.size()) {
+                    auto& b = blocks_[current_];
+                    const auto base = reinterpret_cast<uintptr_t>(b.data);
+                    const uintptr_t p = (base + offset_ + alignment - 1) & ~(uintptr_t{alignment} - 1);
+                    if (p + bytes <= base + b.size) {
+                        used_ += p + bytes - (base + offset_);
+                        offset_ = p + bytes - base;
+                        return reinterpret_cast<void*>(p);
+                    }
+                    if (current_ + 1 < blocks_.size()) {
+                        ++current_;
+                        offset_ = 0;
+                        continue;
+                    }
+                }
+                const size_t last = blocks_.empty() ? block_size_ : blocks_.back().size * 2;
+                const size_t size = last > bytes + alignment ? last : bytes + alignment;
+                blocks_.push_back(block_t{ new_block(size), size });
+                current_ = blocks_.size() - 1;
+                offset_ = 0;
+            }
+        }
+
+        void do_deallocate(void*, size_t, size_t) override { }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+
+    public:
+        explicit tick_arena(const size_t block_size = 64 * 1024) : block_size_(block_size) { }
+        ~tick_arena() override {
+            for (auto& b : blocks_) delete_block(b);
+        }
+        tick_arena(const tick_arena&) = delete;
+        tick_arena& operator=(const tick_arena&) = delete;
+
+        /**
+         * \brief tick 경계에서 호출합니다. 이 arena 에서 할당한 메모리는 더이상 사용해서는 안됩니다.
+         * 이번 tick 에 block 이 여러개 필요했다면 다음 tick 부터는 하나의 큰 block 을 사용합니다.
+         */
+        void reset() {
+            if (used_ > peak_) peak_ = used_;
+            if (blocks_.size() > 1) {
+                size_t total = 0;
+                for (auto& b : blocks_) {
+                    total += b.size;
+                    delete_block(b);
+                }
+                blocks_.clear();
+                blocks_.push_back(block_t{ new_block(total), total });
+            }
+            current_ = 0;
+            offset_ = 0;
+            used_ = 0;
+        }
+
+        size_t peak_bytes() const { return peak_ > used_ ? peak_ : used_; }
+
+        /**
+         * \brief 현재 thread 의 arena.
+         */
+        static tick_arena& local() {
+            thread_local tick_arena arena;
+            return arena;
+        }
+    };
+}
@@ -0,0 +1,213 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <vector>
+
+/**
+ * \brief packet, task, rigid body 처럼 자주 할당되는 작은 객체를 위한 size class pool allocator.
+ * thread 마다 cache 를 가지고 있어 같은 thread 의 할당/해제는 lock 이 없습니다.
+ * 다른 thread 에서 해제된 block 은 주인 cache 의 lock free list 로 돌아가고, 주인이 다음 할당 때 한번에 가져갑니다.
+ * max_small_size 보다 큰 할당은 ::operator new 로 넘깁니다.
+ */
+namespace yc_mem
+{
+    constexpr size_t pool_alignment = 16;
+    constexpr size_t span_size = 64 * 1024;
+    constexpr size_t max_small_size = 4096;
+
+    // 16 byte 단위로 시작해서 대략 1.5배씩 커지는 size class.
+    constexpr size_t size_classes[] = {
+        16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048, 3072, 4096
+    };
+    constexpr int size_class_count = static_cast<int>(std::size(size_classes));
+
+    constexpr int size_class_of(const size_t size) {
+        for (int i = 0; i < size_class_count; ++i) {
+            if (size <= size_classes[i]) return i;
+        }
+        return -1;
+    }
+
+    namespace detail
+    {
+        struct free_block_t {
+            free_block_t* next;
+        };
+
+        struct thread_cache_t;
+
+        // span_size 로 정렬된 span 의 맨 앞에 놓이는 header. block 주소에서 주인 cache 를 찾는 데 쓴다.
+        struct alignas(64) span_header_t {
+            thread_cache_t* owner;
+            int size_class;
+        };
+
+        struct alignas(64) thread_cache_t {
+            // 주인 thread 만 사용한다.
+            free_block_t* local[size_class_count] {};
+            // 다른 thread 가 해제한 block. 주인이 exchange 로 통째로 가져간다.
+            alignas(64) std::atomic<free_block_t*> remote[size_class_count] {};
+
+            void* allocate(const int cls) {
+                free_block_t* b = local[cls];
+                if (b == nullptr) {
+                    b = remote[cls].exchange(nullptr, std::memory_order_acquire);
+                    if (b == nullptr) b = carve_span(cls);
+                }
+                local[cls] = b->next;
+                return b;
+            }
+
+            void deallocate_local(void* p, const int cls) {
+                auto* b = static_cast<free_block_t*>(p);
+                b->next = local[cls];
+                local[cls] = b;
+            }
+
+            void deallocate_remote(void* p, const int cls) {
+                auto* b = static_cast<free_block_t*>(p);
+                free_block_t* head = remote[cls].load(std::memory_order_relaxed);
+                do {
+                    b->next = head;
+                } while (!remote[cls].compare_exchange_weak(head, b, std::memory_order_release, std::memory_order_relaxed));
+            }
+
+            // 새 span 을 잘라 free list 로 만든다.
+            free_block_t* carve_span(const int cls) {
+                auto* raw = static_cast<char*>(::operator new(span_size, std::align_val_t{span_size}));
+                new (raw) span_header_t{ this, cls };
+                const size_t block = size_classes[cls];
+                char* first = raw + sizeof(span_header_t);
+                const size_t count = (span_size - sizeof(span_header_t)) / block;
+                free_block_t* head = nullptr;
+                for (size_t i = count; i-- > 0;) {
+                    auto* b = reinterpret_cast<free_block_t*>(first + i * block);
+                    b->next = head;
+                    head = b;
+                }
+                return head;
+            }
+        };
+
+        // 끝난 thread 의 cache. 다른 thread 가 아직 그 block 을 해제할 수 있으므로 cache 는 지우지 않고 재사용한다.
+        struct cache_registry_t {
+            std::mutex mutex;
+            std::vector<thread_cache_t*> orphans;
+
+            static cache_registry_t& instance() {
+                static auto* registry = new cache_registry_t();
+                return *registry;
+            }
+
+            thread_cache_t* acquire() {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (orphans.empty()) return new thread_cache_t();
+                auto* c = orphans.back();
+                orphans.pop_back();
+                return c;
+            }
+
+            void release(thread_cache_t* c) {
+                std::lock_guard<std::mutex> lock(mutex);
+                orphans.push_back(c);
+            }
+        };
+
+        // thread_local 의 소멸 순서는 정해져 있지 않으므로 holder 가 소멸한 뒤에도
+        // 다른 thread_local 의 destructor 에서 allocate / deallocate 가 불릴 수 있다.
+        inline thread_local constinit bool cache_torn_down = false;
+
+        struct thread_cache_holder_t {
+            thread_cache_t* cache = cache_registry_t::instance().acquire();
+            ~thread_cache_holder_t() {
+                cache_torn_down = true;
+                cache_registry_t::instance().release(cache);
+            }
+        };
+
+        // 이 thread 의 cache. holder 가 이미 소멸했으면 nullptr 을 반환한다.
+        // 반환한 cache 는 registry 로 돌아가 다른 thread 가 가져갈 수 있으므로 다시 만들지 않는다.
+        inline thread_cache_t* local_cache() {
+            if (cache_torn_down) return nullptr;
+            thread_local thread_cache_holder_t holder;
+            return holder.cache;
+        }
+
+        inline span_header_t* span_of(void* p) {
+            return reinterpret_cast<span_header_t*>(reinterpret_cast<uintptr_t>(p) & ~(span_size - 1));
+        }
+    }
+
+    /**
+     * \brief size byte 를 할당합니다. 반환되는 주소는 pool_alignment 로 정렬됩니다.
+     */
+    inline void* allocate(const size_t size) {
+        const int cls = size_class_of(size);
+        if (cls < 0) return ::operator new(size);
+        if (auto* cache = detail::local_cache()) return cache->allocate(cls);
+        // thread 종료 중. registry 에서 cache 를 잠깐 빌려 할당한다. block 은 그 cache 의 것이 된다.
+        auto& registry = detail::cache_registry_t::instance();
+        auto* borrowed = registry.acquire();
+        void* p = borrowed->allocate(cls);
+        registry.release(borrowed);
+        return p;
+    }
+
+    /**
+     * \brief allocate 로 할당한 메모리를 해제합니다. 어느 thread 에서 호출해도 됩니다.
+     * \param size allocate 에 넘겼던 크기
+     */
+    inline void deallocate(void* p, const size_t size) {
+        if (p == nullptr) return;
+        const int cls = size_class_of(size);
+        if (cls < 0) {
+            ::operator delete(p);
+            return;
+        }
+        auto* cache = detail::local_cache();
+        detail::thread_cache_t* owner = detail::span_of(p)->owner;
+        // thread 종료 중이면 자기 cache 였던 block 도 remote list 로 돌려준다. cache 는 이미 registry 에 있다.
+        if (owner == cache) cache->deallocate_local(p, cls);
+        else owner->deallocate_remote(p, cls);
+    }
+
+    /**
+     * \brief yc_mem pool 을 쓰는 STL allocator.
+     * std::vector<int, yc_mem::pool_allocator<int>> 처럼 사용합니다.
+     */
+    template <typename T>
+    struct pool_allocator {
+        using value_type = T;
+
+        pool_allocator() noexcept = default;
+        template <typename U>
+        pool_allocator(const pool_allocator<U>&) noexcept { }
+
+        T* allocate(const size_t n) {
+            if constexpr (alignof(T) > pool_alignment) {
+                return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{alignof(T)}));
+            }
+            else {
+                return static_cast<T*>(yc_mem::allocate(n * sizeof(T)));
+            }
+        }
+
+        void deallocate(T* p, const size_t n) noexcept {
+            if constexpr (alignof(T) > pool_alignment) {
+                ::operator delete(p, std::align_val_t{alignof(T)});
+            }
+            else {
+                yc_mem::deallocate(p, n * sizeof(T));
+            }
+        }
+
+        template <typename U>
+        bool operator==(const pool_allocator<U>&) const noexcept { return true; }
+    };
+
+    template <typename T>
+    using pool_vector = std::vector<T, pool_allocator<T>>;
+}
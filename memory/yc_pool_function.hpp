@@ -0,0 +1,132 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "yc_pool_allocator.hpp"
+
+namespace yc_mem
+{
+    template <typename Signature>
+    class pool_function;
+
+    /**
+     * \brief std::function 대신 쓰는 move only 함수 객체.
+     * capture 가 inline_size 이하이면 객체 안에 담고, 더 크면 global new 대신 yc_mem pool 에 담습니다.
+     * thread_pool 의 작업처럼 한 thread 에서 만들고 다른 thread 에서 실행 / 소멸하는 경우에도 lock 없이 해제됩니다.
+     * [*** 중요! ***] 복사할 수 없습니다. 넘길 때는 std::move 를 사용하세요.
+     */
+    template <typename R, typename... Args>
+    class pool_function<R(Args...)> {
+        static constexpr size_t inline_size = 48;
+
+        struct vtable_t {
+            R (*invoke)(void* storage, Args&&... args);
+            // src 의 target 을 dst 로 옮기고 src 는 빈 storage 로 만든다.
+            void (*move)(void* dst, void* src) noexcept;
+            void (*destroy)(void* storage) noexcept;
+        };
+
+        template <typename F>
+        static constexpr bool fits_inline = sizeof(F) <= inline_size &&
+            alignof(F) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible_v<F>;
+
+        // inline 이면 storage 에 F 가, 아니면 pool 에 할당한 F* 가 들어있다.
+        template <typename F>
+        static F* target_of(void* storage) {
+            if constexpr (fits_inline<F>) return std::launder(reinterpret_cast<F*>(storage));
+            else return *std::launder(reinterpret_cast<F**>(storage));
+        }
+
+        template <typename F>
+        static constexpr vtable_t vtable_for {
+            [](void* storage, Args&&... args) -> R {
+                return std::invoke(*target_of<F>(storage), std::forward<Args>(args)...);
+            },
+            [](void* dst, void* src) noexcept {
+                if constexpr (fits_inline<F>) {
+                    F* f = target_of<F>(src);
+                    new (dst) F(std::move(*f));
+                    f->~F();
+                }
+                else {
+                    new (dst) F*(target_of<F>(src));
+                }
+            },
+            [](void* storage) noexcept {
+                F* f = target_of<F>(storage);
+                f->~F();
+                if constexpr (!fits_inline<F>) pool_allocator<F>{}.deallocate(f, 1);
+            }
+        };
+
+        alignas(std::max_align_t) mutable std::byte storage_[inline_size];
+        const vtable_t* vtable_ = nullptr;
+
+        void reset() noexcept {
+            if (vtable_) vtable_->destroy(storage_);
+            vtable_ = nullptr;
+        }
+
+    public:
+        pool_function() noexcept = default;
+        pool_function(std::nullptr_t) noexcept { }
+
+        template <typename F>
+            requires (!std::is_same_v<std::remove_cvref_t<F>, pool_function> &&
+                std::is_invocable_r_v<R, std::decay_t<F>&, Args...>)
+        pool_function(F&& f) {
+            using D = std::decay_t<F>;
+            if constexpr (fits_inline<D>) {
+                new (storage_) D(std::forward<F>(f));
+            }
+            else {
+                pool_allocator<D> alloc;
+                D* p = alloc.allocate(1);
+                try {
+                    new (p) D(std::forward<F>(f));
+                }
+                catch (...) {
+                    alloc.deallocate(p, 1);
+                    throw;
+                }
+                new (storage_) D*(p);
+            }
+            vtable_ = &vtable_for<D>;
+        }
+
+        pool_function(pool_function&& other) noexcept : vtable_(other.vtable_) {
+            if (vtable_) vtable_->move(storage_, other.storage_);
+            other.vtable_ = nullptr;
+        }
+
+        pool_function& operator=(pool_function&& other) noexcept {
+            if (this != &other) {
+                reset();
+                vtable_ = other.vtable_;
+                if (vtable_) vtable_->move(storage_, other.storage_);
+                other.vtable_ = nullptr;
+            }
+            return *this;
+        }
+
+        pool_function& operator=(std::nullptr_t) noexcept {
+            reset();
+            return *this;
+        }
+
+        pool_function(const pool_function&) = delete;
+        pool_function& operator=(const pool_function&) = delete;
+
+        ~pool_function() { reset(); }
+
+        explicit operator bool() const noexcept { return vtable_ != nullptr; }
+
+        R operator()(Args... args) const {
+            if (vtable_ == nullptr) throw std::bad_function_call();
+            return vtable_->invoke(storage_, std::forward<Args>(args)...);
+        }
+    };
+}
@@ -1,6 +1,10 @@
 #pragma once
 #include <functional>
 
+#include "../ycutil.hpp"
+#include "../diag/yc_trace.hpp"
+#include "../diag/yc_metrics.hpp"
+
 using packet_ack_type = int8_t;
 using packet_id_type = int8_t;
 using packet_size_type = int16_t;
@@ -70,6 +74,15 @@ f(data_, client_id); \
 
 std::vector<std::function<void(void*, packet_size_type, size_t)>> packet_events(__packets_max__);
 auto call_packet_event(void* data, packet_id_type packet_id, packet_size_type size, size_t client_id) {
+	YC_TRACE_ZONE("call_packet_event");
+	YC_METRICS(
+		static yc_metrics::indexed_t<yc_metrics::counter_t, __packets_max__> event_total("yc_packet_event_total", "packet id 별 처리한 packet 수", "id");
+		static yc_metrics::indexed_t<yc_metrics::counter_t, __packets_max__> event_bytes("yc_packet_event_bytes_total", "packet id 별 처리한 byte 수", "id");
+		static yc_metrics::indexed_t<yc_metrics::latency_histogram_t, __packets_max__> event_latency("yc_packet_event_latency_ns", "packet id 별 handler 실행 시간", "id");
+		event_total[packet_id].add();
+		event_bytes[packet_id].add(size);
+		const yc_metrics::scoped_timer_t timer(event_latency[packet_id]);
+	)
 	packet_events[packet_id](data, size, client_id);
 };
 
@@ -113,18 +126,43 @@ namespace yc_pack {
 
 	constexpr int HEADER_SIZE = sizeof(packet_size_type) + sizeof(packet_id_type);
 
-	// ReSharper disable once IdentifierTypo
-	inline bool pkt_vrfct(char* pkt, const size_t len) {
+	enum class verify_err : int {
+		too_short,
+		bad_id,
+		bad_size,
+		len_mismatch,
+	};
+
+	/**
+	 * \brief 수신한 패킷을 검사하고, 실패한 이유를 err_t 로 돌려줍니다. 할당이 없습니다.
+	 * \param pkt ack header 를 포함한 수신 버퍼
+	 * \param len 수신한 길이
+	 * \return ack header 뒤의 패킷. ack 만 있는 패킷이면 body 가 nullptr 입니다.
+	 */
+	inline yc::result_t<raw_packet> verify(char* pkt, const size_t len) {
+		using yc::err_category_t;
 		udp::convert_ack ack;
 		ack.load(*pkt);
-		if(ack.is_ack_packet && len == 1) return true;
-		if (len < HEADER_SIZE) return false;
+		if(ack.is_ack_packet && len == 1) return raw_packet{ .size = 0, .id = -1, .body = nullptr };
+		if (len < 1 + HEADER_SIZE) return yc::err_t(err_category_t::packet, verify_err::too_short, "packet is shorter than header");
 		const packet_size_type size = *reinterpret_cast<packet_size_type*>(pkt+1);
 		const packet_id_type id = *reinterpret_cast<packet_id_type*>(pkt + 1 + sizeof(packet_size_type));
-		if(id < 0 || id >= __packets_max__) return false;
-		if(size < 0 || size > PACKET_SIZE_MAX) return false;
-		if (len != static_cast<size_t>(size) + 1) return false;
-		return true;
+		if(id < 0 || id >= __packets_max__) return yc::err_t(err_category_t::packet, verify_err::bad_id, "packet id out of range");
+		if(size < 0 || size > PACKET_SIZE_MAX) return yc::err_t(err_category_t::packet, verify_err::bad_size, "packet size out of range");
+		if (len != static_cast<size_t>(size) + 1) return yc::err_t(err_category_t::packet, verify_err::len_mismatch, "packet size does not match received length");
+		return raw_packet{
+			.size = size,
+			.id = id,
+			.body = pkt + 1 + HEADER_SIZE
+		};
+	}
+
+	/**
+	 * \brief verify 가 성공하는지만 확인합니다.
+	 */
+	// ReSharper disable once IdentifierTypo
+	inline bool pkt_vrfct(char* pkt, const size_t len) {
+		return verify(pkt, len).has_value();
 	}
 
 	template <is_packet_tpye T>
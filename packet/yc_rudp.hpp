@@ -6,6 +6,8 @@
 #include <chrono>
 
 #include "yc_packet.hpp"
+#include "../memory/yc_pool_allocator.hpp"
+#include "../diag/yc_metrics.hpp"
 
 namespace yc_rudp
 {
@@ -136,18 +138,20 @@ namespace yc_rudp
      * 아니면 하나의 스레드에서만 실행된 다는 것이 보장되어야 한다.
      * \param pkt_buf 사용할 패킷 버퍼
      * \param recv_buf [OUT] 읽어온 패킷을 담을 버퍼
-     * \param no_ack_read_buf [OUT] ack 패킷이 아닌 패킷을 담을 버퍼
+     * \param no_ack_read_buf [OUT] ack 패킷이 아닌 패킷을 담을 버퍼. yc_mem::pool_vector 나 std::pmr::vector 도 받습니다.
      * \param thread_cnt_max 스레드의 최대 개수
      * \param end 읽어온 패킷의 마지막 위치
      * \return 읽을 패킷의 범위. 실패시 (-1, -1) 반환. 실패시 buffer를 비워서 패킷을 버린다.
      */
-    inline std::pair<int, int> get_read_range(
+    template <typename Alloc = std::allocator<receive_packet_raw>>
+    std::pair<int, int> get_read_range(
         std::vector<packet_raw>& pkt_buf,
         std::vector<receive_packet_raw>& recv_buf,
-        std::vector<receive_packet_raw>& no_ack_read_buf,
+        std::vector<receive_packet_raw, Alloc>& no_ack_read_buf,
         const int thread_cnt_max,
         int end
         ) {
+        YC_TRACE_ZONE("yc_rudp::get_read_range");
         int start = end;
         int cnt = 0;
         for(int i = start; i < start + ACK_COUNTER_MAX; ++i) {
@@ -211,6 +215,7 @@ namespace yc_rudp
         send_buf[s].timestamp = get_timestamp();
         send_buf[s].len = static_cast<packet_size_type>(len + 1);
         send_buf[s].is_used = use_ack;
+        send_buf[s].is_resend_packet = false;
         if(use_ack) resend_idx_buf.push_back(s);
         return s;
     }
@@ -229,6 +234,11 @@ namespace yc_rudp
         const int seq
         ) {
         if(!send_buf[seq].is_used) return -1;
+        // 재전송한 패킷의 ack 는 어느 전송에 대한 것인지 알 수 없으므로 rtt 표본에서 뺀다.
+        YC_METRICS(
+            static auto& rtt_ms = yc_metrics::histogram("yc_rudp_rtt_ms", "재전송 없이 ack 를 받은 패킷의 왕복 시간(ms)");
+            if (!send_buf[seq].is_resend_packet) rtt_ms.record(static_cast<uint64_t>(std::max<int64_t>(0, get_timestamp() - send_buf[seq].timestamp)));
+        )
         const auto& it = std::find(resend_idx_buf.begin(), resend_idx_buf.end(), seq);
         if(it != resend_idx_buf.end())
             resend_idx_buf.erase(it);
@@ -241,23 +251,30 @@ namespace yc_rudp
      * \param send_buf [OUT] resend가 필요한지 검사하는 버퍼
      * \param rtt [OUT] new rtt, timeout이 발생했을 경우 -1
      * \param timeout timeout을 발생 시킬 최소값 (ms)
-     * \return resend가 필요한 패킷의 seq, 없을 경우 0
+     * \return resend가 필요한 패킷의 seq, 없을 경우 0. thread cache pool 에 할당되어 global new 를 부르지 않습니다.
      */
-    inline std::vector<int> get_resend_packets(
+    inline yc_mem::pool_vector<int> get_resend_packets(
         std::vector<send_packet_raw>& send_buf,
         std::vector<int>& resend_idx_buf,
         int& rtt,
         const int timeout
         ) {
-        std::vector<int> result;
+        YC_TRACE_ZONE("yc_rudp::get_resend_packets");
+        YC_METRICS(
+            static auto& resend_total = yc_metrics::counter("yc_rudp_resend_total", "재전송한 패킷 수");
+            static auto& timeout_total = yc_metrics::counter("yc_rudp_timeout_total", "rtt 가 timeout 을 넘어 포기한 횟수");
+        )
+        yc_mem::pool_vector<int> result;
         for(const int& i : resend_idx_buf) {
             auto& pkt = send_buf[i];
             if (const auto t = get_timestamp(); pkt.timestamp + rtt < t) {
                 result.push_back(i);
+                YC_METRICS(resend_total.add();)
                 pkt.is_resend_packet = true;
                 rtt = static_cast<int>(static_cast<float>(rtt) * 1.5f);
                 rtt = rtt > 10 ? rtt : 10;
                 if (rtt > timeout) {
+                    YC_METRICS(timeout_total.add();)
                     pkt.is_used = false;
                     rtt = -1;
                     return {};
@@ -0,0 +1,83 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+/**
+ * \brief 하나의 writer 가 매 tick 새 버전을 publish 하고 여러 reader 가 일관된 사본을 가져가는 seqlock.
+ * reader 는 공유 메모리에 아무것도 쓰지 않으므로 r_srw_lock_guard 처럼 cache line 을 주고받지 않고,
+ * writer 도 reader 때문에 막히지 않습니다.
+ * 데이터는 64bit atomic word 로 복사하므로 찢어진 읽기가 data race 가 되지 않습니다.
+ * [*** 중요! ***] publish 를 호출하는 thread 는 한개여야 합니다.
+ * \tparam T 복사할 값. trivially copyable 해야 합니다. (rigid_body_t 등)
+ */
+template <typename T>
+    requires std::is_trivially_copyable_v<T>
+class seq_lock {
+    static constexpr size_t cache_line_size = 64;
+    static constexpr size_t word_count = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    // 홀수이면 writer 가 쓰는 중이다.
+    alignas(cache_line_size) std::atomic<uint64_t> seq_ {0};
+    alignas(cache_line_size) std::atomic<uint64_t> data_[word_count] {};
+
+public:
+    seq_lock() = default;
+    explicit seq_lock(const T& value) { publish(value); }
+    seq_lock(const seq_lock&) = delete;
+    seq_lock& operator=(const seq_lock&) = delete;
+
+    /**
+     * \brief 새 버전을 publish 합니다. writer thread 에서만 호출해야 합니다.
+     */
+    void publish(const T& value) {
+        uint64_t words[word_count] {};
+        std::memcpy(words, &value, sizeof(T));
+
+        const uint64_t s = seq_.load(std::memory_order_relaxed);
+        seq_.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < word_count; ++i) data_[i].store(words[i], std::memory_order_relaxed);
+        seq_.store(s + 2, std::memory_order_release);
+    }
+
+    /**
+     * \brief 사본을 한번 읽어봅니다.
+     * \param out [OUT] 성공시 일관된 사본
+     * \return writer 가 쓰는 중이었거나 읽는 도중 새 버전이 publish 되었으면 false
+     */
+    bool try_read(T& out) const {
+        const uint64_t s0 = seq_.load(std::memory_order_acquire);
+        if (s0 & 1) return false;
+        uint64_t words[word_count];
+        for (size_t i = 0; i < word_count; ++i) words[i] = data_[i].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (seq_.load(std::memory_order_relaxed) != s0) return false;
+        std::memcpy(&out, words, sizeof(T));
+        return true;
+    }
+
+    /**
+     * \brief 일관된 사본을 얻을 때까지 다시 시도합니다.
+     */
+    void read(T& out) const {
+        for (int i = 0; !try_read(out); ++i) {
+            if (i > 64) std::this_thread::yield();
+        }
+    }
+
+    T read() const requires std::is_default_constructible_v<T> {
+        T out;
+        read(out);
+        return out;
+    }
+
+    /**
+     * \brief 지금까지 publish 된 버전 수.
+     */
+    uint64_t version() const {
+        return seq_.load(std::memory_order_acquire) / 2;
+    }
+};
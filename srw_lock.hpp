@@ -1,4 +1,12 @@
 #pragma once
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+#if defined(_WIN32)
 #include<Windows.h>
 
 class srw_lock {
@@ -23,10 +31,214 @@ public:
     }
 };
 
+#else
+// linux 에서는 futex 를 직접 부르고, 그 외(또는 YC_SRW_LOCK_ATOMIC_WAIT 정의시)에는 C++20 atomic wait / notify 를 씁니다.
+#if defined(__linux__) && !defined(YC_SRW_LOCK_ATOMIC_WAIT)
+#define YC_SRW_LOCK_USE_FUTEX 1
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#define YC_SRW_LOCK_USE_FUTEX 0
+#endif
+
+/**
+ * \brief futex(linux) 또는 atomic wait / notify 기반 reader-writer lock. windows 의 SRWLOCK 과 같은 api 를 가집니다.
+ * state_ 의 하위 bit 는 reader 수, writer_bit 는 writer 가 lock 을 잡고 있음을 뜻합니다.
+ * writer 가 기다리는 동안에는 새 reader 가 들어오지 못해 writer 가 굶지 않습니다.
+ */
+class srw_lock {
+    static constexpr uint32_t writer_bit = 1u << 31;
+    static constexpr int spin_count = 64;
+
+    std::atomic<uint32_t> state_ {0};
+    std::atomic<uint32_t> writers_waiting_ {0};
+    // unlock 마다 증가하는 futex word. 대기하는 thread 는 이 값이 바뀌기를 기다린다.
+    std::atomic<uint32_t> epoch_ {0};
+    std::atomic<uint32_t> sleepers_ {0};
+
+    static void futex_wait(std::atomic<uint32_t>& word, const uint32_t expected) {
+#if YC_SRW_LOCK_USE_FUTEX
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+        word.wait(expected);
+#endif
+    }
+    static void futex_wake_all(std::atomic<uint32_t>& word) {
+#if YC_SRW_LOCK_USE_FUTEX
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#else
+        word.notify_all();
+#endif
+    }
+
+    // try 가 성공할 때까지 잠깐 spin 한 뒤 futex 로 잠든다.
+    template <typename Try>
+    void acquire(Try&& try_acquire) {
+        for (int i = 0; i < spin_count; ++i) {
+            if (try_acquire()) return;
+        }
+        while (true) {
+            const uint32_t seen = epoch_.load();
+            if (try_acquire()) return;
+            sleepers_.fetch_add(1);
+            if (epoch_.load() == seen) futex_wait(epoch_, seen);
+            sleepers_.fetch_sub(1);
+        }
+    }
+
+    void wake() {
+        epoch_.fetch_add(1);
+        if (sleepers_.load()) futex_wake_all(epoch_);
+    }
+
+public:
+    srw_lock() = default;
+    ~srw_lock() = default;
+    srw_lock(const srw_lock&) = delete;
+    srw_lock& operator=(const srw_lock&) = delete;
+
+    bool try_w_lock() {
+        uint32_t expected = 0;
+        return state_.compare_exchange_strong(expected, writer_bit, std::memory_order_acquire);
+    }
+    void w_lock() {
+        if (try_w_lock()) return;
+        writers_waiting_.fetch_add(1);
+        acquire([this] { return try_w_lock(); });
+        writers_waiting_.fetch_sub(1);
+    }
+    void w_unlock() {
+        state_.store(0, std::memory_order_release);
+        wake();
+    }
+
+    bool try_r_lock() {
+        uint32_t s = state_.load(std::memory_order_relaxed);
+        if ((s & writer_bit) || writers_waiting_.load(std::memory_order_relaxed)) return false;
+        return state_.compare_exchange_strong(s, s + 1, std::memory_order_acquire);
+    }
+    void r_lock() {
+        acquire([this] { return try_r_lock(); });
+    }
+    void r_unlock() {
+        if (state_.fetch_sub(1, std::memory_order_release) == 1) wake();
+    }
+};
+#endif
+
+/**
+ * \brief 읽기 위주의 자료구조(session table 등)를 위한 BRAVO 방식 reader-writer lock.
+ * reader 는 thread 마다 다른 visible reader slot 에 자신을 기록하고 srw_lock 을 건드리지 않으므로
+ * 여러 core 가 하나의 cache line 을 주고받지 않습니다.
+ * writer 가 오면 reader bias 를 끄고 slot 이 비기를 기다린 뒤, 그 비용에 비례하는 시간 동안 bias 를 다시 켜지 않습니다.
+ * r_srw_lock_guard / w_srw_lock_guard 와 함께 쓸 수 있습니다.
+ */
+class bravo_srw_lock {
+    static constexpr size_t cache_line_size = 64;
+    static constexpr size_t table_size = 4096;
+    // writer 가 bias 를 회수하는 데 걸린 시간의 몇 배 동안 bias 를 끌지.
+    static constexpr int inhibit_multiplier = 9;
+
+    struct alignas(cache_line_size) reader_slot_t {
+        std::atomic<bravo_srw_lock*> lock {nullptr};
+    };
+    // 모든 bravo_srw_lock 이 공유하는 visible reader table.
+    static reader_slot_t* visible_readers() {
+        static reader_slot_t table[table_size];
+        return table;
+    }
+
+    srw_lock underlying_;
+    std::atomic<bool> reader_bias_ {true};
+    std::atomic<int64_t> inhibit_until_ {0};
+
+    // 이 thread 가 fast path 로 잡은 (lock, slot). 여러 bravo_srw_lock 을 동시에 읽을 수 있도록 몇 개를 기억한다.
+    struct held_t {
+        bravo_srw_lock* lock;
+        reader_slot_t* slot;
+    };
+    static constexpr int max_held = 8;
+    static inline thread_local held_t held_[max_held] {};
+
+    static int64_t now_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    reader_slot_t& slot_for_this_thread() {
+        size_t h = std::hash<std::thread::id>{}(std::this_thread::get_id());
+        h ^= reinterpret_cast<uintptr_t>(this) >> 6;
+        h *= 0x9e3779b97f4a7c15ull;
+        return visible_readers()[(h >> 20) % table_size];
+    }
+
+public:
+    bravo_srw_lock() = default;
+    bravo_srw_lock(const bravo_srw_lock&) = delete;
+    bravo_srw_lock& operator=(const bravo_srw_lock&) = delete;
+
+    void r_lock() {
+        if (reader_bias_.load(std::memory_order_acquire)) {
+            held_t* held = nullptr;
+            for (auto& h : held_) {
+                if (h.lock == nullptr) {
+                    held = &h;
+                    break;
+                }
+            }
+            auto& slot = slot_for_this_thread();
+            bravo_srw_lock* expected = nullptr;
+            if (held && slot.lock.compare_exchange_strong(expected, this)) {
+                // slot 을 기록한 뒤에도 bias 가 켜져 있으면 writer 는 이 slot 을 보고 기다린다.
+                if (reader_bias_.load()) {
+                    *held = held_t{ this, &slot };
+                    return;
+                }
+                slot.lock.store(nullptr, std::memory_order_release);
+            }
+        }
+        underlying_.r_lock();
+        if (!reader_bias_.load(std::memory_order_relaxed) && now_ns() >= inhibit_until_.load(std::memory_order_relaxed)) {
+            reader_bias_.store(true, std::memory_order_release);
+        }
+    }
+
+    void r_unlock() {
+        for (auto& h : held_) {
+            if (h.lock == this) {
+                h.slot->lock.store(nullptr, std::memory_order_release);
+                h = held_t{};
+                return;
+            }
+        }
+        underlying_.r_unlock();
+    }
+
+    void w_lock() {
+        underlying_.w_lock();
+        if (reader_bias_.load(std::memory_order_relaxed)) {
+            reader_bias_.store(false);
+            const int64_t start = now_ns();
+            auto* table = visible_readers();
+            for (size_t i = 0; i < table_size; ++i) {
+                while (table[i].lock.load() == this) std::this_thread::yield();
+            }
+            const int64_t end = now_ns();
+            inhibit_until_.store(end + (end - start) * inhibit_multiplier, std::memory_order_relaxed);
+        }
+    }
+
+    void w_unlock() {
+        underlying_.w_unlock();
+    }
+};
+
+template <typename Lock = srw_lock>
 class r_srw_lock_guard {
-    srw_lock& lock;
+    Lock& lock;
 public:
-    r_srw_lock_guard(srw_lock& lock) :lock(lock) {
+    r_srw_lock_guard(Lock& lock) :lock(lock) {
         lock.r_lock();
     }
     ~r_srw_lock_guard() {
@@ -34,13 +246,14 @@ public:
     }
 };
 
+template <typename Lock = srw_lock>
 class w_srw_lock_guard {
-    srw_lock& lock;
+    Lock& lock;
 public:
-    w_srw_lock_guard(srw_lock& lock) :lock(lock) {
+    w_srw_lock_guard(Lock& lock) :lock(lock) {
         lock.w_lock();
     }
     ~w_srw_lock_guard() {
         lock.w_unlock();
     }
-};
\ No newline at end of file
+};
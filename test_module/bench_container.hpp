@@ -0,0 +1,137 @@
+#pragma once
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "yc_test.hpp"
+#include "../container/yc_slot_map.hpp"
+#include "../container/yc_flat_map.hpp"
+
+namespace yc::test::bench
+{
+    constexpr size_t container_entities = 10000;
+
+    // 게임 object 크기의 원소.
+    struct entity_t {
+        float position[3];
+        float velocity[3];
+        uint64_t id;
+    };
+
+    inline entity_t make_entity(const uint64_t id) {
+        const float f = static_cast<float>(id);
+        return entity_t{ { f, f, f }, { 1.0f, 0.0f, -1.0f }, id };
+    }
+
+    inline void integrate(entity_t& e) {
+        for (int k = 0; k < 3; ++k) e.position[k] += e.velocity[k] * 0.016f;
+    }
+
+    // 추가 / 삭제가 반복된 뒤의 모습: slot_map 은 빈 slot 이 섞여 있고, pointer vector 는 heap 에 흩어져 있다.
+    inline slot_map<entity_t> make_churned_slot_map(std::vector<slot_handle_t>& handles) {
+        slot_map<entity_t> map;
+        std::vector<slot_handle_t> all;
+        for (uint64_t i = 0; i < container_entities * 2; ++i) all.push_back(map.emplace(make_entity(i)));
+        std::mt19937 rng(7);
+        std::shuffle(all.begin(), all.end(), rng);
+        for (size_t i = 0; i < container_entities; ++i) map.erase(all[i]);
+        handles.assign(all.begin() + container_entities, all.end());
+        std::shuffle(handles.begin(), handles.end(), rng);
+        return map;
+    }
+
+    inline std::vector<std::unique_ptr<entity_t>> make_churned_pointer_vector() {
+        std::vector<std::unique_ptr<entity_t>> all;
+        for (uint64_t i = 0; i < container_entities * 2; ++i) all.push_back(std::make_unique<entity_t>(make_entity(i)));
+        std::mt19937 rng(7);
+        std::shuffle(all.begin(), all.end(), rng);
+        all.resize(container_entities);
+        return all;
+    }
+
+    // session id 같은 임의의 64bit key. 연속된 정수 key 는 std::hash(identity) 에 유리해 실제 사용과 다르다.
+    inline std::vector<uint64_t> make_lookup_keys() {
+        std::vector<uint64_t> keys(container_entities);
+        std::mt19937_64 rng(11);
+        for (auto& k : keys) k = rng();
+        return keys;
+    }
+
+    // key 를 넣은 순서와 다른 순서로 찾는다.
+    inline std::vector<uint64_t> shuffled(std::vector<uint64_t> keys) {
+        std::shuffle(keys.begin(), keys.end(), std::mt19937(13));
+        return keys;
+    }
+}
+
+// 전체 원소를 한번 갱신하는 순회.
+YC_BENCHMARK(slot_map_iterate) {
+    std::vector<yc::slot_handle_t> handles;
+    auto map = yc::test::bench::make_churned_slot_map(handles);
+    state.set_items_per_iteration(map.size());
+    for (auto _ : state) {
+        for (auto& e : map) yc::test::bench::integrate(e);
+        yc::test::do_not_optimize(map.data());
+    }
+}
+
+YC_BENCHMARK(pointer_vector_iterate) {
+    auto entities = yc::test::bench::make_churned_pointer_vector();
+    state.set_items_per_iteration(entities.size());
+    for (auto _ : state) {
+        for (auto& e : entities) yc::test::bench::integrate(*e);
+        yc::test::do_not_optimize(entities.data());
+    }
+}
+
+YC_BENCHMARK(unordered_map_iterate) {
+    std::unordered_map<uint64_t, yc::test::bench::entity_t> map;
+    for (uint64_t i = 0; i < yc::test::bench::container_entities; ++i) map.emplace(i, yc::test::bench::make_entity(i));
+    state.set_items_per_iteration(map.size());
+    for (auto _ : state) {
+        for (auto& [id, e] : map) yc::test::bench::integrate(e);
+        yc::test::do_not_optimize(map);
+    }
+}
+
+// 섞인 순서로 모든 원소를 한번씩 찾는다.
+YC_BENCHMARK(slot_map_lookup) {
+    std::vector<yc::slot_handle_t> handles;
+    auto map = yc::test::bench::make_churned_slot_map(handles);
+    state.set_items_per_iteration(handles.size());
+    for (auto _ : state) {
+        uint64_t sum = 0;
+        for (const auto h : handles) sum += map.get(h)->id;
+        yc::test::do_not_optimize(sum);
+    }
+}
+
+YC_BENCHMARK(flat_hash_map_lookup) {
+    yc::flat_hash_map<uint64_t, yc::test::bench::entity_t> map;
+    map.reserve(yc::test::bench::container_entities);
+    const auto ids = yc::test::bench::make_lookup_keys();
+    for (const auto id : ids) map.try_emplace(id, yc::test::bench::make_entity(id));
+    const auto keys = yc::test::bench::shuffled(ids);
+    state.set_items_per_iteration(keys.size());
+    for (auto _ : state) {
+        uint64_t sum = 0;
+        for (const auto k : keys) sum += map.find(k)->second.id;
+        yc::test::do_not_optimize(sum);
+    }
+}
+
+YC_BENCHMARK(unordered_map_lookup) {
+    std::unordered_map<uint64_t, yc::test::bench::entity_t> map;
+    map.reserve(yc::test::bench::container_entities);
+    const auto ids = yc::test::bench::make_lookup_keys();
+    for (const auto id : ids) map.emplace(id, yc::test::bench::make_entity(id));
+    const auto keys = yc::test::bench::shuffled(ids);
+    state.set_items_per_iteration(keys.size());
+    for (auto _ : state) {
+        uint64_t sum = 0;
+        for (const auto k : keys) sum += map.find(k)->second.id;
+        yc::test::do_not_optimize(sum);
+    }
+}
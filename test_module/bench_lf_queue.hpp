@@ -0,0 +1,143 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "yc_test.hpp"
+#include "../thread/lf_queue.hpp"
+
+namespace yc::test::bench
+{
+    // 비교 기준. std::mutex 하나로 보호하는 std::queue.
+    template <typename T>
+    class mutex_queue_t {
+        std::mutex mutex_;
+        std::queue<T> queue_;
+
+    public:
+        bool try_push(const T& value) {
+            std::lock_guard lock(mutex_);
+            queue_.push(value);
+            return true;
+        }
+        bool try_pop(T& out) {
+            std::lock_guard lock(mutex_);
+            if (queue_.empty()) return false;
+            out = queue_.front();
+            queue_.pop();
+            return true;
+        }
+    };
+
+    struct queue_node_t {
+        std::atomic<queue_node_t*> next {nullptr};
+        int64_t value = 0;
+    };
+
+    /**
+     * \brief Producers 개의 thread 가 한 round 에 per_round 개씩 push(thread, i) 하고,
+     * 측정 thread 가 consumer 로서 pop() 이 Producers * per_round 번 성공할 때까지를 한 iteration 으로 잽니다.
+     * producer thread 는 benchmark 실행 동안 유지하고 round 번호로 깨운다.
+     */
+    template <int Producers, int PerRound, typename Push, typename Pop>
+    void run_queue_rounds(bench_state_t& state, Push&& push, Pop&& pop) {
+        std::atomic<uint64_t> round {0};
+        std::atomic<bool> stop {false};
+
+        std::vector<std::thread> producers;
+        for (int t = 0; t < Producers; ++t) {
+            producers.emplace_back([&, t] {
+                uint64_t seen = 0;
+                while (true) {
+                    round.wait(seen, std::memory_order_acquire);
+                    seen = round.load(std::memory_order_acquire);
+                    if (stop.load(std::memory_order_relaxed)) return;
+                    for (int i = 0; i < PerRound; ++i) {
+                        while (!push(t, i)) std::this_thread::yield();
+                    }
+                }
+            });
+        }
+
+        state.set_items_per_iteration(Producers * PerRound);
+        for (auto _ : state) {
+            round.fetch_add(1, std::memory_order_release);
+            round.notify_all();
+            for (int popped = 0; popped < Producers * PerRound; ) {
+                if (pop()) ++popped;
+                else std::this_thread::yield();
+            }
+        }
+
+        stop.store(true, std::memory_order_relaxed);
+        round.fetch_add(1, std::memory_order_release);
+        round.notify_all();
+        for (auto& p : producers) p.join();
+    }
+
+    // Queue 는 try_push(int64_t) / try_pop(int64_t&) 를 가진 mpmc_queue, spsc_ring, mutex_queue_t.
+    template <typename Queue, int Producers>
+    void run_value_queue(bench_state_t& state, Queue& queue) {
+        constexpr int per_round = 256;
+        int64_t sum = 0;
+        run_queue_rounds<Producers, per_round>(state,
+            [&](int, const int i) { return queue.try_push(static_cast<int64_t>(i)); },
+            [&] {
+                int64_t v;
+                if (!queue.try_pop(v)) return false;
+                sum += v;
+                return true;
+            });
+        do_not_optimize(sum);
+    }
+
+    template <int Producers>
+    void run_mpsc_intrusive(bench_state_t& state) {
+        constexpr int per_round = 256;
+        yc_lf::mpsc_intrusive_queue<queue_node_t> queue;
+        // 한 round 의 node 는 consumer 가 모두 꺼낸 뒤에야 다음 round 에서 다시 push 된다.
+        std::vector<queue_node_t> nodes(Producers * per_round);
+        int64_t sum = 0;
+        run_queue_rounds<Producers, per_round>(state,
+            [&](const int t, const int i) {
+                auto& node = nodes[t * per_round + i];
+                node.value = i;
+                queue.push(&node);
+                return true;
+            },
+            [&] {
+                auto* node = queue.pop();
+                if (!node) return false;
+                sum += node->value;
+                return true;
+            });
+        do_not_optimize(sum);
+    }
+}
+
+// producer 1 -> consumer 1.
+YC_BENCHMARK(lf_spsc_ring_1p1c) {
+    yc_lf::spsc_ring<int64_t> queue(1024);
+    yc::test::bench::run_value_queue<decltype(queue), 1>(state, queue);
+}
+YC_BENCHMARK(lf_mpmc_queue_1p1c) {
+    yc_lf::mpmc_queue<int64_t> queue(1024);
+    yc::test::bench::run_value_queue<decltype(queue), 1>(state, queue);
+}
+YC_BENCHMARK(mutex_queue_1p1c) {
+    yc::test::bench::mutex_queue_t<int64_t> queue;
+    yc::test::bench::run_value_queue<decltype(queue), 1>(state, queue);
+}
+
+// producer 4 -> consumer 1.
+YC_BENCHMARK(lf_mpmc_queue_4p1c) {
+    yc_lf::mpmc_queue<int64_t> queue(4096);
+    yc::test::bench::run_value_queue<decltype(queue), 4>(state, queue);
+}
+YC_BENCHMARK(lf_mpsc_intrusive_4p1c) { yc::test::bench::run_mpsc_intrusive<4>(state); }
+YC_BENCHMARK(mutex_queue_4p1c) {
+    yc::test::bench::mutex_queue_t<int64_t> queue;
+    yc::test::bench::run_value_queue<decltype(queue), 4>(state, queue);
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "yc_test.hpp"
+#include "../diag/yc_log.hpp"
+
+// 호출한 thread 가 내는 비용. 출력은 background thread 가 하므로 여기에 들어가지 않는다.
+YC_BENCHMARK(log_write_deferred) {
+    yc_log::set_sink([](yc_log::level_t, std::string_view) {});
+    static yc_log::site_t site { yc_log::level_t::info, __FILE__, __LINE__, "seq {} rtt {} name {}", 0 };
+    int seq = 0;
+    for (auto _ : state) {
+        yc_log::write(site, seq++, 12.5, "player");
+        // ring 이 가득 차서 버리는 경우를 재지 않도록 가끔 비운다.
+        if ((seq & 511) == 0) {
+            state.pause_timing();
+            yc_log::flush();
+            state.resume_timing();
+        }
+    }
+    yc_log::flush();
+}
+
+// rate limit 에 걸려 바로 돌아가는 비용.
+YC_BENCHMARK(log_write_rate_limited) {
+    yc_log::set_sink([](yc_log::level_t, std::string_view) {});
+    static yc_log::site_t site { yc_log::level_t::info, __FILE__, __LINE__, "seq {}", 1 };
+    int seq = 0;
+    for (auto _ : state) {
+        yc_log::write(site, seq++);
+    }
+    yc_log::flush();
+}
+
+// YC_LOG_LEVEL 로 걸러지는 log. 빈 loop 와 같아야 한다.
+YC_BENCHMARK(log_compiled_out) {
+    int seq = 0;
+    for (auto _ : state) {
+        YC_LOG_TRACE("seq {}", seq++);
+        yc::test::clobber();
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <array>
+#include <functional>
+
+#include "yc_test.hpp"
+#include "../memory/yc_pool_allocator.hpp"
+#include "../memory/yc_pool_function.hpp"
+
+namespace yc::test::bench
+{
+    // 한번에 잡고 있는 block 수. free list 가 한 block 만 오가는 것보다 실제 사용에 가깝다.
+    constexpr size_t live_blocks = 64;
+
+    template <size_t Size>
+    void run_pool_allocate(bench_state_t& state) {
+        std::array<void*, live_blocks> blocks {};
+        state.set_items_per_iteration(live_blocks);
+        for (auto _ : state) {
+            for (auto& b : blocks) b = yc_mem::allocate(Size);
+            do_not_optimize(blocks);
+            for (auto* b : blocks) yc_mem::deallocate(b, Size);
+        }
+    }
+
+    template <size_t Size>
+    void run_new_delete(bench_state_t& state) {
+        std::array<void*, live_blocks> blocks {};
+        state.set_items_per_iteration(live_blocks);
+        for (auto _ : state) {
+            for (auto& b : blocks) b = ::operator new(Size);
+            do_not_optimize(blocks);
+            for (auto* b : blocks) ::operator delete(b, Size);
+        }
+    }
+
+    // thread_pool 작업 크기의 capture. std::function 의 inline buffer(16 byte) 보다 크다.
+    struct task_capture_t {
+        int64_t values[5];
+    };
+    // pool_function 의 inline buffer 보다 커서 pool 에 할당되는 capture.
+    struct large_capture_t {
+        int64_t values[16];
+    };
+
+    template <typename Function, typename Capture>
+    void run_function_make_call(bench_state_t& state) {
+        Capture capture {};
+        capture.values[0] = 1;
+        int64_t sum = 0;
+        for (auto _ : state) {
+            Function f([capture, &sum] { sum += capture.values[0]; });
+            f();
+            do_not_optimize(f);
+        }
+        do_not_optimize(sum);
+    }
+}
+
+// 64개 block 을 할당하고 모두 해제하는 한 바퀴. allocs_per_iter 로 global new 호출 수를 함께 본다.
+YC_BENCHMARK(pool_allocate_free_64B) { yc::test::bench::run_pool_allocate<64>(state); }
+YC_BENCHMARK(new_delete_64B) { yc::test::bench::run_new_delete<64>(state); }
+YC_BENCHMARK(pool_allocate_free_1KB) { yc::test::bench::run_pool_allocate<1024>(state); }
+YC_BENCHMARK(new_delete_1KB) { yc::test::bench::run_new_delete<1024>(state); }
+
+// 작업 하나를 만들고 실행하고 소멸시키는 비용. std::function 은 capture 가 크면 매번 global new 를 부른다.
+YC_BENCHMARK(pool_function_task_capture) {
+    yc::test::bench::run_function_make_call<yc_mem::pool_function<void()>, yc::test::bench::task_capture_t>(state);
+}
+YC_BENCHMARK(std_function_task_capture) {
+    yc::test::bench::run_function_make_call<std::function<void()>, yc::test::bench::task_capture_t>(state);
+}
+YC_BENCHMARK(pool_function_large_capture) {
+    yc::test::bench::run_function_make_call<yc_mem::pool_function<void()>, yc::test::bench::large_capture_t>(state);
+}
+YC_BENCHMARK(std_function_large_capture) {
+    yc::test::bench::run_function_make_call<std::function<void()>, yc::test::bench::large_capture_t>(state);
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include "yc_test.hpp"
+#include "../diag/yc_metrics.hpp"
+
+YC_BENCHMARK(metrics_counter_add) {
+    auto& c = yc_metrics::counter("yc_bench_counter_total", "benchmark 용 counter");
+    for (auto _ : state) {
+        c.add();
+        yc::test::clobber();
+    }
+}
+
+YC_BENCHMARK(metrics_histogram_record) {
+    auto& h = yc_metrics::histogram("yc_bench_histogram_ns", "benchmark 용 histogram");
+    uint64_t v = 1;
+    for (auto _ : state) {
+        h.record(v);
+        v = v * 3 + 1;
+        yc::test::clobber();
+    }
+}
+
+YC_BENCHMARK(metrics_scoped_timer) {
+    auto& h = yc_metrics::latency("yc_bench_latency_ns", "benchmark 용 latency histogram");
+    for (auto _ : state) {
+        const yc_metrics::scoped_timer_t timer(h);
+        yc::test::clobber();
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstring>
+
+#include "yc_test.hpp"
+#include "../packet/packets.hpp"
+
+namespace yc::test::bench
+{
+    // ack header(1) + size(2) + id(1) + body
+    inline std::vector<char> make_packet_bytes(const packet_id_type id, const packet_size_type body_size) {
+        std::vector<char> buf(1 + yc_pack::HEADER_SIZE + body_size, 0);
+        yc_pack::udp::convert_ack ack(0);
+        buf[0] = static_cast<char>(ack.to_ack());
+        const auto size = static_cast<packet_size_type>(buf.size() - 1);
+        std::memcpy(buf.data() + 1, &size, sizeof(size));
+        std::memcpy(buf.data() + 1 + sizeof(size), &id, sizeof(id));
+        return buf;
+    }
+}
+
+YC_BENCHMARK(packet_pkt_vrfct) {
+    auto buf = yc::test::bench::make_packet_bytes(packet_player_movement_start::__packet__id, sizeof(player_movement_start_t));
+    for (auto _ : state) {
+        yc::test::do_not_optimize(buf);
+        bool ok = yc_pack::pkt_vrfct(buf.data(), buf.size());
+        yc::test::do_not_optimize(ok);
+    }
+}
+
+YC_BENCHMARK(packet_verify) {
+    auto buf = yc::test::bench::make_packet_bytes(packet_player_movement_start::__packet__id, sizeof(player_movement_start_t));
+    for (auto _ : state) {
+        yc::test::do_not_optimize(buf);
+        auto r = yc_pack::verify(buf.data(), buf.size());
+        yc::test::do_not_optimize(r);
+    }
+}
+
+YC_BENCHMARK(packet_pack) {
+    packet_var_players_location pkt{};
+    pkt.size = 50;
+    for (auto _ : state) {
+        yc::test::do_not_optimize(pkt);
+        auto raw = yc_pack::pack(pkt);
+        yc::test::do_not_optimize(raw);
+    }
+}
+
+YC_BENCHMARK(packet_unpack) {
+    auto buf = yc::test::bench::make_packet_bytes(packet_player_movement_start::__packet__id, sizeof(player_movement_start_t));
+    for (auto _ : state) {
+        yc::test::do_not_optimize(buf);
+        auto raw = yc_pack::unpack(buf.data() + 1);
+        yc::test::do_not_optimize(raw);
+    }
+}
+
+YC_BENCHMARK(packet_call_packet_event) {
+    uint64_t received = 0;
+    packet_player_movement_start::bind([&received](packet_player_movement_start pkt, size_t) {
+        received += pkt.move_data.timestamp;
+    });
+    packet_player_movement_start pkt{};
+    pkt.move_data.timestamp = 1;
+    for (auto _ : state) {
+        call_packet_event(&pkt, packet_player_movement_start::__packet__id, sizeof(pkt), 0);
+        yc::test::clobber();
+    }
+    yc::test::do_not_optimize(received);
+    packet_events[packet_player_movement_start::__packet__id] = nullptr;
+}
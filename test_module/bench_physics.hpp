@@ -0,0 +1,442 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "yc_test.hpp"
+#include "../game/yc_physics.hpp"
+#include "../game/yc_terrain_cache.hpp"
+
+namespace yc::test::bench
+{
+    /**
+     * \brief 8x8 평지 block 사이에 경사가 섞인 heightmap. 평지는 meshing 에서 하나로 합쳐진다.
+     */
+    inline std::vector<uint8_t> make_heightmap(const int width, const int height) {
+        std::vector<uint8_t> map(static_cast<size_t>(width) * height);
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                const int block = (x / 8 + y / 8) % 4;
+                const int h = block == 3 ? (x * 7 + y * 13) % 5 : block;
+                map[static_cast<size_t>(y) * width + x] = static_cast<uint8_t>(128 + h);
+            }
+        }
+        return map;
+    }
+
+    inline std::unique_ptr<yc_physics::terrain_t> make_terrain(const int width, const int height) {
+        const auto map = make_heightmap(width, height);
+        auto terrain = std::make_unique<yc_physics::terrain_t>();
+        terrain->root_pos = {0, 0, 0};
+        terrain->build(map.data(), width, height, 1.0);
+        return terrain;
+    }
+
+    /**
+     * \brief size x size heightmap 으로 terrain 을 build 하는 시간을 잽니다. item 은 cell 하나입니다.
+     */
+    inline void run_terrain_build(bench_state_t& state, const int size, test_thread_pool* pool) {
+        const auto map = make_heightmap(size, size);
+        state.set_items_per_iteration(static_cast<size_t>(size - 1) * (size - 1));
+        yc_physics::terrain_t terrain;
+        terrain.root_pos = {0, 0, 0};
+        for (auto _ : state) {
+            terrain.build(map.data(), size, size, 1.0, pool);
+            yc::test::do_not_optimize(terrain.triangle_indices.data());
+        }
+    }
+
+    /**
+     * \brief 64x64 terrain 위 8x8 격자에 표면보다 살짝 낮게 놓인 body 들의 위치.
+     */
+    inline std::vector<yc_math::vec3_t> make_contact_positions(const yc_physics::terrain_t& terrain, const double lift) {
+        std::vector<yc_math::vec3_t> positions;
+        for (int i = 0; i < 64; ++i) {
+            const double x = 4 + (i % 8) * 7 + 0.25;
+            const double y = 4 + (i / 8) * 7 + 0.25;
+            positions.push_back({x, y, terrain.get_height_interpolation(x, y) + lift});
+        }
+        return positions;
+    }
+
+    /**
+     * \brief 원점 근처 2x2 cell 을 나눈 경사진 triangle 8개. capsule / sphere 가 일부와만 닿는다.
+     */
+    inline std::array<yc_physics::triangle_t, 8> make_narrowphase_triangles() {
+        std::array<yc_physics::triangle_t, 8> triangles;
+        auto vertex = [](const int x, const int y) {
+            return yc_math::vec3_t(x - 1.0, y - 1.0, 0.15 * x - 0.1 * y);
+        };
+        for (int i = 0; i < 4; ++i) {
+            const int x = i % 2, y = i / 2;
+            triangles[i * 2] = { vertex(x, y), vertex(x + 1, y), vertex(x, y + 1) };
+            triangles[i * 2 + 1] = { vertex(x + 1, y), vertex(x, y + 1), vertex(x + 1, y + 1) };
+        }
+        return triangles;
+    }
+
+    /**
+     * \brief triangle 8개를 batch 에 넣고 Lane kernel 로 capsule 과 검사합니다. item 은 triangle 하나입니다.
+     */
+    template <typename Lane>
+    void run_capsule_batch(bench_state_t& state) {
+        const auto triangles = make_narrowphase_triangles();
+        const yc_physics::capsule_segment_t segment(yc_physics::capsule_t(1.0, 0.5), { 0.1, 0.2, 1.3 },
+                                                    yc_math::qut_t{ 1, 0, 0, 0 });
+        yc_physics::triangle_batch_t<> batch;
+        state.set_items_per_iteration(triangles.size());
+        for (auto _ : state) {
+            batch.clear();
+            for (const auto& t : triangles) batch.push(t);
+            auto hit = yc_physics::deepest_capsule_n_triangles<Lane>(segment, batch);
+            yc::test::do_not_optimize(hit);
+        }
+    }
+
+    /**
+     * \brief count 명의 player(capsule) 를 2.5m 간격 격자에 흩어 놓습니다. 이웃과 가끔 겹칩니다.
+     */
+    inline std::vector<yc_physics::rigid_body_t> make_crowd(const int count) {
+        const int side = static_cast<int>(std::ceil(std::sqrt(count)));
+        std::vector<yc_physics::rigid_body_t> bodies(count);
+        for (int i = 0; i < count; ++i) {
+            auto& body = bodies[i];
+            body.target = yc_physics::make_capsule(0.9, 0.4);
+            body.rot = yc_math::qut_t{1, 0, 0, 0};
+            body.pos = {(i % side) * 2.5 + (i * 37 % 11) * 0.1, (i / side) * 2.5 + (i * 53 % 7) * 0.1, 0};
+            body.vel = {(i % 3 - 1) * 1.5, (i % 5 - 2) * 0.75, 0};
+            body.use_physic_simulate = true;
+        }
+        return bodies;
+    }
+
+    /**
+     * \brief 움직이는 player count 명의 broadphase 갱신 + 후보 pair 찾기 한 tick. item 은 body 하나입니다.
+     */
+    inline void run_broadphase(bench_state_t& state, const int count) {
+        auto bodies = make_crowd(count);
+        yc_physics::spatial_hash_grid_t grid;
+        for (const auto& body : bodies) grid.add(yc_physics::get_aabb(body));
+        state.set_items_per_iteration(count);
+        int tick = 0;
+        for (auto _ : state) {
+            // 방향을 바꿔가며 걸어서 일부 body 가 cell 을 넘나든다.
+            const double dir = (tick++ / 60) % 2 ? -1.0 / 60 : 1.0 / 60;
+            for (uint32_t i = 0; i < bodies.size(); ++i) {
+                bodies[i].pos += bodies[i].vel * dir;
+                grid.update(i, yc_physics::get_aabb(bodies[i]));
+            }
+            size_t pairs = 0;
+            grid.for_each_pair([&](uint32_t, uint32_t) { ++pairs; });
+            yc::test::do_not_optimize(pairs);
+        }
+    }
+
+    inline test_thread_pool& build_pool() {
+        static test_thread_pool pool(std::max(1u, std::thread::hardware_concurrency()));
+        return pool;
+    }
+}
+
+YC_BENCHMARK(physics_terrain_build_64) {
+    constexpr int size = 64;
+    const auto map = yc::test::bench::make_heightmap(size, size);
+    state.set_items_per_iteration((size - 1) * (size - 1));
+    for (auto _ : state) {
+        yc_physics::terrain_t terrain;
+        terrain.root_pos = {0, 0, 0};
+        terrain.build(map.data(), size, size, 1.0);
+        yc::test::do_not_optimize(terrain.triangle_indices.data());
+    }
+}
+
+YC_BENCHMARK(physics_terrain_build_512) {
+    yc::test::bench::run_terrain_build(state, 512, nullptr);
+}
+
+YC_BENCHMARK(physics_terrain_build_512_pool) {
+    yc::test::bench::run_terrain_build(state, 512, &yc::test::bench::build_pool());
+}
+
+// 큰 terrain 은 메모리를 많이 쓰므로 --filter=<이름> 으로 지정했을 때만 실행한다.
+YC_BENCHMARK_MANUAL(physics_terrain_build_2048) {
+    yc::test::bench::run_terrain_build(state, 2048, &yc::test::bench::build_pool());
+}
+
+YC_BENCHMARK_MANUAL(physics_terrain_build_8192) {
+    yc::test::bench::run_terrain_build(state, 8192, &yc::test::bench::build_pool());
+}
+
+// 서버 시작 때처럼 heightmap hash 를 확인하고 cache 파일을 mapping 한 뒤 index 범위를 훑는다.
+YC_BENCHMARK(physics_terrain_cache_load_512) {
+    constexpr int size = 512;
+    const auto map = yc::test::bench::make_heightmap(size, size);
+    const auto path = (std::filesystem::temp_directory_path() / "yc_bench_terrain_512.cache").string();
+    {
+        yc_physics::terrain_t terrain;
+        terrain.build(map.data(), size, size, 1.0);
+        yc_physics::save_terrain_cache(terrain, path, yc_physics::hash_heightmap(map.data(), size, size));
+    }
+    state.set_bytes_per_iteration(map.size());
+    for (auto _ : state) {
+        yc_physics::terrain_t terrain;
+        const bool loaded = yc_physics::load_terrain_cache(terrain, path, 1.0, yc_physics::hash_heightmap(map.data(), size, size));
+        yc::test::do_not_optimize(loaded);
+    }
+    std::filesystem::remove(path);
+}
+
+YC_BENCHMARK(physics_terrain_sample_surface) {
+    constexpr int size = 64;
+    const auto terrain = yc::test::bench::make_terrain(size, size);
+    std::vector<yc_math::vec3_t> points;
+    for (int i = 0; i < 1024; ++i) points.push_back({(i * 37 % 6300) / 100.0, (i * 91 % 6300) / 100.0, 0});
+    state.set_items_per_iteration(points.size());
+    for (auto _ : state) {
+        for (const auto& p : points) {
+            auto sample = terrain->sample_surface(p.x, p.y);
+            yc::test::do_not_optimize(sample);
+        }
+    }
+}
+
+// 같은 capsule 접촉을 cell 의 triangle 검사와 heightfield sample 로 비교한다.
+YC_BENCHMARK(physics_col_capsule_triangles) {
+    const auto terrain = yc::test::bench::make_terrain(64, 64);
+    const auto positions = yc::test::bench::make_contact_positions(*terrain, 1.2);
+    yc_physics::rigid_body_t rb;
+    rb.target = yc_physics::make_capsule(1.0, 0.5);
+    rb.rot = yc_math::qut_t{1, 0, 0, 0};
+    state.set_items_per_iteration(positions.size());
+    for (auto _ : state) {
+        for (const auto& p : positions) {
+            rb.pos = p;
+            auto hits = yc_physics::col(rb, *terrain);
+            yc::test::do_not_optimize(hits.data());
+        }
+    }
+}
+
+// 결과를 고정 크기 배열에 받는다. heap 할당이 없다.
+YC_BENCHMARK(physics_col_capsule_span) {
+    const auto terrain = yc::test::bench::make_terrain(64, 64);
+    const auto positions = yc::test::bench::make_contact_positions(*terrain, 1.2);
+    yc_physics::rigid_body_t rb;
+    rb.target = yc_physics::make_capsule(1.0, 0.5);
+    rb.rot = yc_math::qut_t{1, 0, 0, 0};
+    std::array<yc_physics::hit_data_t, 16> hits;
+    state.set_items_per_iteration(positions.size());
+    for (auto _ : state) {
+        for (const auto& p : positions) {
+            rb.pos = p;
+            auto count = yc_physics::col(rb, *terrain, hits);
+            yc::test::do_not_optimize(count);
+        }
+    }
+}
+
+YC_BENCHMARK(physics_col_capsule_deepest) {
+    const auto terrain = yc::test::bench::make_terrain(64, 64);
+    const auto positions = yc::test::bench::make_contact_positions(*terrain, 1.2);
+    yc_physics::rigid_body_t rb;
+    rb.target = yc_physics::make_capsule(1.0, 0.5);
+    rb.rot = yc_math::qut_t{1, 0, 0, 0};
+    state.set_items_per_iteration(positions.size());
+    for (auto _ : state) {
+        for (const auto& p : positions) {
+            rb.pos = p;
+            auto hit = yc_physics::deepest_contact(rb, *terrain);
+            yc::test::do_not_optimize(hit);
+        }
+    }
+}
+
+YC_BENCHMARK(physics_col_capsule_heightfield) {
+    const auto terrain = yc::test::bench::make_terrain(64, 64);
+    const auto positions = yc::test::bench::make_contact_positions(*terrain, 1.2);
+    yc_physics::rigid_body_t rb;
+    rb.target = yc_physics::make_capsule(1.0, 0.5);
+    rb.rot = yc_math::qut_t{1, 0, 0, 0};
+    const auto& capsule = std::get<yc_physics::capsule_t>(rb.target);
+    state.set_items_per_iteration(positions.size());
+    for (auto _ : state) {
+        for (const auto& p : positions) {
+            rb.pos = p;
+            auto hit = yc_physics::col_capsule_n_heightfield(capsule, rb, *terrain);
+            yc::test::do_not_optimize(hit);
+        }
+    }
+}
+
+// 같은 triangle 8개를 triangle 하나씩 scalar 로 검사한다. 아래 batch bench 의 기준.
+YC_BENCHMARK(physics_narrowphase_capsule_scalar) {
+    const auto triangles = yc::test::bench::make_narrowphase_triangles();
+    const yc_physics::capsule_segment_t segment(yc_physics::capsule_t(1.0, 0.5), { 0.1, 0.2, 1.3 },
+                                                yc_math::qut_t{ 1, 0, 0, 0 });
+    state.set_items_per_iteration(triangles.size());
+    for (auto _ : state) {
+        std::optional<yc_physics::hit_data_t> deepest;
+        for (const auto& t : triangles) {
+            auto hit = yc_physics::col_capsule_n_triangle(segment, t);
+            if (hit && (!deepest || hit->penetration_depth > deepest->penetration_depth)) deepest = hit;
+        }
+        yc::test::do_not_optimize(deepest);
+    }
+}
+
+YC_BENCHMARK(physics_narrowphase_capsule_batch) {
+    yc::test::bench::run_capsule_batch<yc_simd::native_t>(state);
+}
+
+YC_BENCHMARK(physics_narrowphase_capsule_batch_scalar_lane) {
+    yc::test::bench::run_capsule_batch<yc_simd::scalar_t>(state);
+}
+
+YC_BENCHMARK(physics_narrowphase_sphere_scalar) {
+    const auto triangles = yc::test::bench::make_narrowphase_triangles();
+    const yc_math::vec3_t center(0.1, 0.2, 0.3);
+    state.set_items_per_iteration(triangles.size());
+    for (auto _ : state) {
+        std::optional<yc_physics::hit_data_t> deepest;
+        for (const auto& t : triangles) {
+            auto hit = yc_physics::col_sphere_n_triangle(center, t, 0.5);
+            if (hit && (!deepest || hit->penetration_depth > deepest->penetration_depth)) deepest = hit;
+        }
+        yc::test::do_not_optimize(deepest);
+    }
+}
+
+YC_BENCHMARK(physics_narrowphase_sphere_batch) {
+    const auto triangles = yc::test::bench::make_narrowphase_triangles();
+    const yc_math::vec3_t center(0.1, 0.2, 0.3);
+    yc_physics::triangle_batch_t<> batch;
+    state.set_items_per_iteration(triangles.size());
+    for (auto _ : state) {
+        batch.clear();
+        for (const auto& t : triangles) batch.push(t);
+        auto hit = yc_physics::deepest_sphere_n_triangles(center, 0.5, batch);
+        yc::test::do_not_optimize(hit);
+    }
+}
+
+YC_BENCHMARK(physics_broadphase_1000) {
+    yc::test::bench::run_broadphase(state, 1000);
+}
+
+YC_BENCHMARK(physics_broadphase_4000) {
+    yc::test::bench::run_broadphase(state, 4000);
+}
+
+YC_BENCHMARK(physics_broadphase_16000) {
+    yc::test::bench::run_broadphase(state, 16000);
+}
+
+// broadphase 없이 모든 쌍의 AABB 를 비교한다. 위 bench 의 기준.
+YC_BENCHMARK(physics_broadphase_naive_1000) {
+    const auto bodies = yc::test::bench::make_crowd(1000);
+    std::vector<yc_physics::aabb_t> boxes;
+    for (const auto& body : bodies) boxes.push_back(yc_physics::get_aabb(body));
+    state.set_items_per_iteration(boxes.size());
+    for (auto _ : state) {
+        size_t pairs = 0;
+        for (size_t a = 0; a < boxes.size(); ++a)
+            for (size_t b = a + 1; b < boxes.size(); ++b) pairs += boxes[a].overlaps(boxes[b]);
+        yc::test::do_not_optimize(pairs);
+    }
+}
+
+// 걸어다니는 player 4000명을 body 끼리 충돌만 켜고 한 tick 진행한다.
+YC_BENCHMARK(physics_simulate_crowd_4000) {
+    auto bodies = yc::test::bench::make_crowd(4000);
+    yc_physics::physics_world<20> world;
+    for (auto& body : bodies) world.add_rigid_body(&body);
+    state.set_items_per_iteration(bodies.size());
+    for (auto _ : state) world.step();
+}
+
+// terrain 에 살짝 박힌 sphere 64개를 한 tick 진행한다.
+YC_BENCHMARK(physics_simulate_spheres_64) {
+    const auto terrain = yc::test::bench::make_terrain(64, 64);
+    const auto start = yc::test::bench::make_contact_positions(*terrain, 0.3);
+
+    yc_physics::physics_world<20> world;
+    world.add_terrain(terrain.get());
+    std::vector<yc_physics::rigid_body_t> bodies(start.size());
+    for (auto& body : bodies) {
+        body.target = yc_physics::sphere_t(0.5);
+        body.use_physic_simulate = true;
+        world.add_rigid_body(&body);
+    }
+
+    state.set_items_per_iteration(bodies.size());
+    for (auto _ : state) {
+        state.pause_timing();
+        for (size_t i = 0; i < bodies.size(); ++i) bodies[i].pos = start[i];
+        state.resume_timing();
+        world.step();
+    }
+}
+
+namespace yc::test::bench
+{
+    /**
+     * \brief terrain 에 살짝 박힌 capsule 64개를 한 tick 진행합니다.
+     * triangle_path_bodies 는 아래가 하나의 평평한 사각형이 아니어서 SIMD triangle 검사(deepest_contact)를 타는 body 수입니다.
+     */
+    inline void run_simulate_capsules(bench_state_t& state, yc_physics::terrain_t& terrain) {
+        constexpr int body_count = 64;
+        yc_physics::physics_world<20> world;
+        world.add_terrain(&terrain);
+
+        std::vector<yc_physics::rigid_body_t> bodies(body_count);
+        std::vector<yc_math::vec3_t> start(body_count);
+        size_t triangle_path = 0;
+        for (int i = 0; i < body_count; ++i) {
+            const double x = 4 + (i % 8) * 7;
+            const double y = 4 + (i / 8) * 7;
+            const double z = terrain.get_vertex(static_cast<int>(x), static_cast<int>(y)).z + 1.2;
+            bodies[i].target = yc_physics::make_capsule(1.0, 0.5);
+            bodies[i].rot = yc_math::qut_t{1, 0, 0, 0};
+            bodies[i].use_physic_simulate = true;
+            start[i] = {x + 0.25, y + 0.25, z};
+            bodies[i].pos = start[i];
+            world.add_rigid_body(&bodies[i]);
+
+            const yc_physics::capsule_segment_t segment(std::get<yc_physics::capsule_t>(bodies[i].target), bodies[i].pos, bodies[i].rot);
+            const auto min = segment.min_corner();
+            const auto max = segment.max_corner();
+            if (!terrain.is_single_flat_quad(terrain.overlapping_cells(min.x, min.y, max.x, max.y))) ++triangle_path;
+        }
+        state.set_counter("triangle_path_bodies", static_cast<double>(triangle_path));
+
+        state.set_items_per_iteration(body_count);
+        for (auto _ : state) {
+            state.pause_timing();
+            for (int i = 0; i < body_count; ++i) bodies[i].pos = start[i];
+            state.resume_timing();
+            world.step();
+        }
+    }
+}
+
+// 평지와 울퉁불퉁한 곳이 섞인 terrain.
+YC_BENCHMARK(physics_simulate_capsules_64) {
+    const auto terrain = yc::test::bench::make_terrain(64, 64);
+    yc::test::bench::run_simulate_capsules(state, *terrain);
+}
+
+// 모든 capsule 이 경사 위에 있어 tick 이 SIMD narrowphase 만 탄다.
+YC_BENCHMARK(physics_simulate_capsules_64_rough) {
+    std::vector<uint8_t> map(64 * 64);
+    for (int y = 0; y < 64; ++y)
+        for (int x = 0; x < 64; ++x) map[static_cast<size_t>(y) * 64 + x] = static_cast<uint8_t>(128 + (x * 7 + y * 13) % 5);
+    yc_physics::terrain_t terrain;
+    terrain.build(map.data(), 64, 64, 1.0);
+    yc::test::bench::run_simulate_capsules(state, terrain);
+}
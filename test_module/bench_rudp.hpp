@@ -0,0 +1,70 @@
+#pragma once
+#include "yc_test.hpp"
+#include "../packet/yc_rudp.hpp"
+
+namespace yc::test::bench
+{
+    // seq 가 붙은 ack 패킷. [ack | body...]
+    inline std::vector<char> make_rudp_packet(const int seq, const size_t body_size) {
+        std::vector<char> buf(1 + body_size, 1);
+        yc_pack::udp::convert_ack ack(seq);
+        ack.counter = seq;
+        buf[0] = static_cast<char>(ack.to_ack());
+        return buf;
+    }
+}
+
+// 한 window(ACK_COUNTER_MAX) 만큼의 패킷을 넣고 get_read_range 로 한번에 읽어 온다.
+YC_BENCHMARK(rudp_push_packet_read_range) {
+    yc_rudp::rudp_buffer_t buffer(1);
+    std::vector<yc_rudp::receive_packet_raw> no_ack_buf;
+    std::vector<std::vector<char>> packets;
+    for (int seq = 0; seq < ACK_COUNTER_MAX; ++seq) packets.push_back(yc::test::bench::make_rudp_packet(seq, 64));
+
+    int end = 0;
+    state.set_items_per_iteration(ACK_COUNTER_MAX);
+    for (auto _ : state) {
+        for (int i = 0; i < ACK_COUNTER_MAX; ++i) {
+            const auto& p = packets[(end + i) % ACK_COUNTER_MAX];
+            yc_rudp::push_packet(buffer.pkt_buffer, 0, 1, p.data(), p.size());
+        }
+        const auto range = yc_rudp::get_read_range(buffer.pkt_buffer, buffer.receive_buffer, no_ack_buf, 1, end);
+        yc::test::do_not_optimize(range);
+        no_ack_buf.clear();
+    }
+}
+
+// 재전송할 패킷이 없는 상태에서 in-flight 패킷 전체를 검사하는 비용.
+YC_BENCHMARK(rudp_get_resend_packets) {
+    yc_rudp::rudp_buffer_t buffer(1);
+    std::vector<int> resend_idx;
+    char body[64] {};
+    for (int seq = 0; seq < ACK_COUNTER_MAX; ++seq) {
+        yc_rudp::ready_to_send(buffer.send_buffer, resend_idx, body, sizeof(body), true, seq);
+    }
+    state.set_items_per_iteration(resend_idx.size());
+    for (auto _ : state) {
+        int rtt = 1000 * 60;
+        auto r = yc_rudp::get_resend_packets(buffer.send_buffer, resend_idx, rtt, 1000 * 1000);
+        yc::test::do_not_optimize(r);
+    }
+}
+
+// window 를 가득 보내고 ack 를 받아 모두 완료 처리한다.
+YC_BENCHMARK(rudp_send_complete) {
+    yc_rudp::rudp_buffer_t buffer(1);
+    std::vector<int> resend_idx;
+    resend_idx.reserve(ACK_COUNTER_MAX);
+    char body[64] {};
+    state.set_items_per_iteration(ACK_COUNTER_MAX);
+    for (auto _ : state) {
+        for (int seq = 0; seq < ACK_COUNTER_MAX; ++seq) {
+            yc_rudp::ready_to_send(buffer.send_buffer, resend_idx, body, sizeof(body), true, seq);
+        }
+        int rtt = 100;
+        for (int seq = 0; seq < ACK_COUNTER_MAX; ++seq) {
+            yc_rudp::set_send_complete(buffer.send_buffer, resend_idx, rtt, seq);
+        }
+        yc::test::do_not_optimize(resend_idx);
+    }
+}
@@ -0,0 +1,332 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <random>
+#include <span>
+#include <thread>
+#if defined(__linux__)
+#include <malloc.h>
+#include <unistd.h>
+#endif
+
+#include "yc_test.hpp"
+#include "../thread_pool.hpp"
+#include "../thread/nto_memory.hpp"
+#include "../srw_lock.hpp"
+#include "../seq_lock.hpp"
+
+namespace yc::test::bench
+{
+    struct nto_item_t {
+        int64_t value;
+        YC_USE int thread_id;
+    };
+
+    template <size_t Batch>
+    void run_nto_batch(bench_state_t& state) {
+        nto_memory<nto_item_t, 1> mem;
+        std::array<nto_item_t*, Batch> objs {};
+        state.set_items_per_iteration(Batch);
+        for (auto _ : state) {
+            const size_t n = mem.try_push_n(0, objs);
+            for (size_t i = 0; i < n; ++i) objs[i]->value = static_cast<int64_t>(i);
+            mem.make_readable_n(std::span(objs.data(), n));
+            const size_t r = mem.read_batch(objs);
+            mem.read_end_n(std::span(objs.data(), r));
+        }
+    }
+
+    /**
+     * \brief Producers 개의 write thread 가 한 round 에 per_round 개씩 try_push / make_readable 하고,
+     * 측정 thread 가 read thread 로서 모두 읽고 read_end 로 돌려줄 때까지를 한 iteration 으로 잽니다.
+     * write thread 는 benchmark 실행 동안 유지하고 round 번호로 깨워 thread 생성 비용이 섞이지 않게 한다.
+     */
+    template <int Producers>
+    void run_nto_contention(bench_state_t& state) {
+        constexpr int per_round = 256;
+        nto_memory<nto_item_t, Producers> mem;
+        std::atomic<uint64_t> round {0};
+        std::atomic<bool> stop {false};
+
+        std::vector<std::thread> writers;
+        for (int t = 0; t < Producers; ++t) {
+            writers.emplace_back([&, t] {
+                uint64_t seen = 0;
+                while (true) {
+                    round.wait(seen, std::memory_order_acquire);
+                    seen = round.load(std::memory_order_acquire);
+                    if (stop.load(std::memory_order_relaxed)) return;
+                    for (int i = 0; i < per_round; ++i) {
+                        nto_item_t* obj = nullptr;
+                        while (!mem.try_push(t, obj)) std::this_thread::yield();
+                        obj->value = i;
+                        mem.make_readable(obj);
+                    }
+                }
+            });
+        }
+
+        state.set_items_per_iteration(Producers * per_round);
+        for (auto _ : state) {
+            round.fetch_add(1, std::memory_order_release);
+            round.notify_all();
+            int consumed = 0;
+            while (consumed < Producers * per_round) {
+                const int before = consumed;
+                for (auto* it : mem.get_read_ranges()) {
+                    do_not_optimize(it->value);
+                    mem.read_end(it);
+                    ++consumed;
+                }
+                if (consumed == before) std::this_thread::yield();
+            }
+        }
+
+        stop.store(true, std::memory_order_relaxed);
+        round.fetch_add(1, std::memory_order_release);
+        round.notify_all();
+        for (auto& w : writers) w.join();
+    }
+
+    /**
+     * \brief Readers 개의 thread 가 한 round 에 per_round 번씩 r_lock / 읽기 / r_unlock 을 반복합니다.
+     * writer 가 없는 읽기 전용 상태에서 reader 수에 따라 처리량이 어떻게 늘어나는지 본다.
+     */
+    template <typename Lock, int Readers>
+    void run_reader_scaling(bench_state_t& state) {
+        constexpr int per_round = 1024;
+        Lock lock;
+        int64_t shared_value = 1;
+        std::atomic<uint64_t> round {0};
+        std::atomic<int> finished {0};
+        std::atomic<bool> stop {false};
+
+        std::vector<std::thread> readers;
+        for (int t = 0; t < Readers; ++t) {
+            readers.emplace_back([&] {
+                uint64_t seen = 0;
+                while (true) {
+                    round.wait(seen, std::memory_order_acquire);
+                    seen = round.load(std::memory_order_acquire);
+                    if (stop.load(std::memory_order_relaxed)) return;
+                    int64_t sum = 0;
+                    for (int i = 0; i < per_round; ++i) {
+                        r_srw_lock_guard<Lock> guard(lock);
+                        sum += shared_value;
+                    }
+                    do_not_optimize(sum);
+                    finished.fetch_add(1, std::memory_order_release);
+                    finished.notify_one();
+                }
+            });
+        }
+
+        state.set_items_per_iteration(Readers * per_round);
+        for (auto _ : state) {
+            finished.store(0, std::memory_order_relaxed);
+            round.fetch_add(1, std::memory_order_release);
+            round.notify_all();
+            for (int done = 0; done != Readers; done = finished.load(std::memory_order_acquire)) {
+                finished.wait(done, std::memory_order_acquire);
+            }
+        }
+
+        stop.store(true, std::memory_order_relaxed);
+        round.fetch_add(1, std::memory_order_release);
+        round.notify_all();
+        for (auto& r : readers) r.join();
+    }
+
+    // 64 byte world state snapshot.
+    struct snapshot_t {
+        int64_t words[8];
+    };
+
+    /**
+     * \brief 측정 thread 가 snapshot 을 반복해서 읽습니다. with_writer 면 다른 thread 가 계속 새 값을 씁니다.
+     * seq_lock 은 publish, srw_lock 은 w_lock 안의 복사로 쓴다.
+     */
+    template <typename Lock>
+    void run_snapshot_read(bench_state_t& state, const bool with_writer) {
+        constexpr int reads_per_iteration = 256;
+        constexpr bool is_seq_lock = std::is_same_v<Lock, seq_lock<snapshot_t>>;
+        Lock lock;
+        snapshot_t shared {};
+        std::atomic<bool> stop {false};
+
+        std::thread writer;
+        if (with_writer) {
+            writer = std::thread([&] {
+                snapshot_t next {};
+                while (!stop.load(std::memory_order_relaxed)) {
+                    for (auto& w : next.words) ++w;
+                    if constexpr (is_seq_lock) {
+                        lock.publish(next);
+                    } else {
+                        w_srw_lock_guard<Lock> guard(lock);
+                        shared = next;
+                    }
+                }
+            });
+        }
+
+        state.set_items_per_iteration(reads_per_iteration);
+        for (auto _ : state) {
+            int64_t sum = 0;
+            for (int i = 0; i < reads_per_iteration; ++i) {
+                snapshot_t copy;
+                if constexpr (is_seq_lock) {
+                    lock.read(copy);
+                } else {
+                    r_srw_lock_guard<Lock> guard(lock);
+                    copy = shared;
+                }
+                sum += copy.words[0] + copy.words[7];
+            }
+            do_not_optimize(sum);
+        }
+
+        stop.store(true, std::memory_order_relaxed);
+        if (writer.joinable()) writer.join();
+    }
+
+    // 현재 process 의 resident set size (MB). linux 가 아니면 0.
+    // 앞선 sample 이 free 한 heap 이 RSS 에 남아 차이가 0 으로 보이지 않도록 먼저 malloc_trim 한다.
+    inline double resident_mb() {
+#if defined(__linux__)
+#if defined(__GLIBC__)
+        malloc_trim(0);
+#endif
+        std::ifstream f("/proc/self/statm");
+        size_t total_pages = 0;
+        size_t resident_pages = 0;
+        f >> total_pages >> resident_pages;
+        return static_cast<double>(resident_pages) * static_cast<double>(sysconf(_SC_PAGESIZE)) / (1024.0 * 1024.0);
+#else
+        return 0;
+#endif
+    }
+
+    /**
+     * \brief 1M 개 객체를 가진 chunk 를 만들고 섞인 순서로 객체를 읽습니다.
+     * TLB miss 가 많은 접근이라 huge page 여부에 따른 차이가 드러난다. chunk 를 만들며 늘어난 RSS 를 rss_mb 로 보고한다.
+     */
+    inline void run_nto_page_access(bench_state_t& state, const bool use_huge_pages) {
+        constexpr int object_count = 1 << 20;
+        constexpr int reads_per_iteration = 4096;
+        const double rss_before = resident_mb();
+        nto_memory<nto_item_t, 1> mem(nto_memory_options{ .initial_capacity = object_count, .use_huge_pages = use_huge_pages });
+        state.set_counter("rss_mb", resident_mb() - rss_before);
+
+        std::vector<nto_item_t*> objs(object_count);
+        for (auto& obj : objs) mem.try_push(0, obj);
+        std::shuffle(objs.begin(), objs.end(), std::mt19937(42));
+
+        size_t cursor = 0;
+        state.set_items_per_iteration(reads_per_iteration);
+        for (auto _ : state) {
+            int64_t sum = 0;
+            for (int i = 0; i < reads_per_iteration; ++i) {
+                sum += objs[cursor]->value;
+                cursor = (cursor + 1) & (object_count - 1);
+            }
+            do_not_optimize(sum);
+        }
+    }
+}
+
+// 빈 작업 1024개를 넣고 모두 끝날 때까지의 처리량.
+YC_BENCHMARK(thread_pool_task_throughput) {
+    constexpr int task_count = 1024;
+    test_thread_pool pool(std::max(2u, std::thread::hardware_concurrency()));
+    std::atomic<int> done = 0;
+    state.set_items_per_iteration(task_count);
+    for (auto _ : state) {
+        done.store(0, std::memory_order_relaxed);
+        for (int i = 0; i < task_count; ++i) {
+            pool.add_task([&done] { done.fetch_add(1, std::memory_order_relaxed); });
+        }
+        while (done.load(std::memory_order_acquire) != task_count) std::this_thread::yield();
+    }
+}
+
+// 하나의 write thread 가 객체를 하나씩 넘기고 read thread 가 돌려주는 한 바퀴.
+YC_BENCHMARK(nto_memory_publish_consume) {
+    nto_memory<yc::test::bench::nto_item_t, 1> mem;
+    for (auto _ : state) {
+        yc::test::bench::nto_item_t* obj = nullptr;
+        mem.try_push(0, obj);
+        obj->value = 1;
+        mem.make_readable(obj);
+        for (auto* it : mem.get_read_ranges()) {
+            yc::test::do_not_optimize(it->value);
+            mem.read_end(it);
+        }
+    }
+}
+
+// 읽을 객체가 없거나 몇개뿐일 때 read thread 가 한번 훑는 비용. 1M 객체를 만들어 둔다.
+YC_BENCHMARK(nto_memory_idle_scan_1m) {
+    nto_memory<yc::test::bench::nto_item_t, 1> mem(nto_memory_options{ .initial_capacity = 1 << 20 });
+    for (auto _ : state) {
+        int n = 0;
+        for (auto* it : mem.get_read_ranges()) n += static_cast<int>(it->value);
+        yc::test::do_not_optimize(n);
+    }
+}
+
+YC_BENCHMARK(nto_memory_sparse_scan_1m) {
+    nto_memory<yc::test::bench::nto_item_t, 1> mem(nto_memory_options{ .initial_capacity = 1 << 20 });
+    // 1M 중 16개만 readable. 흩어져 있어 서로 다른 word 에 있다.
+    std::vector<yc::test::bench::nto_item_t*> objs(1 << 20);
+    for (auto& obj : objs) mem.try_push(0, obj);
+    for (int i = 0; i < 16; ++i) mem.make_readable(objs[static_cast<size_t>(i) * 65521]);
+    state.set_items_per_iteration(16);
+    for (auto _ : state) {
+        int n = 0;
+        for (auto* it : mem.get_read_ranges()) n += static_cast<int>(it->value);
+        yc::test::do_not_optimize(n);
+    }
+}
+
+// Batch 개씩 묶어서 넘기고 돌려주는 batch API. 1 은 단건 API 와 비교하기 위한 기준이다.
+YC_BENCHMARK(nto_memory_publish_consume_batch_1) { yc::test::bench::run_nto_batch<1>(state); }
+YC_BENCHMARK(nto_memory_publish_consume_batch_8) { yc::test::bench::run_nto_batch<8>(state); }
+YC_BENCHMARK(nto_memory_publish_consume_batch_64) { yc::test::bench::run_nto_batch<64>(state); }
+YC_BENCHMARK(nto_memory_publish_consume_batch_256) { yc::test::bench::run_nto_batch<256>(state); }
+
+// 같은 객체 수를 일반 page 와 huge page chunk 로 만들어 RSS 와 임의 접근 처리량을 비교한다.
+// huge page 가 예약되지 않은 시스템에서는 THP madvise 로 대체되므로 결과가 일반 page 와 비슷할 수 있다.
+YC_BENCHMARK(nto_memory_page_access_regular) { yc::test::bench::run_nto_page_access(state, false); }
+YC_BENCHMARK(nto_memory_page_access_huge) { yc::test::bench::run_nto_page_access(state, true); }
+
+// 여러 write thread 가 동시에 try_push / make_readable 하고 하나의 read thread 가 read_end 로 돌려준다.
+// returned_head 에 대한 CAS 경합과 write thread 별 free list 재사용 비용을 본다.
+YC_BENCHMARK(nto_memory_contention_2) { yc::test::bench::run_nto_contention<2>(state); }
+YC_BENCHMARK(nto_memory_contention_4) { yc::test::bench::run_nto_contention<4>(state); }
+YC_BENCHMARK(nto_memory_contention_8) { yc::test::bench::run_nto_contention<8>(state); }
+YC_BENCHMARK(nto_memory_contention_16) { yc::test::bench::run_nto_contention<16>(state); }
+
+// reader 수를 1 -> 64 로 늘리며 srw_lock 과 bravo_srw_lock 의 읽기 처리량을 비교한다.
+// srw_lock 은 모든 reader 가 state_ 하나를 CAS 하고, bravo_srw_lock 은 thread 별 slot 에만 쓴다.
+YC_BENCHMARK(srw_lock_readers_1) { yc::test::bench::run_reader_scaling<srw_lock, 1>(state); }
+YC_BENCHMARK(srw_lock_readers_2) { yc::test::bench::run_reader_scaling<srw_lock, 2>(state); }
+YC_BENCHMARK(srw_lock_readers_4) { yc::test::bench::run_reader_scaling<srw_lock, 4>(state); }
+YC_BENCHMARK(srw_lock_readers_8) { yc::test::bench::run_reader_scaling<srw_lock, 8>(state); }
+YC_BENCHMARK(srw_lock_readers_16) { yc::test::bench::run_reader_scaling<srw_lock, 16>(state); }
+YC_BENCHMARK(srw_lock_readers_32) { yc::test::bench::run_reader_scaling<srw_lock, 32>(state); }
+YC_BENCHMARK(srw_lock_readers_64) { yc::test::bench::run_reader_scaling<srw_lock, 64>(state); }
+YC_BENCHMARK(bravo_srw_lock_readers_1) { yc::test::bench::run_reader_scaling<bravo_srw_lock, 1>(state); }
+YC_BENCHMARK(bravo_srw_lock_readers_2) { yc::test::bench::run_reader_scaling<bravo_srw_lock, 2>(state); }
+YC_BENCHMARK(bravo_srw_lock_readers_4) { yc::test::bench::run_reader_scaling<bravo_srw_lock, 4>(state); }
+YC_BENCHMARK(bravo_srw_lock_readers_8) { yc::test::bench::run_reader_scaling<bravo_srw_lock, 8>(state); }
+YC_BENCHMARK(bravo_srw_lock_readers_16) { yc::test::bench::run_reader_scaling<bravo_srw_lock, 16>(state); }
+YC_BENCHMARK(bravo_srw_lock_readers_32) { yc::test::bench::run_reader_scaling<bravo_srw_lock, 32>(state); }
+YC_BENCHMARK(bravo_srw_lock_readers_64) { yc::test::bench::run_reader_scaling<bravo_srw_lock, 64>(state); }
+
+// 64 byte snapshot 읽기. writer 가 없을 때와 계속 publish 할 때 seq_lock 과 srw_lock 을 비교한다.
+YC_BENCHMARK(seq_lock_read) { yc::test::bench::run_snapshot_read<seq_lock<yc::test::bench::snapshot_t>>(state, false); }
+YC_BENCHMARK(seq_lock_read_with_writer) { yc::test::bench::run_snapshot_read<seq_lock<yc::test::bench::snapshot_t>>(state, true); }
+YC_BENCHMARK(srw_lock_snapshot_read) { yc::test::bench::run_snapshot_read<srw_lock>(state, false); }
+YC_BENCHMARK(srw_lock_snapshot_read_with_writer) { yc::test::bench::run_snapshot_read<srw_lock>(state, true); }
@@ -0,0 +1,19 @@
+#pragma once
+#include "yc_test.hpp"
+#include "../diag/yc_trace.hpp"
+
+// YC_TRACE_ENABLED 와 상관없이 zone 하나를 기록하는 비용.
+YC_BENCHMARK(trace_zone_overhead) {
+    for (auto _ : state) {
+        const yc_trace::zone_t zone("bench");
+        yc::test::clobber();
+    }
+}
+
+// 현재 build 설정의 YC_TRACE_ZONE. 꺼져 있으면 빈 loop 와 같아야 한다.
+YC_BENCHMARK(trace_zone_macro) {
+    for (auto _ : state) {
+        YC_TRACE_ZONE("bench");
+        yc::test::clobber();
+    }
+}
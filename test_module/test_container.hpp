@@ -0,0 +1,30 @@
+#pragma once
+#include "yc_test.hpp"
+#include "../container/yc_slot_map.hpp"
+
+// 삭제 순서(free list)가 달라도 살아있는 원소가 같으면 같은 map 이다.
+YC_TEST(slot_map_equality_compares_live_elements) {
+    yc::slot_map<int> a;
+    const auto h0 = a.insert(10);
+    const auto h1 = a.insert(20);
+    const auto h2 = a.insert(30);
+    YC_CHECK(a == a);
+
+    auto f = a;
+    f.erase(h1);
+    f.erase(h0);
+    auto g = a;
+    g.erase(h0);
+    g.erase(h1);
+    YC_CHECK(f == g);
+    YC_CHECK(!(f == a));
+
+    g[h2] = 31;
+    YC_CHECK(!(f == g));
+    g[h2] = 30;
+
+    // 같은 값이라도 다시 넣은 원소는 handle 이 달라 다른 원소다.
+    f.erase(h2);
+    f.insert(30);
+    YC_CHECK(!(f == g));
+}
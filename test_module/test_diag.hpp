@@ -0,0 +1,281 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+
+#include "yc_test.hpp"
+#include "../diag/yc_log.hpp"
+#include "../diag/yc_metrics.hpp"
+#include "../diag/yc_trace.hpp"
+
+namespace yc::test::unit
+{
+    // json 문자열이 모두 닫혀 있고, 문자열 안에 escape 되지 않은 제어 문자가 없는지 본다.
+    inline bool json_strings_closed(const std::string_view json) {
+        bool in_string = false;
+        for (size_t i = 0; i < json.size(); ++i) {
+            const char ch = json[i];
+            if (!in_string) {
+                if (ch == '"') in_string = true;
+                continue;
+            }
+            if (static_cast<unsigned char>(ch) < 0x20) return false;
+            if (ch == '\\') ++i;
+            else if (ch == '"') in_string = false;
+        }
+        return !in_string;
+    }
+
+    // background thread 가 출력한 log 줄을 모아둔다. 없어지면 stderr 로 되돌린다.
+    struct log_capture_t {
+        std::mutex m;
+        std::vector<std::string> lines;
+
+        log_capture_t() {
+            yc_log::set_sink([this](yc_log::level_t, const std::string_view line) {
+                std::lock_guard lock(m);
+                lines.emplace_back(line);
+            });
+        }
+        ~log_capture_t() {
+            yc_log::set_sink([](yc_log::level_t, const std::string_view line) {
+                std::fwrite(line.data(), 1, line.size(), stderr);
+                std::fputc('\n', stderr);
+            });
+        }
+
+        std::vector<std::string> take() {
+            yc_log::flush();
+            std::lock_guard lock(m);
+            return std::exchange(lines, {});
+        }
+    };
+
+    inline std::string format_log(const char* format, const auto&... args) {
+        yc_log::detail::arg_t a[sizeof...(args) + 1] {};
+        size_t i = 0;
+        (yc_log::detail::capture(a[i++], args), ...);
+        std::string out;
+        yc_log::detail::format_to(out, format, a, sizeof...(args));
+        return out;
+    }
+}
+
+// 작은 값은 값마다 bucket 이 하나씩이고, 그 위로는 2의 거듭제곱 구간마다 16개로 나뉜다.
+static_assert(yc_metrics::histogram_t::bucket_of(0) == 0);
+static_assert(yc_metrics::histogram_t::bucket_of(15) == 15);
+static_assert(yc_metrics::histogram_t::bucket_of(16) == 16);
+static_assert(yc_metrics::histogram_t::bucket_of(31) == 31);
+static_assert(yc_metrics::histogram_t::bucket_of(32) == 32);
+static_assert(yc_metrics::histogram_t::bucket_of(33) == 32);
+static_assert(yc_metrics::histogram_t::bucket_of(uint64_t{1} << 63) == 16 + 59 * 16);
+static_assert(yc_metrics::histogram_t::bucket_of(std::numeric_limits<uint64_t>::max()) ==
+              yc_metrics::histogram_t::bucket_count - 1);
+
+// 값은 자기 bucket 의 범위 (앞 bucket 의 upper, upper] 안에 있고, upper 와의 차이는 값의 1/16 이하여야 한다.
+YC_TEST(metrics_histogram_bucket_bounds) {
+    using histogram_t = yc_metrics::histogram_t;
+    static_assert(histogram_t::bucket_upper(0) == 0);
+    static_assert(histogram_t::bucket_upper(15) == 15);
+    static_assert(histogram_t::bucket_upper(16) == 16);
+    static_assert(histogram_t::bucket_upper(histogram_t::bucket_of(uint64_t{1} << 63)) == (uint64_t{17} << 59) - 1);
+    static_assert(histogram_t::bucket_upper(histogram_t::bucket_count - 1) == std::numeric_limits<uint64_t>::max());
+
+    int wrong = 0;
+    std::string first;
+    auto check = [&](const uint64_t v) {
+        const size_t b = histogram_t::bucket_of(v);
+        const uint64_t upper = histogram_t::bucket_upper(b);
+        const bool in_bucket = upper >= v && (b == 0 || histogram_t::bucket_upper(b - 1) < v);
+        if (in_bucket && upper - v <= v / 16) return;
+        if (wrong++ == 0) first = "v " + std::to_string(v) + " bucket " + std::to_string(b) + " upper " + std::to_string(upper);
+    };
+    for (uint64_t v = 0; v < 4096; ++v) check(v);
+    for (int e = 4; e < 64; ++e) {
+        const uint64_t p = uint64_t{1} << e;
+        check(p - 1);
+        check(p);
+        check(p + 1);
+    }
+    check(std::numeric_limits<uint64_t>::max());
+    std::mt19937_64 rng(7);
+    for (int i = 0; i < 100000; ++i) check(rng() >> (rng() % 64));
+    YC_CHECK_MSG(wrong == 0, std::to_string(wrong) + " values outside their bucket, first: " + first);
+}
+
+YC_TEST(metrics_histogram_percentile) {
+    yc_metrics::histogram_t h;
+    YC_CHECK(h.snapshot().percentile(0.5) == 0);
+
+    for (uint64_t v = 1; v <= 100; ++v) h.record(v);
+    const auto snap = h.snapshot();
+    YC_CHECK(snap.count == 100);
+    YC_CHECK(snap.sum == 5050);
+    // q 분위수는 그 값이 들어있는 bucket 의 upper 이므로 값보다 작지 않고 1/16 이상 크지 않다.
+    auto near = [](const double p, const double v) { return p >= v && p <= v * (1 + 1.0 / 16); };
+    YC_CHECK(snap.percentile(0) == 1);
+    YC_CHECK(near(snap.percentile(0.5), 50));
+    YC_CHECK(near(snap.percentile(0.99), 99));
+    YC_CHECK(near(snap.percentile(1), 100));
+}
+
+// save 는 겹치지 않는 임시 파일에 쓰고 rename 하므로 끝난 뒤 결과 파일만 남아야 한다.
+YC_TEST(metrics_save_leaves_no_temp_file) {
+    namespace fs = std::filesystem;
+    const fs::path dir = fs::temp_directory_path() / ("yc_test_metrics_" + std::to_string(::getpid()));
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    const std::string path = (dir / "yc.prom").string();
+
+    yc_metrics::counter("yc_test_save_total", "save test 용 counter").add(3);
+    YC_CHECK(yc_metrics::save(path));
+    YC_CHECK(yc_metrics::save(path));
+    YC_CHECK(std::distance(fs::directory_iterator(dir), fs::directory_iterator()) == 1);
+
+    std::stringstream text;
+    text << std::ifstream(path).rdbuf();
+    YC_CHECK(text.str().find("yc_test_save_total 3") != std::string::npos);
+    YC_CHECK((fs::status(path).permissions() & fs::perms::others_read) != fs::perms::none);
+
+    YC_CHECK(!yc_metrics::save((dir / "missing" / "yc.prom").string()));
+    fs::remove_all(dir);
+}
+
+YC_TEST(log_format_to) {
+    using yc::test::unit::format_log;
+    YC_CHECK(format_log("seq {} rtt {}", 7, 12.5) == "seq 7 rtt 12.5");
+    YC_CHECK(format_log("{} {} {} {}", -1, 2u, true, "name") == "-1 2 true name");
+    // {{ 와 }} 는 괄호 하나가 되고 인자를 쓰지 않는다.
+    YC_CHECK(format_log("{{}} {}", 1) == "{} 1");
+    YC_CHECK(format_log("{{{}}}", 1) == "{1}");
+    YC_CHECK(format_log("a { b } c", 1) == "a { b } c");
+    // 인자가 모자라면 {} 를 그대로 두고, 남는 인자는 무시한다.
+    YC_CHECK(format_log("{} and {}", 1) == "1 and {}");
+    YC_CHECK(format_log("no args {}") == "no args {}");
+    YC_CHECK(format_log("x", 1, 2) == "x");
+    // 문자열은 inline_string_size 까지만 복사한다.
+    YC_CHECK(format_log("{}", std::string(40, 'a')) == std::string(yc_log::inline_string_size, 'a'));
+}
+
+// 한 window 안에서는 rate_limit 개까지만 통과하고, 다음 window 의 첫 log 가 생략한 수를 가져간다.
+YC_TEST(log_rate_limit_window) {
+    yc_log::site_t site { yc_log::level_t::info, __FILE__, __LINE__, "x", 3 };
+    const uint64_t tps = yc_log::detail::logger_t::instance().ticks_per_second();
+    // window 경계에서 떨어진 tick 을 써서 background thread 의 보정에 흔들리지 않게 한다.
+    auto at = [tps](const uint64_t window) { return window * tps + tps / 2; };
+
+    uint32_t suppressed = 0;
+    int allowed = 0;
+    for (int i = 0; i < 5; ++i) {
+        allowed += yc_log::detail::allow(site, at(10), suppressed);
+        YC_CHECK(suppressed == 0);
+    }
+    YC_CHECK(allowed == 3);
+    YC_CHECK(site.suppressed.load() == 2);
+
+    YC_CHECK(yc_log::detail::allow(site, at(11), suppressed));
+    YC_CHECK(suppressed == 2);
+    YC_CHECK(yc_log::detail::allow(site, at(11), suppressed));
+    YC_CHECK(suppressed == 0);
+
+    // rate_limit 0 은 제한하지 않는다.
+    yc_log::site_t unlimited { yc_log::level_t::info, __FILE__, __LINE__, "x", 0 };
+    allowed = 0;
+    for (int i = 0; i < 100; ++i) allowed += yc_log::detail::allow(unlimited, at(10), suppressed);
+    YC_CHECK(allowed == 100);
+}
+
+// 생략한 수는 다음 window 에 남긴 log 끝에 "(N suppressed)" 로 붙는다.
+YC_TEST(log_suppressed_suffix) {
+    yc::test::unit::log_capture_t capture;
+    // logger 가 처음 시작하면 background thread 가 tick 속도를 보정하면서 window 번호가 바뀐다. 먼저 시작시켜 둔다.
+    static yc_log::site_t warmup { yc_log::level_t::info, "test.cpp", 1, "warmup", 0 };
+    yc_log::write(warmup);
+    capture.take();
+
+    static yc_log::site_t site { yc_log::level_t::info, "test.cpp", 1, "seq {}", 2 };
+    for (int i = 0; i < 5; ++i) yc_log::write(site, i);
+    auto lines = capture.take();
+    YC_CHECK_MSG(lines.size() == 2, std::to_string(lines.size()) + " lines");
+    YC_CHECK(lines.size() == 2 && lines[0].ends_with("seq 0") && lines[1].ends_with("seq 1"));
+    YC_CHECK(lines.size() == 2 && lines[0].find("[INFO]") != std::string::npos);
+
+    // 1초를 기다리는 대신 window 를 지난 것으로 되돌린다.
+    site.window.store(0);
+    yc_log::write(site, 5);
+    lines = capture.take();
+    YC_CHECK(lines.size() == 1 && lines[0].ends_with("seq 5 (3 suppressed)"));
+}
+
+// background thread 가 sink 에서 멈춘 동안 ring 이 가득 차면 버리고, 버린 수를 한번 알린다.
+YC_TEST(log_drop_accounting) {
+    yc::test::unit::log_capture_t capture;
+    std::mutex m;
+    std::condition_variable cv;
+    bool entered = false;
+    bool open = false;
+    yc_log::set_sink([&](yc_log::level_t, const std::string_view line) {
+        std::unique_lock lock(m);
+        entered = true;
+        cv.notify_all();
+        cv.wait(lock, [&] { return open; });
+        capture.lines.emplace_back(line);
+    });
+
+    static yc_log::site_t site { yc_log::level_t::info, "test.cpp", 1, "seq {}", 0 };
+    yc_log::write(site, 0);
+    {
+        std::unique_lock lock(m);
+        cv.wait(lock, [&] { return entered; });
+    }
+    // 첫 record 는 sink 가 끝날 때까지 ring 에 남아 있으므로 ring_capacity - 1 개만 더 들어간다.
+    constexpr int extra = 10;
+    for (int i = 1; i <= static_cast<int>(yc_log::ring_capacity) + extra; ++i) yc_log::write(site, i);
+    {
+        std::lock_guard lock(m);
+        open = true;
+    }
+    cv.notify_all();
+
+    const auto lines = capture.take();
+    size_t records = 0;
+    int drop_notices = 0;
+    bool counted = false;
+    for (const auto& line : lines) {
+        if (line.starts_with("[yc_log]")) {
+            ++drop_notices;
+            counted = line.ends_with("dropped " + std::to_string(extra + 1) + " records");
+        }
+        else ++records;
+    }
+    YC_CHECK_MSG(records == yc_log::ring_capacity, std::to_string(records) + " records");
+    YC_CHECK(drop_notices == 1);
+    YC_CHECK(counted);
+    YC_CHECK(!lines.empty() && lines.back().starts_with("[yc_log]"));
+}
+
+YC_TEST(trace_json_escapes_names)
+{
+    std::thread([] {
+        yc_trace::set_thread_name("worker \"a\\b\"\n");
+        const yc_trace::zone_t zone("zone \"q\"\t\x01\\");
+    }).join();
+
+    std::ostringstream os;
+    yc_trace::write_chrome_json(os);
+    const std::string json = os.str();
+    YC_CHECK(json.find(R"("name":"worker \"a\\b\"\n")") != std::string::npos);
+    YC_CHECK(json.find(R"("name":"zone \"q\"\t\u0001\\")") != std::string::npos);
+    YC_CHECK(yc::test::unit::json_strings_closed(json));
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <thread>
+#include <vector>
+
+#include "yc_test.hpp"
+#include "../memory/yc_pool_allocator.hpp"
+#include "../memory/yc_pool_function.hpp"
+
+namespace yc::test::unit
+{
+    // pool 의 thread cache 보다 먼저 만들어져 나중에 소멸하는 thread_local.
+    struct late_pool_user_t {
+        void* block = nullptr;
+        bool allocated_after_teardown = false;
+
+        ~late_pool_user_t() {
+            yc_mem::deallocate(block, 64);
+            void* p = yc_mem::allocate(64);
+            allocated_after_teardown = p != nullptr && reinterpret_cast<uintptr_t>(p) % yc_mem::pool_alignment == 0;
+            yc_mem::deallocate(p, 64);
+            if (result) *result = allocated_after_teardown;
+        }
+
+        std::atomic<bool>* result = nullptr;
+    };
+
+    inline thread_local late_pool_user_t late_pool_user;
+}
+
+// thread 종료 중 cache holder 가 소멸한 뒤에 불린 allocate / deallocate 도 안전해야 한다.
+YC_TEST(pool_allocator_free_after_thread_cache_teardown) {
+    std::atomic<bool> ok {false};
+    std::thread([&ok] {
+        // late_pool_user 를 먼저 만들고 그 다음 cache holder 를 만든다. 소멸은 반대 순서다.
+        auto& user = yc::test::unit::late_pool_user;
+        user.result = &ok;
+        user.block = yc_mem::allocate(64);
+    }).join();
+    YC_CHECK(ok.load());
+
+    // 반환된 cache 를 다른 thread 가 다시 가져가 써도 문제가 없어야 한다.
+    for (int t = 0; t < 4; ++t) {
+        std::thread([] {
+            std::vector<void*> blocks;
+            for (int i = 0; i < 1000; ++i) blocks.push_back(yc_mem::allocate(64));
+            for (auto* b : blocks) yc_mem::deallocate(b, 64);
+        }).join();
+    }
+}
+
+// inline 에 들어가는 capture 와 pool 에 할당되는 capture 모두 move 후 한번만 소멸해야 한다.
+YC_TEST(pool_function_move_and_destroy) {
+    struct counted_t {
+        int* destroyed;
+        int64_t padding[12];
+        bool moved_from = false;
+
+        counted_t(int* d) : destroyed(d), padding{} { }
+        counted_t(counted_t&& o) noexcept : destroyed(o.destroyed), padding{} { o.moved_from = true; }
+        ~counted_t() { if (!moved_from) ++*destroyed; }
+        int operator()() const { return 7; }
+    };
+    int destroyed = 0;
+    {
+        yc_mem::pool_function<int()> f(counted_t{ &destroyed });
+        yc_mem::pool_function<int()> g(std::move(f));
+        YC_CHECK(!f);
+        YC_CHECK(g() == 7);
+        f = std::move(g);
+        YC_CHECK(f() == 7);
+    }
+    YC_CHECK(destroyed == 1);
+
+    int small_calls = 0;
+    yc_mem::pool_function<void(int)> small([&small_calls](const int n) { small_calls += n; });
+    auto moved = std::move(small);
+    moved(3);
+    YC_CHECK(small_calls == 3);
+
+    // pool 에 span 이 생긴 뒤로는 큰 capture 도 global new 를 부르지 않는다.
+    const int64_t big[16] {};
+    auto make_big = [&big] { return yc_mem::pool_function<int64_t()>([big] { return big[15]; }); };
+    make_big();
+    const uint64_t before = yc::test::allocation_count();
+    for (int i = 0; i < 100; ++i) YC_CHECK(make_big()() == 0);
+    YC_CHECK(yc::test::allocation_count() == before);
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#include "yc_test.hpp"
+#include "../packet/packets.hpp"
+
+// 문자열은 에러로 암시적 변환되지 않는다. err_t 는 명시적으로 만들어야 한다.
+static_assert(!std::is_convertible_v<const char*, yc::err_t>);
+static_assert(std::is_convertible_v<const char*, yc::result_t<std::string>>);
+static_assert(std::is_convertible_v<const char*, yc::result_t<const char*>>);
+static_assert(!std::is_convertible_v<const char*, yc::result_t<int>>);
+
+// 문자열만으로 만든 에러는 내용으로 비교하고, 값이 있을 때의 error() (에러 없음) 와 같아지지 않는다.
+static_assert(yc::err_t("a") == yc::err_t("a"));
+static_assert(yc::err_t("a") != yc::err_t("b"));
+static_assert(yc::err_t("a") != yc::err_t{});
+static_assert(yc::result_t<int>(1).error() == yc::err_t{});
+static_assert(yc::result_t<int>(yc::err_t("a")).error() != yc::result_t<int>(1).error());
+static_assert(yc::err_t(yc::err_category_t::packet, 1, "x") == yc::err_t(yc::err_category_t::packet, 1, "y"));
+
+YC_TEST(result_t_string_literal_is_value) {
+    yc::result_t<std::string> s = "ok";
+    YC_CHECK(s.has_value());
+    YC_CHECK(s.has_value() && *s == "ok");
+
+    yc::result_t<const char*> p = "ok";
+    YC_CHECK(p.has_value());
+    YC_CHECK(p.has_value() && std::strcmp(*p, "ok") == 0);
+
+    yc::result_t<std::string> e = yc::err_t("failed");
+    YC_CHECK(!e.has_value());
+    YC_CHECK(!e.has_value() && std::strcmp(e.error().msg, "failed") == 0);
+}
+
+// ack 가 아닌 패킷이 header 보다 짧으면 header 를 읽기 전에 실패해야 한다.
+YC_TEST(packet_verify_rejects_short_packet) {
+    char buf[1 + yc_pack::HEADER_SIZE] = {};
+    yc_pack::udp::convert_ack ack(0);
+    buf[0] = static_cast<char>(ack.to_ack());
+    const auto size = static_cast<packet_size_type>(yc_pack::HEADER_SIZE);
+    std::memcpy(buf + 1, &size, sizeof(size));
+
+    for (size_t len = 1; len < sizeof(buf); ++len) {
+        const auto r = yc_pack::verify(buf, len);
+        YC_CHECK_MSG(!r.has_value() && r.error().code == static_cast<int>(yc_pack::verify_err::too_short),
+                     "len " + std::to_string(len));
+        YC_CHECK(!yc_pack::pkt_vrfct(buf, len));
+    }
+    YC_CHECK(yc_pack::verify(buf, sizeof(buf)).has_value());
+    YC_CHECK(yc_pack::pkt_vrfct(buf, sizeof(buf)));
+}
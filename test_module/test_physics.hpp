@@ -0,0 +1,549 @@
+#pragma once
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <limits>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "yc_test.hpp"
+#include "../game/yc_physics.hpp"
+#include "../game/yc_terrain_cache.hpp"
+
+namespace yc::test::unit
+{
+    // 64x64 경사 terrain. (x + y) 방향으로 완만하게 올라가고 8칸마다 평지가 섞인다.
+    inline std::unique_ptr<yc_physics::terrain_t> make_test_terrain(const int size) {
+        std::vector<uint8_t> map(static_cast<size_t>(size) * size);
+        for (int y = 0; y < size; ++y) {
+            for (int x = 0; x < size; ++x) {
+                const int h = (x / 8 + y / 8) % 3 == 0 ? 0 : (x * 7 + y * 13) % 5;
+                map[static_cast<size_t>(y) * size + x] = static_cast<uint8_t>(128 + h);
+            }
+        }
+        auto terrain = std::make_unique<yc_physics::terrain_t>();
+        terrain->root_pos = {0, 0, 0};
+        terrain->build(map.data(), size, size, 1.0);
+        return terrain;
+    }
+
+    struct reference_mesh_t {
+        std::vector<uint32_t> triangle_indices;
+        std::vector<uint32_t> cell_first_triangle;
+    };
+
+    /**
+     * \brief terrain_t::build 와 같은 규칙으로 cell 을 합치는 단순한 mesher.
+     * 사각형을 키울 때마다 사각형 전체를 다시 검사한다.
+     */
+    inline reference_mesh_t reference_mesh(const std::vector<uint8_t>& map, const int width, const int height) {
+        const int cw = width - 1;
+        const int ch = height - 1;
+        auto raw = [&](const int x, const int y) -> int { return map[static_cast<size_t>(y) * width + x]; };
+        auto flat = [&](const int x, const int y) -> int {
+            const int h = raw(x, y);
+            return h == raw(x + 1, y) && h == raw(x, y + 1) && h == raw(x + 1, y + 1) ? h : -1;
+        };
+        std::vector<bool> mark(static_cast<size_t>(cw) * ch, false);
+        auto check_box = [&](const int x, const int y, const int w, const int h) {
+            if (w > cw - 1 || h > ch - 1) return false;
+            const int base = flat(x, y);
+            if (base == -1) return false;
+            for (int j = y; j <= h; ++j) {
+                for (int i = x; i <= w; ++i) {
+                    if (mark[static_cast<size_t>(j) * cw + i] || flat(i, j) != base) return false;
+                }
+            }
+            return true;
+        };
+
+        reference_mesh_t mesh;
+        mesh.cell_first_triangle.assign(static_cast<size_t>(cw) * ch, 0);
+        for (int y = 0; y < ch; ++y) {
+            for (int x = 0; x < cw; ++x) {
+                if (mark[static_cast<size_t>(y) * cw + x]) continue;
+                int w = x;
+                int h = y;
+                bool f = true, s = true, t = true;
+                while (f || s || t) {
+                    if (t && check_box(x, y, w + 1, h + 1)) {
+                        w++;
+                        h++;
+                    }
+                    else {
+                        t = false;
+                        f = check_box(x, y, w + 1, h);
+                        s = check_box(x, y, w, h + 1);
+                        // 두 방향이 모두 되어도 모서리 cell 이 안되면 오른쪽으로만 키운다.
+                        if (f && s && !check_box(x, y, w + 1, h + 1)) s = false;
+                        if (f) w++;
+                        if (s) h++;
+                    }
+                }
+                const uint32_t v0 = y * width + x;
+                const uint32_t v1 = y * width + w + 1;
+                const uint32_t v2 = (h + 1) * width + x;
+                const uint32_t v3 = (h + 1) * width + w + 1;
+                const auto first = static_cast<uint32_t>(mesh.triangle_indices.size() / 3);
+                mesh.triangle_indices.insert(mesh.triangle_indices.end(), { v0, v1, v2, v1, v2, v3 });
+                for (int j = y; j <= h; ++j) {
+                    for (int i = x; i <= w; ++i) {
+                        mark[static_cast<size_t>(j) * cw + i] = true;
+                        mesh.cell_first_triangle[static_cast<size_t>(j) * cw + i] = first;
+                    }
+                }
+            }
+        }
+        return mesh;
+    }
+
+    /**
+     * \brief 평지 block 과 울퉁불퉁한 곳이 섞인 임의의 heightmap.
+     */
+    inline std::vector<uint8_t> make_random_heightmap(std::mt19937& rng, const int width, const int height) {
+        std::vector<uint8_t> map(static_cast<size_t>(width) * height);
+        const int block = 1 + static_cast<int>(rng() % 6);
+        const int levels = 1 + static_cast<int>(rng() % 3);
+        const uint32_t seed = rng();
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                // block 마다 같은 높이로 하고, 가끔 한 점만 튀게 한다.
+                std::mt19937 block_rng(seed ^ static_cast<uint32_t>((x / block) * 7919 + (y / block) * 104729));
+                int h = static_cast<int>(block_rng() % levels);
+                if (rng() % 23 == 0) h += 1;
+                map[static_cast<size_t>(y) * width + x] = static_cast<uint8_t>(128 + h);
+            }
+        }
+        return map;
+    }
+
+    /**
+     * \brief 각 cell 이 자기 사각형 안에 있고, 합쳐진 사각형의 cell 은 모두 같은 높이로 평평해야 한다.
+     */
+    inline bool check_mesh_covers_cells(const yc_physics::terrain_t& terrain, std::string& why) {
+        std::vector<size_t> cells_of_triangle(terrain.triangle_count(), 0);
+        for (int y = 0; y < terrain.cell_height(); ++y) {
+            for (int x = 0; x < terrain.cell_width(); ++x) {
+                const uint32_t tri = terrain.first_triangle_of(x, y);
+                if (tri + 1 >= terrain.triangle_count()) {
+                    why = "cell (" + std::to_string(x) + ", " + std::to_string(y) + ") triangle out of range";
+                    return false;
+                }
+                const uint32_t v0 = terrain.triangle_indices[tri * 3];
+                const uint32_t v3 = terrain.triangle_indices[tri * 3 + 5];
+                const int x0 = static_cast<int>(v0 % terrain.width), y0 = static_cast<int>(v0 / terrain.width);
+                const int x1 = static_cast<int>(v3 % terrain.width), y1 = static_cast<int>(v3 / terrain.width);
+                if (x < x0 || x >= x1 || y < y0 || y >= y1) {
+                    why = "cell (" + std::to_string(x) + ", " + std::to_string(y) + ") outside its quad";
+                    return false;
+                }
+                const bool merged = x1 - x0 > 1 || y1 - y0 > 1;
+                if (merged && terrain.get_cell_flat_height(x, y) != terrain.get_raw_height(x0, y0)) {
+                    why = "cell (" + std::to_string(x) + ", " + std::to_string(y) + ") is not flat but merged";
+                    return false;
+                }
+                ++cells_of_triangle[tri];
+            }
+        }
+        for (size_t tri = 0; tri < terrain.triangle_count(); tri += 2) {
+            const uint32_t v0 = terrain.triangle_indices[tri * 3];
+            const uint32_t v3 = terrain.triangle_indices[tri * 3 + 5];
+            const size_t area = static_cast<size_t>(v3 % terrain.width - v0 % terrain.width) * (v3 / terrain.width - v0 / terrain.width);
+            if (cells_of_triangle[tri] != area) {
+                why = "quad " + std::to_string(tri / 2) + " owns " + std::to_string(cells_of_triangle[tri]) + " of " + std::to_string(area) + " cells";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * \brief 한 step 뒤 어느 capsule 도 terrain triangle 에 tolerance 보다 깊이 박혀있지 않은지 확인한다.
+     */
+    inline void check_capsules_resolved(const yc_physics::terrain_t& terrain, const std::vector<yc_physics::rigid_body_t>& bodies,
+                                        const double tolerance, const std::string& where) {
+        for (size_t i = 0; i < bodies.size(); ++i) {
+            const auto hit = yc_physics::deepest_contact(bodies[i], terrain);
+            YC_CHECK_MSG(!hit || hit->penetration_depth < tolerance,
+                         where + " body " + std::to_string(i) + " depth " + std::to_string(hit ? hit->penetration_depth : 0.0));
+        }
+    }
+}
+
+// 지형에 박힌 capsule 은 한 step 뒤 triangle 에 박혀있지 않아야 한다. 누운 capsule 도 같다.
+YC_TEST(physics_world_pushes_capsules_out_of_terrain) {
+    // 완만한 언덕과 평지. 경사가 급하면 법선 방향으로 밀어낸 곳이 옆 triangle 아래라 한 step 에 다 빠져나오지 못한다.
+    constexpr int size = 64;
+    std::vector<uint8_t> map(static_cast<size_t>(size) * size);
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            const double hill = y < size / 2 ? 4 * std::sin(x / 6.0) * std::cos(y / 7.0) : 0.0;
+            map[static_cast<size_t>(y) * size + x] = static_cast<uint8_t>(128 + std::lround(hill));
+        }
+    }
+    const auto terrain = std::make_unique<yc_physics::terrain_t>();
+    terrain->build(map.data(), size, size, 1.0);
+    yc_physics::physics_world<20> world;
+    world.add_terrain(terrain.get());
+
+    std::vector<yc_physics::rigid_body_t> bodies(16);
+    for (int i = 0; i < static_cast<int>(bodies.size()); ++i) {
+        auto& body = bodies[i];
+        const double x = 6 + (i % 4) * 14.3;
+        const double y = 6 + (i / 4) * 14.7;
+        const double surface = terrain->sample_surface(x, y).height;
+        body.target = yc_physics::make_capsule(1.0, 0.5);
+        // 절반은 서 있고 절반은 x 축으로 누워 있다. 둘 다 아래쪽이 0.2 만큼 박혀 있다.
+        const bool lying = i % 2;
+        body.rot = lying ? yc_math::qut_t{std::cos(0.7854), std::sin(0.7854), 0, 0} : yc_math::qut_t{1, 0, 0, 0};
+        body.pos = {x, y, surface + (lying ? 0.5 : 1.5) - 0.2};
+        body.use_physic_simulate = true;
+        world.add_rigid_body(&body);
+    }
+    world.step();
+    yc::test::unit::check_capsules_resolved(*terrain, bodies, 1e-6, "hills");
+}
+
+// 평지에서 한 cell 만에 높이 10 이 솟은 벽. 벽 앞 평지에 선 capsule 은 축 아래 표면에는 닿지 않고 벽 경사면에만 박힌다.
+// 축 아래만 보는 col_capsule_n_heightfield 는 이 충돌을 놓친다.
+YC_TEST(physics_world_pushes_capsules_out_of_steep_step) {
+    constexpr int size = 16;
+    std::vector<uint8_t> map(static_cast<size_t>(size) * size);
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) map[static_cast<size_t>(y) * size + x] = static_cast<uint8_t>(x <= 6 ? 128 : 138);
+    }
+    const auto terrain = std::make_unique<yc_physics::terrain_t>();
+    terrain->build(map.data(), size, size, 1.0);
+    yc_physics::physics_world<20> world;
+    world.add_terrain(terrain.get());
+
+    std::vector<yc_physics::rigid_body_t> bodies(1);
+    bodies[0].target = yc_physics::make_capsule(1.0, 0.8);
+    bodies[0].rot = yc_math::qut_t{1, 0, 0, 0};
+    bodies[0].pos = {5.5, 8, 1.8};
+    bodies[0].use_physic_simulate = true;
+    world.add_rigid_body(&bodies[0]);
+
+    const auto before = yc_physics::deepest_contact(bodies[0], *terrain);
+    YC_CHECK(before && before->penetration_depth > 0.1);
+    YC_CHECK(!yc_physics::col_capsule_n_heightfield(std::get<yc_physics::capsule_t>(bodies[0].target), bodies[0], *terrain));
+    world.step();
+    // 벽에서 멀어지는 쪽으로 밀린다.
+    YC_CHECK(bodies[0].pos.x < 5.5);
+    yc::test::unit::check_capsules_resolved(*terrain, bodies, 1e-6, "step");
+}
+
+// 임의의 heightmap 에서 build 결과가 단순한 mesher 와 같아야 한다. pool 을 쓰든 안쓰든 같다.
+YC_TEST(terrain_build_matches_reference_mesher) {
+    std::mt19937 rng(20240611);
+    test_thread_pool pool(2);
+    for (int round = 0; round < 300; ++round) {
+        const int width = 2 + static_cast<int>(rng() % 40);
+        const int height = 2 + static_cast<int>(rng() % 40);
+        const auto map = yc::test::unit::make_random_heightmap(rng, width, height);
+        const auto expected = yc::test::unit::reference_mesh(map, width, height);
+
+        for (test_thread_pool* p : { static_cast<test_thread_pool*>(nullptr), &pool }) {
+            yc_physics::terrain_t terrain;
+            YC_CHECK(terrain.build(map.data(), width, height, 1.0, p));
+            const std::string where = "round " + std::to_string(round) + (p ? " with pool" : " without pool");
+            YC_CHECK_MSG(std::ranges::equal(terrain.triangle_indices, expected.triangle_indices), where + ": triangles differ");
+            YC_CHECK_MSG(std::ranges::equal(terrain.cell_first_triangle, expected.cell_first_triangle), where + ": cell triangles differ");
+            std::string why;
+            YC_CHECK_MSG(yc::test::unit::check_mesh_covers_cells(terrain, why), where + ": " + why);
+        }
+    }
+}
+
+// 사용량이 안정된 뒤의 step 은 global operator new 를 부르지 않아야 한다.
+// body 끼리, body 와 terrain 이 계속 부딪히며 broadphase cell 을 넘나들도록 걷게 한다.
+YC_TEST(physics_world_step_steady_state_no_allocations) {
+    YC_CHECK_MSG(yc::test::allocation_counter() != nullptr, "yc_alloc_counter.hpp 가 include 되지 않았습니다");
+    constexpr int size = 64;
+    constexpr int body_count = 64;
+    constexpr int half_cycle = 60;
+    const auto terrain = yc::test::unit::make_test_terrain(size);
+
+    yc_physics::physics_world<20> world(2.0);
+    world.add_terrain(terrain.get());
+    std::vector<yc_physics::rigid_body_t> bodies(body_count);
+    for (int i = 0; i < body_count; ++i) {
+        auto& body = bodies[i];
+        const double x = 8 + (i % 8) * 6;
+        const double y = 8 + (i / 8) * 6;
+        if (i % 2) body.target = yc_physics::make_capsule(1.0, 0.5);
+        else body.target = yc_physics::sphere_t(0.5);
+        body.rot = yc_math::qut_t{1, 0, 0, 0};
+        body.pos = {x, y, terrain->get_vertex(static_cast<int>(x), static_cast<int>(y)).z + 0.3};
+        body.vel = {(i % 3 - 1) * 3.0, (i % 5 - 2) * 1.5, 0};
+        body.use_physic_simulate = true;
+        world.add_rigid_body(&body);
+    }
+
+    int tick = 0;
+    auto run = [&](const int ticks) {
+        for (int i = 0; i < ticks; ++i, ++tick) {
+            // 왕복하므로 warmup 동안 지나간 cell 만 다시 지나간다.
+            if (tick % half_cycle == 0 && tick) {
+                for (auto& body : bodies) body.vel = -1.0 * body.vel;
+            }
+            world.step();
+        }
+    };
+    // broadphase cell 의 bucket 은 처음 지나가거나 처음으로 여러 body 가 몰릴 때만 커진다.
+    // 충돌로 경로가 조금씩 밀리므로 충분히 왕복시켜 그런 cell 을 다 거치게 한다.
+    run(half_cycle * 40);
+    const uint64_t before = yc::test::allocation_count();
+    run(half_cycle * 8);
+    const uint64_t allocations = yc::test::allocation_count() - before;
+    YC_CHECK_MSG(allocations == 0, std::to_string(allocations) + " allocations in steady-state steps");
+    // body pair 목록은 world 의 tick arena 에서 할당한다.
+    YC_CHECK(world.tick_scratch_peak_bytes() > 0);
+}
+
+// 저장은 임시 파일을 남기지 않고, 범위 밖 index 가 들어있는 cache 는 붙이지 않아야 한다.
+YC_TEST(terrain_cache_rejects_out_of_range_indices) {
+    namespace fs = std::filesystem;
+    const fs::path dir = fs::temp_directory_path() / ("yc_test_terrain_cache_" + std::to_string(::getpid()));
+    fs::create_directories(dir);
+    const std::string path = (dir / "map.terrain").string();
+
+    const auto built = yc::test::unit::make_test_terrain(32);
+    YC_CHECK(yc_physics::save_terrain_cache(*built, path, 1));
+    YC_CHECK(yc_physics::save_terrain_cache(*built, path, 1));
+    YC_CHECK(std::distance(fs::directory_iterator(dir), fs::directory_iterator()) == 1);
+
+    {
+        yc_physics::terrain_t loaded;
+        YC_CHECK(yc_physics::load_terrain_cache(loaded, path, 1.0, 1));
+        YC_CHECK(std::ranges::equal(loaded.triangle_indices, built->triangle_indices));
+        YC_CHECK(std::ranges::equal(loaded.cell_first_triangle, built->cell_first_triangle));
+    }
+
+    yc_physics::terrain_cache_header_t header {};
+    {
+        std::ifstream f(path, std::ios::binary);
+        f.read(reinterpret_cast<char*>(&header), sizeof(header));
+    }
+    auto corrupt_and_load = [&](const uint64_t offset, const uint32_t value) {
+        YC_CHECK(yc_physics::save_terrain_cache(*built, path, 1));
+        {
+            std::fstream f(path, std::ios::binary | std::ios::in | std::ios::out);
+            f.seekp(static_cast<std::streamoff>(offset));
+            f.write(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+        yc_physics::terrain_t loaded;
+        return yc_physics::load_terrain_cache(loaded, path, 1.0, 1);
+    };
+    const auto last_index = header.triangle_indices_offset + (header.triangle_indices_count - 1) * sizeof(uint32_t);
+    YC_CHECK(!corrupt_and_load(last_index, static_cast<uint32_t>(header.heights_count)));
+    const auto last_cell = header.cell_first_triangle_offset + (header.cell_first_triangle_count - 1) * sizeof(uint32_t);
+    YC_CHECK(!corrupt_and_load(last_cell, static_cast<uint32_t>(header.triangle_indices_count / 3 - 1)));
+    YC_CHECK(corrupt_and_load(last_cell, 0));
+
+    fs::remove_all(dir);
+}
+
+namespace yc::test::unit
+{
+    constexpr double kernel_depth_tolerance = 1e-5;
+    constexpr double kernel_normal_tolerance = 1e-4;
+
+    /**
+     * \brief triangle 마다 scalar 함수로 검사한 hit 들과 kernel 의 가장 깊은 hit 을 비교한다.
+     * 깊이가 같은 hit 이 여럿이면 kernel 이 그 중 어느 것을 골라도 된다.
+     * 반올림 때문에 깊이가 tolerance 이하인 스치는 hit 은 한쪽에만 있어도 된다.
+     */
+    inline bool same_deepest_hit(const std::vector<std::optional<yc_physics::hit_data_t>>& hits,
+                                 const std::optional<yc_physics::hit_data_t>& got, std::string& why) {
+        std::optional<yc_physics::hit_data_t> deepest;
+        for (const auto& h : hits) {
+            if (h && (!deepest || h->penetration_depth > deepest->penetration_depth)) deepest = h;
+        }
+        if (deepest.has_value() != got.has_value()) {
+            const double depth = deepest ? deepest->penetration_depth : got->penetration_depth;
+            if (depth <= kernel_depth_tolerance) return true;
+            why = std::string(got ? "kernel hit, scalar missed" : "scalar hit, kernel missed") + " (depth " + std::to_string(depth) + ")";
+            return false;
+        }
+        if (!deepest) return true;
+
+        const double dd = std::abs(deepest->penetration_depth - got->penetration_depth);
+        if (dd > kernel_depth_tolerance) {
+            why = "depth " + std::to_string(deepest->penetration_depth) + " vs " + std::to_string(got->penetration_depth);
+            return false;
+        }
+        for (const auto& h : hits) {
+            if (!h || std::abs(h->penetration_depth - got->penetration_depth) > kernel_depth_tolerance) continue;
+            const double dn = yc_math::magnitude(h->penetration_normal - got->penetration_normal);
+            // 퇴화한 triangle 은 양쪽 모두 NaN 법선을 낸다.
+            const bool both_nan = std::isnan(yc_math::magnitude(h->penetration_normal)) && std::isnan(yc_math::magnitude(got->penetration_normal));
+            if (dn <= kernel_normal_tolerance || both_nan) return true;
+        }
+        why = "normal differs from every scalar hit at depth " + std::to_string(got->penetration_depth);
+        return false;
+    }
+
+    /**
+     * \brief 임의의 capsule / sphere 와 1 ~ 8 개 triangle batch 를 Lane kernel 과 scalar 함수로 검사해 비교한다.
+     * \return 다른 결과 수
+     */
+    template <typename Lane>
+    int compare_narrowphase_kernel(const char* lane_name, const int rounds) {
+        std::mt19937 rng(11);
+        auto coord = [&] { return static_cast<double>(rng() % 2000) / 1000.0 - 1.0; };
+        int failures = 0;
+        for (int round = 0; round < rounds; ++round) {
+            yc_physics::triangle_batch_t<8> batch;
+            std::vector<yc_physics::triangle_t> triangles;
+            const int n = 1 + static_cast<int>(rng() % 8);
+            for (int k = 0; k < n; ++k) {
+                const yc_physics::triangle_t t{
+                    {coord() * 2, coord() * 2, coord() * 0.5},
+                    {coord() * 2, coord() * 2, coord() * 0.5},
+                    {coord() * 2, coord() * 2, coord() * 0.5}
+                };
+                triangles.push_back(t);
+                batch.push(t);
+            }
+            const yc_physics::capsule_t capsule(0.3 + (rng() % 10) / 10.0, 0.2 + (rng() % 5) / 10.0);
+            const double angle = (rng() % 314) / 100.0;
+            const yc_math::qut_t rot{std::cos(angle / 2), std::sin(angle / 2), 0, 0};
+            const yc_math::vec3_t pos{coord(), coord(), coord()};
+            const yc_physics::capsule_segment_t segment(capsule, pos, rot);
+
+            std::vector<std::optional<yc_physics::hit_data_t>> capsule_hits, sphere_hits;
+            for (const auto& t : triangles) {
+                capsule_hits.push_back(yc_physics::col_capsule_n_triangle(segment, t));
+                sphere_hits.push_back(yc_physics::col_sphere_n_triangle(pos, t, capsule.radius));
+            }
+
+            std::string why;
+            auto capsule_batch = batch;
+            if (!same_deepest_hit(capsule_hits, yc_physics::deepest_capsule_n_triangles<Lane>(segment, capsule_batch), why)) {
+                if (++failures <= 5) YC_CHECK_MSG(false, std::string(lane_name) + " capsule round " + std::to_string(round) + ": " + why);
+            }
+            auto sphere_batch = batch;
+            if (!same_deepest_hit(sphere_hits, yc_physics::deepest_sphere_n_triangles<Lane>(pos, capsule.radius, sphere_batch), why)) {
+                if (++failures <= 5) YC_CHECK_MSG(false, std::string(lane_name) + " sphere round " + std::to_string(round) + ": " + why);
+            }
+        }
+        return failures;
+    }
+}
+
+// SIMD kernel 은 triangle 하나씩 검사하는 scalar 함수와 같은 hit 을 내야 한다.
+// avx2 kernel 은 -mavx2 -mfma 로 build 했을 때만 검사된다.
+YC_TEST(physics_narrowphase_kernels_match_scalar) {
+    constexpr int rounds = 20000;
+    int failures = yc::test::unit::compare_narrowphase_kernel<yc_simd::scalar_t>("scalar", rounds);
+#ifdef YC_SIMD_HAS_SSE2
+    failures += yc::test::unit::compare_narrowphase_kernel<yc_simd::sse2_t>("sse2", rounds);
+#endif
+#ifdef YC_SIMD_HAS_AVX2
+    failures += yc::test::unit::compare_narrowphase_kernel<yc_simd::avx2_t>("avx2", rounds);
+#endif
+    YC_CHECK_MSG(failures == 0, std::to_string(failures) + " kernel results differ from scalar");
+}
+
+namespace yc::test::unit
+{
+    inline bool is_finite_box(const yc_physics::aabb_t& box) {
+        return std::isfinite(box.min.x) && std::isfinite(box.min.y) && std::isfinite(box.min.z) &&
+               std::isfinite(box.max.x) && std::isfinite(box.max.y) && std::isfinite(box.max.z);
+    }
+}
+
+// 움직이고, 커지고, NaN 이 되고, 지워지고 추가되는 box 들에서 grid 의 pair / query 가 모든 쌍을 비교한 결과와 같아야 한다.
+YC_TEST(physics_broadphase_matches_naive_while_moving) {
+    using yc_physics::aabb_t;
+    using yc_math::vec3_t;
+    std::mt19937 rng(5);
+    auto r = [&](const double lo, const double hi) { return std::uniform_real_distribution<double>(lo, hi)(rng); };
+    constexpr double nan = std::numeric_limits<double>::quiet_NaN();
+    constexpr double inf = std::numeric_limits<double>::infinity();
+    auto random_box = [&] {
+        const vec3_t c{r(-20, 20), r(-20, 20), r(-3, 3)};
+        const vec3_t e{r(0.1, 2), r(0.1, 2), r(0.1, 2)};
+        return aabb_t{c - e, c + e};
+    };
+
+    for (const double cell_size : {0.5, 2.0, 4.0, 16.0}) {
+        yc_physics::spatial_hash_grid_t grid(cell_size);
+        std::vector<aabb_t> boxes;
+        for (int i = 0; i < 400; ++i) {
+            boxes.push_back(random_box());
+            grid.add(boxes.back());
+        }
+        for (int step = 0; step < 30; ++step) {
+            for (uint32_t i = 0; i < boxes.size(); ++i) {
+                const uint32_t kind = rng() % 100;
+                if (kind == 0) boxes[i] = {{r(-1e12, 0), r(-1e12, 0), -1}, {r(0, 1e12), r(0, 1e12), 1}};
+                else if (kind == 1) boxes[i].min.x = nan;
+                else if (kind == 2) boxes[i].max.y = inf;
+                else if (kind < 5 || !yc::test::unit::is_finite_box(boxes[i])) boxes[i] = random_box();
+                else {
+                    const vec3_t d{r(-1, 1), r(-1, 1), r(-0.2, 0.2)};
+                    boxes[i] = {boxes[i].min + d, boxes[i].max + d};
+                }
+                grid.update(i, boxes[i]);
+            }
+            for (int k = 0; k < 5; ++k) {
+                const uint32_t id = rng() % boxes.size();
+                grid.remove(id);
+                boxes[id] = boxes.back();
+                boxes.pop_back();
+                boxes.push_back(random_box());
+                grid.add(boxes.back());
+            }
+            YC_CHECK(grid.size() == boxes.size());
+
+            std::set<std::pair<uint32_t, uint32_t>> got, expected;
+            int duplicates = 0;
+            grid.for_each_pair([&](const uint32_t a, const uint32_t b) {
+                if (a >= b || !got.insert({a, b}).second) ++duplicates;
+            });
+            for (uint32_t a = 0; a < boxes.size(); ++a) {
+                if (!yc::test::unit::is_finite_box(boxes[a])) continue;
+                for (uint32_t b = a + 1; b < boxes.size(); ++b) {
+                    if (yc::test::unit::is_finite_box(boxes[b]) && boxes[a].overlaps(boxes[b])) expected.insert({a, b});
+                }
+            }
+            const std::string where = "cell " + std::to_string(cell_size) + " step " + std::to_string(step);
+            YC_CHECK_MSG(duplicates == 0, where + ": " + std::to_string(duplicates) + " duplicate pairs");
+            YC_CHECK_MSG(got == expected, where + ": " + std::to_string(got.size()) + " pairs, expected " + std::to_string(expected.size()));
+
+            for (const aabb_t& query : { aabb_t{{-3, -3, -10}, {3, 3, 10}}, aabb_t{{-1e9, -1e9, -10}, {1e9, 1e9, 10}} }) {
+                std::set<uint32_t> found, expected_ids;
+                grid.query(query, [&](const uint32_t id) {
+                    if (!found.insert(id).second) ++duplicates;
+                });
+                for (uint32_t id = 0; id < boxes.size(); ++id) {
+                    if (yc::test::unit::is_finite_box(boxes[id]) && query.overlaps(boxes[id])) expected_ids.insert(id);
+                }
+                YC_CHECK_MSG(found == expected_ids && duplicates == 0, where + ": query differs");
+            }
+        }
+    }
+}
+
+// 뺀 body 는 더이상 움직이지 않고, 남은 body 의 broadphase id 가 어긋나지 않아야 한다.
+YC_TEST(physics_world_remove_rigid_body) {
+    yc_physics::physics_world<20> world(2.0);
+    std::vector<yc_physics::rigid_body_t> bodies(3);
+    for (int i = 0; i < 3; ++i) {
+        bodies[i].target = yc_physics::sphere_t(0.5);
+        bodies[i].rot = yc_math::qut_t{1, 0, 0, 0};
+        bodies[i].pos = {i * 0.6, 0, 0};
+        bodies[i].use_physic_simulate = true;
+        world.add_rigid_body(&bodies[i]);
+    }
+    YC_CHECK(world.remove_rigid_body(&bodies[0]));
+    YC_CHECK(!world.remove_rigid_body(&bodies[0]));
+    world.step();
+    YC_CHECK(bodies[0].pos.x == 0.0);
+    // 남은 두 body 는 서로 밀어내 떨어진다.
+    YC_CHECK(bodies[2].pos.x - bodies[1].pos.x >= 1.0 - 1e-9);
+}
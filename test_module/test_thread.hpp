@@ -0,0 +1,634 @@
+#pragma once
+#include <algorithm>
+#include <random>
+#include <utility>
+
+#include "yc_test.hpp"
+#include "../thread_pool.hpp"
+#include "../thread/nto_memory.hpp"
+#include "../thread/lf_queue.hpp"
+#include "../srw_lock.hpp"
+#include "../seq_lock.hpp"
+
+namespace yc::test::unit
+{
+    // worker 하나를 gate 작업으로 막아두고 그 사이에 lane 별 작업을 쌓는다.
+    struct gate_t {
+        std::mutex m;
+        std::condition_variable cv;
+        bool entered = false;
+        bool open = false;
+
+        void hold() {
+            std::unique_lock lock(m);
+            entered = true;
+            cv.notify_all();
+            cv.wait(lock, [this] { return open; });
+        }
+        void wait_entered() {
+            std::unique_lock lock(m);
+            cv.wait(lock, [this] { return entered; });
+        }
+        void release() {
+            {
+                std::lock_guard lock(m);
+                open = true;
+            }
+            cv.notify_all();
+        }
+    };
+
+    struct nto_payload_t {
+        int64_t value;
+        // 항상 value * 3 + 1. read thread 가 반쯤 쓰인 객체를 보면 어긋난다.
+        int64_t check;
+        int64_t writer;
+        YC_USE int thread_id;
+    };
+
+    // 모든 word 가 같은 값이어야 하는 payload. 여러 cache line 에 걸치도록 크게 잡는다.
+    struct snapshot_payload_t {
+        int64_t words[24];
+    };
+
+    struct mpsc_node_t {
+        std::atomic<mpsc_node_t*> next;
+        int producer;
+        int value;
+    };
+
+    // producer 번호와 순번을 하나의 값으로 묶는다.
+    inline uint64_t queue_item(const int producer, const int i) {
+        return static_cast<uint64_t>(producer) << 32 | static_cast<uint32_t>(i);
+    }
+}
+
+// 먼저 들어온 background 작업보다 realtime, tick 작업이 먼저 실행되어야 한다.
+YC_TEST(thread_pool_lane_order) {
+    std::vector<char> order;
+    std::mutex order_mutex;
+    std::latch done(6);
+    yc::test::unit::gate_t gate;
+    {
+        test_thread_pool pool(1);
+        pool.add_task([&] { gate.hold(); }, task_priority::realtime);
+        gate.wait_entered();
+
+        auto record = [&](const char c) {
+            return [&, c] {
+                {
+                    std::lock_guard lock(order_mutex);
+                    order.push_back(c);
+                }
+                done.count_down();
+            };
+        };
+        for (int i = 0; i < 3; ++i) pool.add_task(record('B'), task_priority::background);
+        for (int i = 0; i < 2; ++i) pool.add_task(record('T'), task_priority::tick);
+        pool.add_task(record('R'), task_priority::realtime);
+        YC_CHECK(pool.get_queue_size(task_priority::background) == 3);
+        YC_CHECK(pool.get_queue_size(task_priority::tick) == 2);
+        YC_CHECK(pool.get_queue_size(task_priority::realtime) == 1);
+
+        gate.release();
+        done.wait();
+    }
+    YC_CHECK((order == std::vector<char>{ 'R', 'T', 'T', 'B', 'B', 'B' }));
+}
+
+// background 작업은 background_limit 개 까지만 동시에 실행되고, 남은 worker 는 tick 작업을 받는다.
+YC_TEST(thread_pool_background_limit) {
+    constexpr int background_jobs = 16;
+    std::atomic<int> running{0};
+    std::atomic<int> max_running{0};
+    std::latch background_done(background_jobs);
+    {
+        test_thread_pool pool(4);
+        pool.set_background_limit(2);
+        for (int i = 0; i < background_jobs; ++i) {
+            pool.add_task([&] {
+                const int now = running.fetch_add(1) + 1;
+                int prev = max_running.load();
+                while (prev < now && !max_running.compare_exchange_weak(prev, now)) { }
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                running.fetch_sub(1);
+                background_done.count_down();
+            }, task_priority::background);
+        }
+
+        // background 가 limit 만큼 worker 를 잡고 있어도 tick 작업은 바로 실행된다.
+        std::latch tick_done(1);
+        pool.add_task([&] { tick_done.count_down(); }, task_priority::tick);
+        tick_done.wait();
+        YC_CHECK(!background_done.try_wait());
+
+        background_done.wait();
+    }
+    YC_CHECK(max_running.load() <= 2);
+    YC_CHECK(max_running.load() >= 1);
+}
+
+// deadline 이 지난 뒤 끝난 작업만 그 lane 의 miss 로 집계된다.
+YC_TEST(thread_pool_deadline_miss) {
+    yc::test::unit::gate_t gate;
+    test_thread_pool pool(1);
+    pool.add_task([&] { gate.hold(); }, task_priority::realtime);
+    gate.wait_entered();
+
+    using namespace std::chrono_literals;
+    // 이미 지난 deadline 3개, 충분히 먼 deadline 2개, deadline 없음 1개.
+    const auto past = test_thread_pool::clock_type::now() - 1ms;
+    for (int i = 0; i < 3; ++i) pool.add_task([] { }, task_priority::tick, past);
+    for (int i = 0; i < 2; ++i) pool.add_task([] { }, task_priority::realtime, 1h);
+    pool.add_task([] { }, task_priority::background, past);
+    pool.add_task([] { }, task_priority::realtime);
+
+    // worker 가 하나이므로 마지막 background 작업이 실행될 때는 앞의 작업의 miss 집계가 끝나 있다.
+    std::latch last(1);
+    pool.add_task([&] { last.count_down(); }, task_priority::background);
+    gate.release();
+    last.wait();
+
+    YC_CHECK(pool.get_deadline_miss_count(task_priority::tick) == 3);
+    YC_CHECK(pool.get_deadline_miss_count(task_priority::realtime) == 0);
+    YC_CHECK(pool.get_deadline_miss_count(task_priority::background) == 1);
+}
+
+// write thread 여러개와 read thread 하나. ThreadSanitizer build 로 돌려 data race 가 없는지 확인한다.
+// initial_capacity 를 작게 잡아 read thread 가 순회하는 도중에 chunk 가 늘어나게 한다.
+YC_TEST(nto_memory_writers_one_reader_stress) {
+    constexpr int writers = 4;
+    constexpr int per_writer = 20000;
+    using payload_t = yc::test::unit::nto_payload_t;
+    nto_memory<payload_t, writers> mem(nto_memory_options{ .initial_capacity = 16 });
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < writers; ++t) {
+        threads.emplace_back([&mem, t] {
+            std::array<payload_t*, 8> batch {};
+            int i = 0;
+            while (i < per_writer) {
+                // 단건 API 와 batch API 를 번갈아 쓴다.
+                if (i % 3 == 0) {
+                    payload_t* obj = nullptr;
+                    if (!mem.try_push(t, obj)) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    *obj = payload_t{ i, i * 3 + 1, t, t };
+                    mem.make_readable(obj);
+                    ++i;
+                    continue;
+                }
+                const size_t want = std::min<size_t>(batch.size(), per_writer - i);
+                const size_t n = mem.try_push_n(t, std::span(batch.data(), want));
+                for (size_t k = 0; k < n; ++k) {
+                    *batch[k] = payload_t{ i, i * 3 + 1, t, t };
+                    ++i;
+                }
+                mem.make_readable_n(std::span(batch.data(), n));
+                if (n == 0) std::this_thread::yield();
+            }
+        });
+    }
+
+    std::array<int, writers> received {};
+    std::array<int64_t, writers> sum {};
+    int total = 0;
+    bool torn = false;
+    std::array<payload_t*, 32> batch {};
+    while (total < writers * per_writer) {
+        int got = 0;
+        for (auto* obj : mem.get_read_ranges()) {
+            if (obj->check != obj->value * 3 + 1 || obj->writer != obj->thread_id) torn = true;
+            ++received[obj->thread_id];
+            sum[obj->thread_id] += obj->value;
+            mem.read_end(obj);
+            ++got;
+        }
+        const size_t n = mem.read_batch(batch);
+        for (size_t k = 0; k < n; ++k) {
+            auto* obj = batch[k];
+            if (obj->check != obj->value * 3 + 1 || obj->writer != obj->thread_id) torn = true;
+            ++received[obj->thread_id];
+            sum[obj->thread_id] += obj->value;
+        }
+        mem.read_end_n(std::span(batch.data(), n));
+        got += static_cast<int>(n);
+        total += got;
+        if (got == 0) std::this_thread::yield();
+    }
+    for (auto& t : threads) t.join();
+
+    YC_CHECK(!torn);
+    for (int t = 0; t < writers; ++t) {
+        YC_CHECK(received[t] == per_writer);
+        YC_CHECK(sum[t] == static_cast<int64_t>(per_writer) * (per_writer - 1) / 2);
+    }
+    int readable_left = 0;
+    mem.for_each_readable([&](payload_t*) { ++readable_left; });
+    YC_CHECK(readable_left == 0);
+}
+
+// 무작위로 넘기고 돌려주며 get_read_ranges / read_batch / for_each_readable 가 readable 객체를 정확히 돌려주는지
+// 기준 집합과 비교한다. chunk 크기가 word 크기의 배수가 아니도록 잡아 word / summary / chunk 경계를 지나게 한다.
+YC_TEST(nto_memory_read_ranges_match_reference) {
+    using payload_t = yc::test::unit::nto_payload_t;
+    nto_memory<payload_t, 1> mem(nto_memory_options{ .initial_capacity = 100 });
+    // chunk 100, 200, ..., 6400 을 빈 slot 없이 모두 쓴다.
+    constexpr int object_count = 100 * ((1 << 7) - 1);
+    std::vector<payload_t*> objs(object_count);
+    for (int i = 0; i < object_count; ++i) {
+        YC_CHECK(mem.try_push(0, objs[i]));
+        objs[i]->value = i;
+    }
+
+    std::mt19937 rng(3);
+    std::vector<bool> readable(object_count, false);
+    std::vector<payload_t*> held(object_count);
+    for (int i = 0; i < object_count; ++i) held[i] = objs[i];
+    int mismatches = 0;
+    auto expect = [&](std::vector<int> got, const char* where) {
+        std::ranges::sort(got);
+        std::vector<int> want;
+        for (int i = 0; i < object_count; ++i) {
+            if (readable[i]) want.push_back(i);
+        }
+        if (got != want && mismatches++ == 0) {
+            YC_CHECK_MSG(false, std::string(where) + ": got " + std::to_string(got.size()) + " want " + std::to_string(want.size()));
+        }
+    };
+
+    for (int round = 0; round < 200; ++round) {
+        // 쥐고 있는 객체 일부를 넘긴다. 한 word 에 몰리거나 흩어지도록 구간 길이를 바꾼다.
+        const int start = static_cast<int>(rng() % object_count);
+        const int len = static_cast<int>(rng() % 300);
+        std::vector<payload_t*> batch;
+        for (int k = 0; k < len; ++k) {
+            const int i = (start + k * (round % 3 + 1)) % object_count;
+            if (!held[i]) continue;
+            readable[i] = true;
+            if (k % 2) batch.push_back(std::exchange(held[i], nullptr));
+            else mem.make_readable(held[i]);
+        }
+        mem.make_readable_n(batch);
+
+        std::vector<int> got;
+        for (auto* obj : mem.get_read_ranges()) got.push_back(static_cast<int>(obj->value));
+        expect(got, "get_read_ranges");
+        got.clear();
+        mem.for_each_readable([&](payload_t* obj) { got.push_back(static_cast<int>(obj->value)); });
+        expect(got, "for_each_readable");
+
+        // 읽은 것 중 일부만 돌려준다. 돌려준 slot 은 같은 객체로 다시 try_push 된다.
+        std::vector<payload_t*> done;
+        for (auto* obj : mem.get_read_ranges()) {
+            if (rng() % 2) continue;
+            readable[obj->value] = false;
+            if (rng() % 2) done.push_back(obj);
+            else {
+                payload_t* o = obj;
+                mem.read_end(o);
+            }
+        }
+        mem.read_end_n(done);
+        got.clear();
+        std::vector<payload_t*> out(object_count);
+        const size_t n = mem.read_batch(out);
+        for (size_t k = 0; k < n; ++k) got.push_back(static_cast<int>(out[k]->value));
+        expect(got, "read_batch");
+
+        // 돌려받은 slot 을 다시 쥔다. 새 chunk 를 만들지 않고 같은 객체가 돌아와야 한다.
+        for (int i = 0; i < object_count; ++i) {
+            if (held[i] || readable[i]) continue;
+            payload_t* obj = nullptr;
+            YC_CHECK(mem.try_push(0, obj));
+            held[obj->value] = obj;
+        }
+    }
+    YC_CHECK(mismatches == 0);
+    YC_CHECK(mem.capacity(0) == object_count);
+}
+
+// writer 는 두 값을 함께 바꾸고, reader 는 lock 안에서 두 값이 항상 같은지 본다.
+// YC_SRW_LOCK_ATOMIC_WAIT 를 정의해 build 하면 futex 대신 atomic wait / notify 경로를 확인할 수 있다.
+template <typename Lock>
+static void check_srw_lock_exclusion() {
+    constexpr int writers = 2;
+    constexpr int readers = 4;
+    constexpr int writes_per_writer = 5000;
+    Lock lock;
+    int64_t a = 0;
+    int64_t b = 0;
+    std::atomic<bool> writing_done {false};
+    std::atomic<bool> mismatch {false};
+
+    std::vector<std::thread> threads;
+    for (int w = 0; w < writers; ++w) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < writes_per_writer; ++i) {
+                w_srw_lock_guard<Lock> guard(lock);
+                ++a;
+                ++b;
+            }
+        });
+    }
+    for (int r = 0; r < readers; ++r) {
+        threads.emplace_back([&] {
+            while (!writing_done.load(std::memory_order_acquire)) {
+                r_srw_lock_guard<Lock> guard(lock);
+                if (a != b) mismatch.store(true);
+            }
+        });
+    }
+    for (int w = 0; w < writers; ++w) threads[w].join();
+    writing_done.store(true, std::memory_order_release);
+    for (size_t t = writers; t < threads.size(); ++t) threads[t].join();
+
+    YC_CHECK(!mismatch.load());
+    YC_CHECK(a == writers * writes_per_writer);
+    YC_CHECK(b == writers * writes_per_writer);
+}
+
+YC_TEST(srw_lock_exclusion) { check_srw_lock_exclusion<srw_lock>(); }
+YC_TEST(bravo_srw_lock_exclusion) { check_srw_lock_exclusion<bravo_srw_lock>(); }
+
+// writer 가 모든 word 를 같은 값으로 publish 하는 동안 reader 들이 읽은 사본은 word 가 모두 같고,
+// 버전은 뒤로 가지 않아야 한다.
+// seq_lock 의 fence 는 ThreadSanitizer 가 모델링하지 못해 -Wtsan 경고가 나오므로 이 test 는 payload 검사로 확인한다.
+YC_TEST(seq_lock_no_torn_reads) {
+    using payload_t = yc::test::unit::snapshot_payload_t;
+    constexpr int readers = 3;
+    constexpr int64_t publishes = 200000;
+    seq_lock<payload_t> snapshot(payload_t{});
+    std::atomic<bool> done {false};
+    std::atomic<int> torn {0};
+    std::atomic<int> went_back {0};
+    std::atomic<int64_t> reads {0};
+
+    std::vector<std::thread> threads;
+    for (int r = 0; r < readers; ++r) {
+        threads.emplace_back([&] {
+            int64_t last = 0;
+            int64_t n = 0;
+            while (!done.load(std::memory_order_acquire)) {
+                const payload_t p = snapshot.read();
+                for (const int64_t w : p.words) {
+                    if (w != p.words[0]) {
+                        torn.fetch_add(1);
+                        break;
+                    }
+                }
+                if (p.words[0] < last) went_back.fetch_add(1);
+                last = p.words[0];
+                ++n;
+            }
+            reads.fetch_add(n);
+        });
+    }
+
+    payload_t p {};
+    for (int64_t v = 1; v <= publishes; ++v) {
+        for (auto& w : p.words) w = v;
+        snapshot.publish(p);
+        if (v % 1024 == 0) std::this_thread::yield();
+    }
+    done.store(true, std::memory_order_release);
+    for (auto& t : threads) t.join();
+
+    YC_CHECK(torn.load() == 0);
+    YC_CHECK(went_back.load() == 0);
+    YC_CHECK(reads.load() > 0);
+    YC_CHECK(snapshot.version() == static_cast<uint64_t>(publishes) + 1);
+    YC_CHECK(snapshot.read().words[23] == publishes);
+}
+
+// producer 여러개와 consumer 여러개. 모든 값이 정확히 한번씩 꺼내져야 한다.
+// capacity 를 작게 잡아 가득 찬 경우와 빈 경우를 자주 지나가게 한다.
+YC_TEST(mpmc_queue_producers_consumers_stress) {
+    constexpr int producers = 4;
+    constexpr int consumers = 3;
+    constexpr int per_producer = 20000;
+    using yc::test::unit::queue_item;
+    yc_lf::mpmc_queue<uint64_t> queue(64);
+
+    std::vector<std::atomic<uint8_t>> seen(producers * per_producer);
+    std::array<std::atomic<int64_t>, producers> sum {};
+    std::atomic<int> popped {0};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&queue, p] {
+            std::array<uint64_t, 8> batch {};
+            int i = 0;
+            while (i < per_producer) {
+                // 단건 API 와 batch API 를 번갈아 쓴다.
+                if (i % 3 == 0) {
+                    if (queue.try_push(queue_item(p, i))) ++i;
+                    else std::this_thread::yield();
+                    continue;
+                }
+                const size_t want = std::min<size_t>(batch.size(), per_producer - i);
+                for (size_t k = 0; k < want; ++k) batch[k] = queue_item(p, i + static_cast<int>(k));
+                const size_t n = queue.try_push_n(std::span(batch.data(), want));
+                i += static_cast<int>(n);
+                if (n == 0) std::this_thread::yield();
+            }
+        });
+    }
+    for (int c = 0; c < consumers; ++c) {
+        threads.emplace_back([&, c] {
+            std::array<int64_t, producers> local_sum {};
+            std::array<uint64_t, 16> batch {};
+            auto take = [&](const uint64_t item) {
+                const int p = static_cast<int>(item >> 32);
+                const int i = static_cast<int>(item & 0xffffffff);
+                seen[p * per_producer + i].fetch_add(1, std::memory_order_relaxed);
+                local_sum[p] += i;
+            };
+            int round = 0;
+            while (popped.load(std::memory_order_relaxed) < producers * per_producer) {
+                int got = 0;
+                if ((round++ + c) % 2 == 0) {
+                    uint64_t item;
+                    if (queue.try_pop(item)) {
+                        take(item);
+                        got = 1;
+                    }
+                }
+                else {
+                    got = static_cast<int>(queue.try_pop_n(batch));
+                    for (int k = 0; k < got; ++k) take(batch[k]);
+                }
+                if (got) popped.fetch_add(got, std::memory_order_relaxed);
+                else std::this_thread::yield();
+            }
+            for (int p = 0; p < producers; ++p) sum[p].fetch_add(local_sum[p]);
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    YC_CHECK(popped.load() == producers * per_producer);
+    int wrong = 0;
+    for (const auto& s : seen) wrong += s.load() != 1;
+    YC_CHECK_MSG(wrong == 0, std::to_string(wrong) + " values lost or duplicated");
+    for (int p = 0; p < producers; ++p) {
+        YC_CHECK(sum[p].load() == static_cast<int64_t>(per_producer) * (per_producer - 1) / 2);
+    }
+    YC_CHECK(queue.size_approx() == 0);
+}
+
+// queue 에 남은 객체는 queue 가 사라질 때 소멸되어야 한다.
+YC_TEST(mpmc_queue_destroys_remaining_items) {
+    const auto item = std::make_shared<int>(1);
+    {
+        yc_lf::mpmc_queue<std::shared_ptr<int>> queue(4);
+        YC_CHECK(queue.try_push(item));
+        YC_CHECK(queue.try_push(item));
+        std::shared_ptr<int> out;
+        YC_CHECK(queue.try_pop(out));
+        out.reset();
+        YC_CHECK(item.use_count() == 2);
+    }
+    YC_CHECK(item.use_count() == 1);
+}
+
+// producer 하나와 consumer 하나. 넣은 순서대로 빠짐없이 꺼내져야 한다.
+YC_TEST(spsc_ring_order_stress) {
+    constexpr int count = 200000;
+    yc_lf::spsc_ring<int> ring(16);
+
+    std::thread producer([&ring] {
+        std::array<int, 8> batch {};
+        int i = 0;
+        while (i < count) {
+            if (i % 3 == 0) {
+                if (ring.try_push(i)) ++i;
+                else std::this_thread::yield();
+                continue;
+            }
+            const size_t want = std::min<size_t>(batch.size(), count - i);
+            for (size_t k = 0; k < want; ++k) batch[k] = i + static_cast<int>(k);
+            const size_t n = ring.try_push_n(std::span(batch.data(), want));
+            i += static_cast<int>(n);
+            if (n == 0) std::this_thread::yield();
+        }
+    });
+
+    // try_pop, try_pop_n, front / pop_front 를 돌아가며 쓴다.
+    int expected = 0;
+    int out_of_order = 0;
+    int round = 0;
+    std::array<int, 8> batch {};
+    while (expected < count) {
+        int got = 0;
+        switch (round++ % 3) {
+        case 0: {
+            int v;
+            if (ring.try_pop(v)) {
+                out_of_order += v != expected++;
+                got = 1;
+            }
+            break;
+        }
+        case 1:
+            got = static_cast<int>(ring.try_pop_n(batch));
+            for (int k = 0; k < got; ++k) out_of_order += batch[k] != expected++;
+            break;
+        default:
+            if (const int* v = ring.front()) {
+                out_of_order += *v != expected++;
+                ring.pop_front();
+                got = 1;
+            }
+            break;
+        }
+        if (got == 0) std::this_thread::yield();
+    }
+    producer.join();
+
+    YC_CHECK_MSG(out_of_order == 0, std::to_string(out_of_order) + " values out of order");
+    YC_CHECK(ring.empty());
+}
+
+// producer 여러개와 consumer 하나. producer 별로 넣은 순서대로 빠짐없이 꺼내져야 한다.
+YC_TEST(mpsc_intrusive_queue_stress) {
+    using node_t = yc::test::unit::mpsc_node_t;
+    constexpr int producers = 4;
+    constexpr int per_producer = 20000;
+
+    // 마지막 node 를 꺼낼 때는 stub 을 다시 넣어야 한다. 하나만 넣고 꺼내면 그 경로를 지난다.
+    {
+        yc_lf::mpsc_intrusive_queue<node_t> queue;
+        node_t a {}, b {};
+        YC_CHECK(queue.pop() == nullptr);
+        queue.push(&a);
+        YC_CHECK(queue.pop() == &a);
+        YC_CHECK(queue.pop() == nullptr);
+        queue.push(&b);
+        YC_CHECK(queue.pop() == &b);
+        queue.push(&a);
+        YC_CHECK(queue.pop() == &a);
+        YC_CHECK(queue.pop() == nullptr);
+    }
+
+    yc_lf::mpsc_intrusive_queue<node_t> queue;
+    std::vector<node_t> nodes(producers * per_producer);
+    for (int p = 0; p < producers; ++p) {
+        for (int i = 0; i < per_producer; ++i) {
+            nodes[p * per_producer + i].producer = p;
+            nodes[p * per_producer + i].value = i;
+        }
+    }
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&queue, &nodes, p] {
+            node_t* base = &nodes[p * per_producer];
+            std::array<node_t*, 8> batch {};
+            int i = 0;
+            while (i < per_producer) {
+                if (i % 3 == 0) {
+                    queue.push(base + i++);
+                    continue;
+                }
+                const size_t n = std::min<size_t>(batch.size(), per_producer - i);
+                for (size_t k = 0; k < n; ++k) batch[k] = base + i + k;
+                queue.push_n(std::span(batch.data(), n));
+                i += static_cast<int>(n);
+                // consumer 가 따라잡아 queue 가 자주 비게 한다.
+                std::this_thread::yield();
+            }
+        });
+    }
+
+    std::array<int, producers> next {};
+    std::array<int64_t, producers> sum {};
+    int out_of_order = 0;
+    int total = 0;
+    std::array<node_t*, 16> batch {};
+    auto take = [&](const node_t* node) {
+        out_of_order += node->value != next[node->producer]++;
+        sum[node->producer] += node->value;
+    };
+    while (total < producers * per_producer) {
+        int got = 0;
+        if (node_t* node = queue.pop()) {
+            take(node);
+            got = 1;
+        }
+        const size_t n = queue.pop_n(batch);
+        for (size_t k = 0; k < n; ++k) take(batch[k]);
+        got += static_cast<int>(n);
+        total += got;
+        if (got == 0) std::this_thread::yield();
+    }
+    for (auto& t : threads) t.join();
+
+    YC_CHECK_MSG(out_of_order == 0, std::to_string(out_of_order) + " nodes out of order");
+    for (int p = 0; p < producers; ++p) {
+        YC_CHECK(next[p] == per_producer);
+        YC_CHECK(sum[p] == static_cast<int64_t>(per_producer) * (per_producer - 1) / 2);
+    }
+    YC_CHECK(queue.pop() == nullptr);
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include "yc_test.hpp"
+
+/**
+ * \brief global operator new / delete 를 바꿔 할당 횟수를 셉니다.
+ * benchmark 는 iteration 당 할당 수를 allocs_per_iter 로 보고하고, test 는 yc::test::allocation_count() 로 읽습니다.
+ * [*** 중요! ***] 프로그램에서 한 translation unit(main 이 있는 cpp) 에서만 include 해야 합니다.
+ */
+namespace yc::test::detail
+{
+    inline std::atomic<uint64_t> global_new_count {0};
+
+    inline uint64_t read_global_new_count() {
+        return global_new_count.load(std::memory_order_relaxed);
+    }
+
+    inline const bool alloc_counter_installed = (allocation_counter() = &read_global_new_count, true);
+
+    inline void* counted_malloc(const std::size_t size) {
+        global_new_count.fetch_add(1, std::memory_order_relaxed);
+        if (void* p = std::malloc(size ? size : 1)) return p;
+        throw std::bad_alloc();
+    }
+
+    inline void* counted_aligned_malloc(const std::size_t size, const std::align_val_t align) {
+        global_new_count.fetch_add(1, std::memory_order_relaxed);
+        const auto a = static_cast<std::size_t>(align);
+        // aligned_alloc 은 size 가 alignment 의 배수여야 한다.
+        if (void* p = std::aligned_alloc(a, (size + a - 1) / a * a)) return p;
+        throw std::bad_alloc();
+    }
+}
+
+void* operator new(const std::size_t size) { return yc::test::detail::counted_malloc(size); }
+void* operator new[](const std::size_t size) { return yc::test::detail::counted_malloc(size); }
+void* operator new(const std::size_t size, const std::align_val_t align) { return yc::test::detail::counted_aligned_malloc(size, align); }
+void* operator new[](const std::size_t size, const std::align_val_t align) { return yc::test::detail::counted_aligned_malloc(size, align); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
@@ -1,14 +1,561 @@
 #pragma once
 #include <iostream>
+#include <fstream>
 #include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// 간단한 구간 측정용. 새 코드는 YC_BENCHMARK 를 사용하세요.
 #define CPU_Time(filed, cnt, name){\
-std::chrono::system_clock::time_point s = std::chrono::system_clock::now();\
+const auto s = std::chrono::steady_clock::now();\
 for(int i__ = 0; i__ < cnt; ++i__){\
-filed\
+filed \
+yc::test::clobber();\
 }\
-std::cout << "[" << name <<"] elapsed time: " << std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now() - s).count() << "mc\n";}\
+std::cout << "[" << name <<"] elapsed time: " << std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - s).count() << "mc\n";}\
 
 namespace yc::test {
-    
-    
-}
\ No newline at end of file
+
+    /////// optimizer barrier /////
+
+    /**
+     * \brief 컴파일러가 value 를 계산하지 않고 없애버리지 못하게 합니다.
+     */
+    template <typename T>
+    inline void do_not_optimize(T const& value) {
+#if defined(_MSC_VER)
+        const volatile char* p = reinterpret_cast<const volatile char*>(&value);
+        (void)*p;
+        _ReadWriteBarrier();
+#else
+        asm volatile("" : : "r,m"(value) : "memory");
+#endif
+    }
+
+    template <typename T>
+    inline void do_not_optimize(T& value) {
+#if defined(_MSC_VER)
+        volatile char* p = reinterpret_cast<volatile char*>(&value);
+        (void)*p;
+        _ReadWriteBarrier();
+#else
+        asm volatile("" : "+m,r"(value) : : "memory");
+#endif
+    }
+
+    /**
+     * \brief 지금까지의 메모리 쓰기가 실제로 일어난 것처럼 컴파일러가 다루게 합니다.
+     */
+    inline void clobber() {
+#if defined(_MSC_VER)
+        _ReadWriteBarrier();
+#else
+        asm volatile("" : : : "memory");
+#endif
+    }
+
+    /////// clock /////
+
+    enum class clock_kind {
+        steady,
+        tsc,
+    };
+
+    inline uint64_t steady_now_ns() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    inline uint64_t read_tsc() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return steady_now_ns();
+#endif
+    }
+
+    /**
+     * \brief steady_clock 으로 잰 tsc 1 tick 의 ns. 처음 호출할 때 20ms 정도 걸려 한번 계산합니다.
+     */
+    inline double tsc_ns_per_tick() {
+        static const double ns_per_tick = [] {
+            const uint64_t s_ns = steady_now_ns();
+            const uint64_t s_tsc = read_tsc();
+            while (steady_now_ns() - s_ns < 20'000'000) { }
+            const uint64_t e_tsc = read_tsc();
+            const uint64_t e_ns = steady_now_ns();
+            return static_cast<double>(e_ns - s_ns) / static_cast<double>(e_tsc - s_tsc);
+        }();
+        return ns_per_tick;
+    }
+
+    inline uint64_t now_ticks(const clock_kind clock) {
+        return clock == clock_kind::tsc ? read_tsc() : steady_now_ns();
+    }
+
+    inline double ticks_to_ns(const clock_kind clock, const uint64_t ticks) {
+        return clock == clock_kind::tsc ? static_cast<double>(ticks) * tsc_ns_per_tick() : static_cast<double>(ticks);
+    }
+
+    /////// allocation count /////
+
+    /**
+     * \brief 지금까지의 global operator new 호출 수를 돌려주는 함수. yc_alloc_counter.hpp 를 include 하면 설정됩니다.
+     */
+    inline uint64_t (*&allocation_counter())() {
+        static uint64_t (*counter)() = nullptr;
+        return counter;
+    }
+
+    /**
+     * \return 지금까지의 global operator new 호출 수. counter 가 없으면 0.
+     */
+    inline uint64_t allocation_count() {
+        return allocation_counter() ? allocation_counter()() : 0;
+    }
+
+    /////// benchmark /////
+
+    /**
+     * \brief benchmark 함수에 넘겨지는 상태. for (auto _ : state) { ... } 로 측정할 구간을 감쌉니다.
+     */
+    class bench_state_t {
+        size_t iterations_;
+        clock_kind clock_;
+        uint64_t start_ = 0;
+        uint64_t elapsed_ = 0;
+        uint64_t paused_at_ = 0;
+        size_t items_ = 0;
+        size_t bytes_ = 0;
+        // 측정 구간 안에서 일어난 global operator new 호출 수. 다른 thread 의 할당도 포함된다.
+        uint64_t allocs_ = 0;
+        uint64_t alloc_start_ = 0;
+        uint64_t alloc_paused_at_ = 0;
+        std::vector<std::pair<std::string, double>> counters_;
+
+    public:
+        // for (auto _ : state) 에서 _ 가 unused variable 경고를 내지 않도록 destructor 를 둔다.
+        struct iteration_t {
+            ~iteration_t() { }
+        };
+
+        struct iterator {
+            bench_state_t* state;
+            size_t remaining;
+
+            iteration_t operator*() const { return {}; }
+            iterator& operator++() {
+                --remaining;
+                return *this;
+            }
+            bool operator!=(const iterator&) {
+                if (remaining != 0) return true;
+                state->elapsed_ += now_ticks(state->clock_) - state->start_;
+                state->allocs_ += allocation_count() - state->alloc_start_;
+                return false;
+            }
+        };
+
+        bench_state_t(const size_t iterations, const clock_kind clock) : iterations_(iterations), clock_(clock) { }
+
+        iterator begin() {
+            alloc_start_ = allocation_count();
+            start_ = now_ticks(clock_);
+            return iterator{ this, iterations_ };
+        }
+        iterator end() { return iterator{ this, 0 }; }
+
+        /**
+         * \brief 측정에서 빼고 싶은 준비 작업 전후에 호출합니다.
+         */
+        void pause_timing() {
+            paused_at_ = now_ticks(clock_);
+            alloc_paused_at_ = allocation_count();
+        }
+        void resume_timing() {
+            alloc_start_ += allocation_count() - alloc_paused_at_;
+            start_ += now_ticks(clock_) - paused_at_;
+        }
+
+        /**
+         * \brief iteration 한번에 처리한 item / byte 수. items/s, bytes/s 로 보고됩니다.
+         */
+        void set_items_per_iteration(const size_t n) { items_ = n; }
+        void set_bytes_per_iteration(const size_t n) { bytes_ = n; }
+
+        /**
+         * \brief 시간 외에 함께 보고할 값. (RSS, 할당 횟수 등) 같은 이름으로 다시 부르면 덮어씁니다.
+         */
+        void set_counter(const std::string& name, const double value) {
+            for (auto& [n, v] : counters_) {
+                if (n == name) {
+                    v = value;
+                    return;
+                }
+            }
+            counters_.emplace_back(name, value);
+        }
+
+        size_t iterations() const { return iterations_; }
+        size_t items_per_iteration() const { return items_; }
+        size_t bytes_per_iteration() const { return bytes_; }
+        double elapsed_ns() const { return ticks_to_ns(clock_, elapsed_); }
+        uint64_t allocations() const { return allocs_; }
+        const std::vector<std::pair<std::string, double>>& counters() const { return counters_; }
+    };
+
+    using bench_func_t = std::function<void(bench_state_t&)>;
+
+    struct bench_entry_t {
+        std::string name;
+        bench_func_t func;
+        // 메모리 / 시간이 많이 드는 benchmark. --filter 가 이름과 정확히 같을 때만 실행합니다.
+        bool manual = false;
+    };
+
+    inline std::vector<bench_entry_t>& registry() {
+        static std::vector<bench_entry_t> entries;
+        return entries;
+    }
+
+    inline bool register_benchmark(std::string name, bench_func_t func, const bool manual = false) {
+        registry().push_back(bench_entry_t{ std::move(name), std::move(func), manual });
+        return true;
+    }
+
+    struct bench_options_t {
+        // 이 문자열을 이름에 포함하는 benchmark 만 실행합니다. 비어있으면 전부.
+        std::string filter;
+        clock_kind clock = clock_kind::steady;
+        // sample 하나가 최소 이만큼 걸리도록 iteration 수를 맞춥니다.
+        double min_sample_ms = 10.0;
+        double warmup_ms = 50.0;
+        int samples = 20;
+        std::string json_path;
+        std::string csv_path;
+        bool quiet = false;
+    };
+
+    struct bench_result_t {
+        std::string name;
+        size_t iterations = 0;
+        int samples = 0;
+        // iteration 한번의 ns
+        double mean = 0;
+        double stddev = 0;
+        double min = 0;
+        double p50 = 0;
+        double p90 = 0;
+        double p99 = 0;
+        double max = 0;
+        double items_per_sec = 0;
+        double bytes_per_sec = 0;
+        // 마지막 sample 에서 set_counter 로 기록한 값
+        std::vector<std::pair<std::string, double>> counters;
+    };
+
+    inline double percentile(const std::vector<double>& sorted, const double p) {
+        if (sorted.empty()) return 0;
+        const double pos = p * static_cast<double>(sorted.size() - 1);
+        const size_t lo = static_cast<size_t>(pos);
+        const size_t hi = std::min(lo + 1, sorted.size() - 1);
+        return sorted[lo] + (sorted[hi] - sorted[lo]) * (pos - static_cast<double>(lo));
+    }
+
+    /**
+     * \brief benchmark 하나를 warmup, iteration 수 보정, sample 수집 순서로 실행합니다.
+     */
+    inline bench_result_t run_benchmark(const bench_entry_t& entry, const bench_options_t& options) {
+        auto run_once = [&](const size_t iterations, bench_state_t* out = nullptr) {
+            bench_state_t state(iterations, options.clock);
+            entry.func(state);
+            if (allocation_counter()) {
+                state.set_counter("allocs_per_iter", static_cast<double>(state.allocations()) / static_cast<double>(iterations));
+            }
+            if (out) *out = state;
+            return state.elapsed_ns();
+        };
+
+        // iteration 수를 늘려가며 sample 하나가 min_sample_ms 이상이 되도록 보정한다.
+        const double min_sample_ns = options.min_sample_ms * 1e6;
+        size_t iterations = 1;
+        while (true) {
+            const double ns = run_once(iterations);
+            if (ns >= min_sample_ns || iterations >= (size_t{1} << 40)) break;
+            const double scale = ns > 0 ? min_sample_ns * 1.2 / ns : 10.0;
+            iterations = static_cast<size_t>(static_cast<double>(iterations) * std::clamp(scale, 1.5, 10.0)) + 1;
+        }
+
+        const uint64_t warmup_end = steady_now_ns() + static_cast<uint64_t>(options.warmup_ms * 1e6);
+        while (steady_now_ns() < warmup_end) run_once(iterations);
+
+        std::vector<double> per_iter;
+        per_iter.reserve(options.samples);
+        bench_state_t last(iterations, options.clock);
+        for (int i = 0; i < options.samples; ++i) {
+            per_iter.push_back(run_once(iterations, &last) / static_cast<double>(iterations));
+        }
+        std::sort(per_iter.begin(), per_iter.end());
+
+        bench_result_t r;
+        r.name = entry.name;
+        r.iterations = iterations;
+        r.samples = options.samples;
+        for (const double v : per_iter) r.mean += v;
+        r.mean /= static_cast<double>(per_iter.size());
+        for (const double v : per_iter) r.stddev += (v - r.mean) * (v - r.mean);
+        r.stddev = std::sqrt(r.stddev / static_cast<double>(per_iter.size()));
+        r.min = per_iter.front();
+        r.max = per_iter.back();
+        r.p50 = percentile(per_iter, 0.5);
+        r.p90 = percentile(per_iter, 0.9);
+        r.p99 = percentile(per_iter, 0.99);
+        if (r.p50 > 0) {
+            r.items_per_sec = static_cast<double>(last.items_per_iteration()) * 1e9 / r.p50;
+            r.bytes_per_sec = static_cast<double>(last.bytes_per_iteration()) * 1e9 / r.p50;
+        }
+        r.counters = last.counters();
+        return r;
+    }
+
+    inline void print_result(std::ostream& os, const bench_result_t& r) {
+        os << "[" << r.name << "] p50 " << r.p50 << " ns  p90 " << r.p90 << " ns  p99 " << r.p99
+           << " ns  min " << r.min << " ns  (" << r.iterations << " iters x " << r.samples << ")";
+        if (r.items_per_sec > 0) os << "  " << r.items_per_sec << " items/s";
+        if (r.bytes_per_sec > 0) os << "  " << r.bytes_per_sec << " B/s";
+        for (const auto& [name, value] : r.counters) os << "  " << name << " " << value;
+        os << "\n";
+    }
+
+    inline void write_json(std::ostream& os, const std::vector<bench_result_t>& results) {
+        os << "{\n  \"benchmarks\": [\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const auto& r = results[i];
+            os << "    {\"name\": \"" << r.name << "\", \"iterations\": " << r.iterations
+               << ", \"samples\": " << r.samples << ", \"mean_ns\": " << r.mean << ", \"stddev_ns\": " << r.stddev
+               << ", \"min_ns\": " << r.min << ", \"p50_ns\": " << r.p50 << ", \"p90_ns\": " << r.p90
+               << ", \"p99_ns\": " << r.p99 << ", \"max_ns\": " << r.max
+               << ", \"items_per_sec\": " << r.items_per_sec << ", \"bytes_per_sec\": " << r.bytes_per_sec;
+            for (const auto& [name, value] : r.counters) os << ", \"" << name << "\": " << value;
+            os << "}"
+               << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        os << "  ]\n}\n";
+    }
+
+    inline void write_csv(std::ostream& os, const std::vector<bench_result_t>& results) {
+        os << "name,iterations,samples,mean_ns,stddev_ns,min_ns,p50_ns,p90_ns,p99_ns,max_ns,items_per_sec,bytes_per_sec\n";
+        for (const auto& r : results) {
+            os << r.name << "," << r.iterations << "," << r.samples << "," << r.mean << "," << r.stddev << ","
+               << r.min << "," << r.p50 << "," << r.p90 << "," << r.p99 << "," << r.max << ","
+               << r.items_per_sec << "," << r.bytes_per_sec << "\n";
+        }
+    }
+
+    /**
+     * \brief 등록된 benchmark 를 실행하고 options 에 따라 json / csv 로 저장합니다.
+     */
+    inline std::vector<bench_result_t> run_all(const bench_options_t& options) {
+        std::vector<bench_result_t> results;
+        for (const auto& entry : registry()) {
+            if (!options.filter.empty() && entry.name.find(options.filter) == std::string::npos) continue;
+            if (entry.manual && options.filter != entry.name) continue;
+            results.push_back(run_benchmark(entry, options));
+            if (!options.quiet) print_result(std::cout, results.back());
+        }
+        if (!options.json_path.empty()) {
+            std::ofstream f(options.json_path);
+            write_json(f, results);
+        }
+        if (!options.csv_path.empty()) {
+            std::ofstream f(options.csv_path);
+            write_csv(f, results);
+        }
+        return results;
+    }
+
+    /**
+     * \brief write_csv 로 저장한 결과를 baseline 으로 읽습니다.
+     * \return 이름 -> p50_ns. 파일이 없으면 비어있습니다.
+     */
+    inline std::map<std::string, double> load_baseline(const std::string& path) {
+        std::map<std::string, double> baseline;
+        std::ifstream f(path);
+        std::string line;
+        if (!std::getline(f, line)) return baseline;
+        while (std::getline(f, line)) {
+            std::stringstream ss(line);
+            std::string cols[7];
+            for (auto& c : cols) std::getline(ss, c, ',');
+            if (cols[0].empty()) continue;
+            baseline[cols[0]] = std::atof(cols[6].c_str());
+        }
+        return baseline;
+    }
+
+    /**
+     * \brief p50 이 baseline 보다 threshold 비율 이상 느려진 benchmark 를 출력합니다.
+     * \param threshold 0.1 이면 10% 이상 느려졌을 때 regression 으로 봅니다.
+     * \return regression 으로 판정된 benchmark 수
+     */
+    inline int compare_to_baseline(std::ostream& os, const std::vector<bench_result_t>& results,
+                                   const std::map<std::string, double>& baseline, const double threshold) {
+        int regressions = 0;
+        for (const auto& r : results) {
+            const auto it = baseline.find(r.name);
+            if (it == baseline.end() || it->second <= 0) {
+                os << "[" << r.name << "] no baseline\n";
+                continue;
+            }
+            const double change = r.p50 / it->second - 1.0;
+            const bool regressed = change > threshold;
+            if (regressed) ++regressions;
+            os << (regressed ? "[REGRESSION] " : "[ok] ") << r.name << " " << it->second << " ns -> " << r.p50
+               << " ns (" << (change >= 0 ? "+" : "") << change * 100.0 << "%)\n";
+        }
+        return regressions;
+    }
+
+    /**
+     * \brief --filter= --json= --csv= --samples= --min-time-ms= --warmup-ms= --clock=tsc --quiet 를 읽습니다.
+     * 모르는 인자는 unknown 에 담깁니다.
+     */
+    inline bench_options_t parse_options(const int argc, char* argv[], std::vector<std::string>* unknown = nullptr) {
+        bench_options_t o;
+        for (int i = 1; i < argc; ++i) {
+            const std::string_view arg = argv[i];
+            auto value_of = [&](const std::string_view key) -> const char* {
+                return arg.starts_with(key) ? argv[i] + key.size() : nullptr;
+            };
+            if (auto v = value_of("--filter=")) o.filter = v;
+            else if (auto v = value_of("--json=")) o.json_path = v;
+            else if (auto v = value_of("--csv=")) o.csv_path = v;
+            else if (auto v = value_of("--samples=")) o.samples = std::max(1, std::atoi(v));
+            else if (auto v = value_of("--min-time-ms=")) o.min_sample_ms = std::atof(v);
+            else if (auto v = value_of("--warmup-ms=")) o.warmup_ms = std::atof(v);
+            else if (arg == "--clock=tsc") o.clock = clock_kind::tsc;
+            else if (arg == "--clock=steady") o.clock = clock_kind::steady;
+            else if (arg == "--quiet") o.quiet = true;
+            else if (unknown) unknown->emplace_back(arg);
+        }
+        return o;
+    }
+
+    /////// unit test /////
+
+    struct test_entry_t {
+        std::string name;
+        std::function<void()> func;
+    };
+
+    inline std::vector<test_entry_t>& test_registry() {
+        static std::vector<test_entry_t> entries;
+        return entries;
+    }
+
+    inline bool register_test(std::string name, std::function<void()> func) {
+        test_registry().push_back(test_entry_t{ std::move(name), std::move(func) });
+        return true;
+    }
+
+    // 실행 중인 test 에서 실패한 YC_CHECK 수. 여러 thread 에서 YC_CHECK 를 불러도 된다.
+    inline std::atomic<int>& check_failure_count() {
+        static std::atomic<int> count{0};
+        return count;
+    }
+
+    inline void report_check_failure(const char* file, const int line, const char* expr, const std::string& msg = {}) {
+        static std::mutex output_mutex;
+        check_failure_count().fetch_add(1, std::memory_order_relaxed);
+        std::lock_guard lock(output_mutex);
+        std::cerr << "    " << file << ":" << line << ": YC_CHECK(" << expr << ") failed";
+        if (!msg.empty()) std::cerr << " - " << msg;
+        std::cerr << "\n";
+    }
+
+    /**
+     * \brief 등록된 test 를 순서대로 실행합니다. YC_CHECK 가 하나라도 실패하거나 예외가 나오면 그 test 는 실패입니다.
+     * \param filter 이 문자열을 이름에 포함하는 test 만 실행합니다. 비어있으면 전부.
+     * \return 실패한 test 수
+     */
+    inline int run_tests(const std::string& filter, std::ostream& os = std::cout) {
+        int failed = 0;
+        int ran = 0;
+        for (const auto& entry : test_registry()) {
+            if (!filter.empty() && entry.name.find(filter) == std::string::npos) continue;
+            ++ran;
+            check_failure_count().store(0);
+            const uint64_t start = steady_now_ns();
+            bool ok = true;
+            try {
+                entry.func();
+            } catch (const std::exception& e) {
+                std::cerr << "    exception: " << e.what() << "\n";
+                ok = false;
+            } catch (...) {
+                std::cerr << "    unknown exception\n";
+                ok = false;
+            }
+            if (check_failure_count().load() != 0) ok = false;
+            if (!ok) ++failed;
+            os << (ok ? "[ok] " : "[FAIL] ") << entry.name << " (" << (steady_now_ns() - start) / 1'000'000 << " ms)\n";
+        }
+        os << ran - failed << " / " << ran << " tests passed\n";
+        return failed;
+    }
+}
+
+/**
+ * \brief benchmark 를 등록합니다.
+ * YC_BENCHMARK(rudp_push_packet) {
+ *     for (auto _ : state) { ... }
+ * }
+ */
+#define YC_BENCHMARK(name) \
+static void yc_bench_##name(yc::test::bench_state_t& state); \
+static const bool yc_bench_registered_##name = yc::test::register_benchmark(#name, yc_bench_##name); \
+static void yc_bench_##name(yc::test::bench_state_t& state)
+
+/**
+ * \brief --filter 가 이름과 정확히 같을 때만 실행되는 benchmark 를 등록합니다. 사용법은 YC_BENCHMARK 와 같습니다.
+ */
+#define YC_BENCHMARK_MANUAL(name) \
+static void yc_bench_##name(yc::test::bench_state_t& state); \
+static const bool yc_bench_registered_##name = yc::test::register_benchmark(#name, yc_bench_##name, true); \
+static void yc_bench_##name(yc::test::bench_state_t& state)
+
+/**
+ * \brief test 를 등록합니다. 실패는 YC_CHECK 로 알립니다.
+ * YC_TEST(thread_pool_lane_order) {
+ *     YC_CHECK(order == expected);
+ * }
+ */
+#define YC_TEST(name) \
+static void yc_test_##name(); \
+static const bool yc_test_registered_##name = yc::test::register_test(#name, yc_test_##name); \
+static void yc_test_##name()
+
+/**
+ * \brief cond 가 false 면 현재 test 를 실패로 기록하고 계속 진행합니다. 아무 thread 에서나 불러도 됩니다.
+ */
+#define YC_CHECK(cond) \
+do { if (!(cond)) yc::test::report_check_failure(__FILE__, __LINE__, #cond); } while (0)
+
+#define YC_CHECK_MSG(cond, msg) \
+do { if (!(cond)) yc::test::report_check_failure(__FILE__, __LINE__, #cond, (msg)); } while (0)
@@ -0,0 +1,319 @@
+#pragma once
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <span>
+#include <utility>
+
+/**
+ * \brief thread 사이에 객체를 넘기기 위한 lock free queue 모음.
+ * mpmc_queue            : 여러 thread <-> 여러 thread. (Vyukov bounded queue)
+ * spsc_ring             : thread 하나 <-> thread 하나. 상대의 index 를 cache 해서 공유 cache line 접근을 줄인다.
+ * mpsc_intrusive_queue  : 여러 thread -> thread 하나. node 안의 next 로 연결하므로 할당이 없다.
+ */
+namespace yc_lf
+{
+    constexpr size_t cache_line_size = 64;
+
+    inline size_t round_up_pow2(const size_t n) {
+        return n < 2 ? 2 : std::bit_ceil(n);
+    }
+
+    /**
+     * \brief 크기가 정해진 lock free multi producer / multi consumer queue.
+     * \tparam T 담을 객체. move 가능해야 합니다.
+     */
+    template <typename T>
+    class mpmc_queue {
+        struct cell_t {
+            std::atomic<size_t> seq;
+            alignas(T) unsigned char storage[sizeof(T)];
+
+            T* ptr() { return std::launder(reinterpret_cast<T*>(storage)); }
+        };
+
+        const size_t mask_;
+        std::unique_ptr<cell_t[]> cells_;
+        alignas(cache_line_size) std::atomic<size_t> enqueue_pos_ {0};
+        alignas(cache_line_size) std::atomic<size_t> dequeue_pos_ {0};
+
+    public:
+        /**
+         * \param capacity 최대 객체 수. 2의 거듭제곱으로 올림합니다.
+         */
+        explicit mpmc_queue(const size_t capacity)
+            : mask_(round_up_pow2(capacity) - 1), cells_(new cell_t[mask_ + 1]) {
+            for (size_t i = 0; i <= mask_; ++i) cells_[i].seq.store(i, std::memory_order_relaxed);
+        }
+        ~mpmc_queue() {
+            const size_t end = enqueue_pos_.load(std::memory_order_relaxed);
+            for (size_t pos = dequeue_pos_.load(std::memory_order_relaxed); pos != end; ++pos) {
+                cells_[pos & mask_].ptr()->~T();
+            }
+        }
+        mpmc_queue(const mpmc_queue&) = delete;
+        mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+        template <typename... Args>
+        bool try_emplace(Args&&... args) {
+            size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+            cell_t* cell;
+            while (true) {
+                cell = &cells_[pos & mask_];
+                const size_t seq = cell->seq.load(std::memory_order_acquire);
+                const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+                if (diff == 0) {
+                    if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+                }
+                else if (diff < 0) return false; // full
+                else pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+            new (cell->storage) T(std::forward<Args>(args)...);
+            cell->seq.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool try_push(const T& value) { return try_emplace(value); }
+        bool try_push(T&& value) { return try_emplace(std::move(value)); }
+
+        bool try_pop(T& out) {
+            size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+            cell_t* cell;
+            while (true) {
+                cell = &cells_[pos & mask_];
+                const size_t seq = cell->seq.load(std::memory_order_acquire);
+                const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+                if (diff == 0) {
+                    if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+                }
+                else if (diff < 0) return false; // empty
+                else pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+            out = std::move(*cell->ptr());
+            cell->ptr()->~T();
+            cell->seq.store(pos + mask_ + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * \return 넣은 객체 수. queue 가 가득 차면 values.size() 보다 작을 수 있습니다.
+         */
+        size_t try_push_n(std::span<T> values) {
+            size_t n = 0;
+            while (n < values.size() && try_push(std::move(values[n]))) ++n;
+            return n;
+        }
+
+        /**
+         * \return 꺼낸 객체 수
+         */
+        size_t try_pop_n(std::span<T> out) {
+            size_t n = 0;
+            while (n < out.size() && try_pop(out[n])) ++n;
+            return n;
+        }
+
+        size_t capacity() const { return mask_ + 1; }
+
+        // 다른 thread 가 동시에 사용 중이면 근사값입니다.
+        size_t size_approx() const {
+            const size_t e = enqueue_pos_.load(std::memory_order_relaxed);
+            const size_t d = dequeue_pos_.load(std::memory_order_relaxed);
+            return e > d ? e - d : 0;
+        }
+    };
+
+    /**
+     * \brief 크기가 정해진 lock free single producer / single consumer ring buffer.
+     * producer 와 consumer 는 상대 index 의 사본을 들고 있다가 ring 이 가득 찼거나 비었다고 보일 때만 다시 읽습니다.
+     * [*** 중요! ***] push 하는 thread 와 pop 하는 thread 는 각각 한개여야 합니다.
+     */
+    template <typename T>
+    class spsc_ring {
+        const size_t mask_;
+        std::unique_ptr<T[]> buffer_;
+
+        alignas(cache_line_size) std::atomic<size_t> head_ {0}; // consumer 가 씀
+        size_t cached_tail_ = 0;
+
+        alignas(cache_line_size) std::atomic<size_t> tail_ {0}; // producer 가 씀
+        size_t cached_head_ = 0;
+
+    public:
+        /**
+         * \param capacity 최대 객체 수. 2의 거듭제곱으로 올림합니다.
+         */
+        explicit spsc_ring(const size_t capacity)
+            : mask_(round_up_pow2(capacity) - 1), buffer_(new T[mask_ + 1]) { }
+        spsc_ring(const spsc_ring&) = delete;
+        spsc_ring& operator=(const spsc_ring&) = delete;
+
+        template <typename U>
+        bool try_push(U&& value) {
+            const size_t tail = tail_.load(std::memory_order_relaxed);
+            if (tail - cached_head_ > mask_) {
+                cached_head_ = head_.load(std::memory_order_acquire);
+                if (tail - cached_head_ > mask_) return false;
+            }
+            buffer_[tail & mask_] = std::forward<U>(value);
+            tail_.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool try_pop(T& out) {
+            const size_t head = head_.load(std::memory_order_relaxed);
+            if (head == cached_tail_) {
+                cached_tail_ = tail_.load(std::memory_order_acquire);
+                if (head == cached_tail_) return false;
+            }
+            out = std::move(buffer_[head & mask_]);
+            head_.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * \brief 빈 자리만큼 넣고 tail 을 한번만 갱신합니다.
+         * \return 넣은 객체 수
+         */
+        size_t try_push_n(std::span<T> values) {
+            const size_t tail = tail_.load(std::memory_order_relaxed);
+            size_t free = mask_ + 1 - (tail - cached_head_);
+            if (free < values.size()) {
+                cached_head_ = head_.load(std::memory_order_acquire);
+                free = mask_ + 1 - (tail - cached_head_);
+            }
+            const size_t n = free < values.size() ? free : values.size();
+            for (size_t i = 0; i < n; ++i) buffer_[(tail + i) & mask_] = std::move(values[i]);
+            if (n) tail_.store(tail + n, std::memory_order_release);
+            return n;
+        }
+
+        /**
+         * \brief 들어있는 만큼 꺼내고 head 를 한번만 갱신합니다.
+         * \return 꺼낸 객체 수
+         */
+        size_t try_pop_n(std::span<T> out) {
+            const size_t head = head_.load(std::memory_order_relaxed);
+            size_t ready = cached_tail_ - head;
+            if (ready < out.size()) {
+                cached_tail_ = tail_.load(std::memory_order_acquire);
+                ready = cached_tail_ - head;
+            }
+            const size_t n = ready < out.size() ? ready : out.size();
+            for (size_t i = 0; i < n; ++i) out[i] = std::move(buffer_[(head + i) & mask_]);
+            if (n) head_.store(head + n, std::memory_order_release);
+            return n;
+        }
+
+        /**
+         * \brief consumer thread 에서 다음에 꺼낼 객체를 꺼내지 않고 봅니다. 비어있으면 nullptr.
+         */
+        T* front() {
+            const size_t head = head_.load(std::memory_order_relaxed);
+            if (head == cached_tail_) {
+                cached_tail_ = tail_.load(std::memory_order_acquire);
+                if (head == cached_tail_) return nullptr;
+            }
+            return &buffer_[head & mask_];
+        }
+
+        /**
+         * \brief front() 로 본 객체를 버립니다.
+         */
+        void pop_front() {
+            head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        size_t capacity() const { return mask_ + 1; }
+
+        bool empty() const {
+            return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+        }
+    };
+
+    template <typename Node>
+    concept intrusive_node = requires(Node n) {
+        { n.next } -> std::same_as<std::atomic<Node*>&>;
+    };
+
+    /**
+     * \brief node 안의 next 를 사용하는 lock free multi producer / single consumer queue. (Vyukov)
+     * push 는 wait free 이고 할당이 없습니다. node 는 pop 될 때까지 살아 있어야 합니다.
+     * [*** 중요! ***] pop 하는 thread 는 한개여야 합니다.
+     * \tparam Node std::atomic<Node*> next 를 가진 type
+     */
+    template <intrusive_node Node>
+    class mpsc_intrusive_queue {
+        alignas(cache_line_size) std::atomic<Node*> tail_;
+        alignas(cache_line_size) Node* head_;
+        Node stub_ {};
+
+    public:
+        mpsc_intrusive_queue() : tail_(&stub_), head_(&stub_) {
+            stub_.next.store(nullptr, std::memory_order_relaxed);
+        }
+        mpsc_intrusive_queue(const mpsc_intrusive_queue&) = delete;
+        mpsc_intrusive_queue& operator=(const mpsc_intrusive_queue&) = delete;
+
+        void push(Node* node) {
+            node->next.store(nullptr, std::memory_order_relaxed);
+            push_chain(node, node);
+        }
+
+        /**
+         * \brief first -> ... -> last 로 미리 연결된 node 들을 xchg 한번에 넣습니다.
+         * last->next 는 nullptr 이어야 합니다.
+         */
+        void push_chain(Node* first, Node* last) {
+            Node* prev = tail_.exchange(last, std::memory_order_acq_rel);
+            prev->next.store(first, std::memory_order_release);
+        }
+
+        /**
+         * \brief nodes 를 서로 연결한 뒤 push_chain 으로 한번에 넣습니다.
+         */
+        void push_n(std::span<Node*> nodes) {
+            if (nodes.empty()) return;
+            for (size_t i = 0; i + 1 < nodes.size(); ++i) nodes[i]->next.store(nodes[i + 1], std::memory_order_relaxed);
+            nodes.back()->next.store(nullptr, std::memory_order_relaxed);
+            push_chain(nodes.front(), nodes.back());
+        }
+
+        /**
+         * \return 꺼낸 node. 비어있거나 producer 가 연결하는 중이면 nullptr
+         */
+        Node* pop() {
+            Node* head = head_;
+            Node* next = head->next.load(std::memory_order_acquire);
+            if (head == &stub_) {
+                if (next == nullptr) return nullptr;
+                head_ = next;
+                head = next;
+                next = next->next.load(std::memory_order_acquire);
+            }
+            if (next) {
+                head_ = next;
+                return head;
+            }
+            if (head != tail_.load(std::memory_order_acquire)) return nullptr;
+            push(&stub_);
+            next = head->next.load(std::memory_order_acquire);
+            if (next) {
+                head_ = next;
+                return head;
+            }
+            return nullptr;
+        }
+
+        /**
+         * \return 꺼낸 node 수
+         */
+        size_t pop_n(std::span<Node*> out) {
+            size_t n = 0;
+            while (n < out.size() && (out[n] = pop())) ++n;
+            return n;
+        }
+    };
+}
@@ -1,6 +1,16 @@
 #pragma once
 #include <vector>
-#include <ranges>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <climits>
+#include <span>
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
 
 //yc class to hold the data
 #define YC_USE
@@ -10,48 +20,320 @@ concept nto_type = requires {
     YC_USE Nto::thread_id;
 };
 
+/**
+ * \brief nto_memory 의 크기 / 메모리 설정.
+ * initial_capacity 는 스레드마다 처음 만드는 객체 수입니다. 부족해지면 chunk 를 두배씩 늘려 추가합니다.
+ */
+struct nto_memory_options {
+    int initial_capacity = 8196;
+    // 스레드 하나가 가질 수 있는 최대 객체 수. 이 이상은 try_push 가 false 를 반환합니다.
+    int max_capacity = INT_MAX / 2;
+    // 객체 chunk 를 huge page(MAP_HUGETLB, 실패시 THP madvise) 로 할당합니다. linux 에서만 적용됩니다.
+    bool use_huge_pages = false;
+};
+
 /**
  * \brief threads... <-> one thread only (main_thread?)
  * 다수의 스레드와 하나의 스레드가 lock free 하게 객체를 관리 할 수 있는 클래스입니다.
  * 예상하는 대로 동작하였을 경우. thread safe 함을 확인 ^^.
+ * 객체는 chunk 단위로 늘어나며 한번 할당된 객체의 주소는 nto_memory 가 소멸할 때까지 바뀌지 않습니다.
  * [*** 중요! ***] object를 read하는 thread는 한개여야 합니다.
  * [*** 중요! ***] object를 write하는 thread는 여러개 일 수 있습니다.
  * \tparam Type Type of thread safe object
  * \tparam ThreadCount Number of threads, default is 1
- * \tparam Max Maximum number of threads, default is 1
  */
-template <nto_type Type, int ThreadCount = 1, int Max = 8196>
+template <nto_type Type, int ThreadCount = 1>
 class nto_memory {
-    std::vector<int> index_q_[ThreadCount];
-    std::vector<int> r_index_q_;
-    std::vector<Type> mem_;
-    std::vector<Type*> mem_ptr_;
-    volatile bool used_[Max * ThreadCount] {};
-    
-    int find_first_false(int thread_id) {
-        auto& iq = index_q_[thread_id];
-        if(iq.empty()) {
-            for(int i = 0; i < Max; ++i) {
-                if(!used_[thread_id * Max + i]) iq.push_back(Max * thread_id + i);
+    static constexpr size_t cache_line_size = 64;
+    static constexpr size_t huge_page_size = 2 * 1024 * 1024;
+    static constexpr int word_bits = 64;
+    // chunk k 는 initial_capacity << k 개의 객체를 가진다.
+    static constexpr int max_chunks = 24;
+
+    // 객체 앞에 자신의 slot 번호를 둔다. 객체 주소에서 slot 을 chunk 를 찾지 않고 바로 얻기 위해서다.
+    struct entry_t {
+        int slot;
+        alignas(Type) std::byte storage[sizeof(Type)];
+    };
+
+    // 한번에 할당되는 객체 묶음. slot 번호 [base, base + capacity) 를 담당한다.
+    struct chunk_t {
+        entry_t* objects = nullptr;
+        // readable 상태 bitmap. bit i == slot (base + i) 가 readable.
+        std::atomic<uint64_t>* ready_bits = nullptr;
+        // ready_bits 의 요약. bit w 가 꺼져 있으면 ready_bits[w] 는 0 이다. 켜져 있어도 0 일 수 있다.
+        // read thread 는 이것만 보고 빈 word 64개를 한번에 건너뛴다.
+        std::atomic<uint64_t>* summary_bits = nullptr;
+        // intrusive free list 의 link. next[i] 가 다음 slot 을 가리키며 -1 이 끝이다.
+        int* next = nullptr;
+        int base = 0;
+        int capacity = 0;
+        int word_count = 0;
+        int summary_count = 0;
+        size_t bytes = 0;
+        bool is_mapped = false;
+    };
+
+    // write thread 하나가 쓰는 상태. 서로 다른 write thread 의 상태는 cache line 을 공유하지 않는다.
+    struct alignas(cache_line_size) producer_t {
+        // write thread 만 사용한다.
+        int free_head = -1;
+        int capacity = 0;
+
+        // read_end 가 push 하고 write thread 가 통째로 가져가는 반환 list.
+        alignas(cache_line_size) std::atomic<int> returned_head {-1};
+
+        // write thread 가 chunk 를 추가하고 release 로 chunk_count 를 올린다.
+        alignas(cache_line_size) std::atomic<int> chunk_count {0};
+        chunk_t* chunks[max_chunks] {};
+    };
+
+    nto_memory_options options_;
+    std::vector<producer_t> producers_;
+
+    static uint64_t bit_of(const int idx) { return uint64_t{1} << (idx % word_bits); }
+
+    static void* alloc_pages(const size_t bytes, const bool use_huge_pages, bool& is_mapped) {
+#if defined(__linux__)
+        if (use_huge_pages) {
+            const size_t size = (bytes + huge_page_size - 1) / huge_page_size * huge_page_size;
+            void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (p == MAP_FAILED) {
+                // 예약된 huge page 가 없으면 transparent huge page 로 대체한다.
+                p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (p == MAP_FAILED) throw std::bad_alloc();
+                madvise(p, size, MADV_HUGEPAGE);
             }
+            is_mapped = true;
+            return p;
         }
-        if(iq.empty()) return -1;
-        auto i = iq.back();
-        iq.pop_back();
-        return i;
+#endif
+        is_mapped = false;
+        return ::operator new(bytes, std::align_val_t{cache_line_size});
     }
+
+    static void free_pages(void* p, const size_t bytes, const bool is_mapped) {
+#if defined(__linux__)
+        if (is_mapped) {
+            munmap(p, (bytes + huge_page_size - 1) / huge_page_size * huge_page_size);
+            return;
+        }
+#endif
+        ::operator delete(p, std::align_val_t{cache_line_size});
+    }
+
+    static Type* object_of(entry_t& e) {
+        return std::launder(reinterpret_cast<Type*>(e.storage));
+    }
+
+    static const entry_t* entry_of(const Type* obj) {
+        return reinterpret_cast<const entry_t*>(reinterpret_cast<const std::byte*>(obj) - offsetof(entry_t, storage));
+    }
+
+    int chunk_of(const int slot) const {
+        return std::bit_width(static_cast<unsigned>(slot / options_.initial_capacity + 1)) - 1;
+    }
+
+    chunk_t& chunk_at(producer_t& p, const int slot) const {
+        return *p.chunks[chunk_of(slot)];
+    }
+
+    // write thread 에서만 호출한다. 새 chunk 를 만들어 free list 에 붙인다.
+    bool grow(const int thread_id) {
+        auto& p = producers_[thread_id];
+        const int k = p.chunk_count.load(std::memory_order_relaxed);
+        if (k == max_chunks) return false;
+        const long long capacity = static_cast<long long>(options_.initial_capacity) << k;
+        if (p.capacity + capacity > options_.max_capacity) return false;
+
+        auto* c = new chunk_t;
+        c->base = p.capacity;
+        c->capacity = static_cast<int>(capacity);
+        c->word_count = (c->capacity + word_bits - 1) / word_bits;
+        c->bytes = (sizeof(entry_t) * c->capacity + cache_line_size - 1) / cache_line_size * cache_line_size;
+        c->objects = static_cast<entry_t*>(alloc_pages(c->bytes, options_.use_huge_pages, c->is_mapped));
+        c->summary_count = (c->word_count + word_bits - 1) / word_bits;
+        c->ready_bits = new (std::align_val_t{cache_line_size}) std::atomic<uint64_t>[c->word_count] {};
+        c->summary_bits = new (std::align_val_t{cache_line_size}) std::atomic<uint64_t>[c->summary_count] {};
+        c->next = new int[c->capacity];
+        for (int i = 0; i < c->capacity; ++i) {
+            auto* e = new (&c->objects[i]) entry_t;
+            e->slot = c->base + i;
+            new (e->storage) Type();
+            object_of(*e)->thread_id = thread_id;
+            c->next[i] = i + 1 < c->capacity ? c->base + i + 1 : p.free_head;
+        }
+        p.free_head = c->base;
+        p.capacity += c->capacity;
+        p.chunks[k] = c;
+        // release: read thread 가 chunk_count 를 acquire 로 읽으면 chunk 내용이 보인다.
+        p.chunk_count.store(k + 1, std::memory_order_release);
+        return true;
+    }
+
+    static void destroy_chunk(chunk_t* c) {
+        for (int i = 0; i < c->capacity; ++i) object_of(c->objects[i])->~Type();
+        free_pages(c->objects, c->bytes, c->is_mapped);
+        ::operator delete[](c->ready_bits, std::align_val_t{cache_line_size});
+        ::operator delete[](c->summary_bits, std::align_val_t{cache_line_size});
+        delete[] c->next;
+        delete c;
+    }
+
+    Type* object_at(const int thread_id, const int slot) {
+        auto& c = chunk_at(producers_[thread_id], slot);
+        return object_of(c.objects[slot - c.base]);
+    }
+
+    // 객체 주소로 slot 번호를 찾는다. 객체 앞의 entry_t 에서 읽으므로 chunk 수와 상관없다.
+    static int index_of(const Type* obj) {
+        return entry_of(obj)->slot;
+    }
+
+    int pop_free_slot(const int thread_id) {
+        auto& p = producers_[thread_id];
+        // acquire: read thread 가 slot 을 반환하기 전까지의 접근이 이후의 write 보다 먼저 일어남을 보장한다.
+        if(p.free_head == -1) p.free_head = p.returned_head.exchange(-1, std::memory_order_acquire);
+        if(p.free_head == -1 && !grow(thread_id)) return -1;
+        const int slot = p.free_head;
+        auto& c = chunk_at(p, slot);
+        p.free_head = c.next[slot - c.base];
+        return slot;
+    }
+
+    // write thread 에서 ready_bits[w] 에 mask 를 켠다. word 가 0 에서 바뀌었을 때만 summary 를 켠다.
+    // 이미 켜져 있던 word 는 그 bit 를 켠 thread 가 summary 를 켰거나 켤 것이다.
+    static void publish_bits(chunk_t& c, const int w, const uint64_t mask) {
+        // release: obj 에 쓴 내용이 bit 를 acquire 로 읽은 read thread 에게 보인다.
+        if (c.ready_bits[w].fetch_or(mask, std::memory_order_release) == 0) {
+            c.summary_bits[w / word_bits].fetch_or(bit_of(w), std::memory_order_release);
+        }
+    }
+
+    // read thread 에서 ready_bits[w] 가 비었다고 본 뒤 summary bit 를 끈다.
+    // 끄고 나서 word 를 다시 읽으므로, 그 사이 write thread 가 bit 를 켰다면 summary 를 되살린다.
+    // write thread 의 summary fetch_or 가 먼저였다면 acq_rel fetch_and 가 그것을 읽어 다시 읽은 word 에 bit 가 보인다.
+    static void clear_summary_if_empty(chunk_t& c, const int w) {
+        c.summary_bits[w / word_bits].fetch_and(~bit_of(w), std::memory_order_acq_rel);
+        if (c.ready_bits[w].load(std::memory_order_acquire) != 0) {
+            c.summary_bits[w / word_bits].fetch_or(bit_of(w), std::memory_order_release);
+        }
+    }
+
+    // read thread 에서 ready bit 를 끈다. word 가 비면 summary 도 끈다.
+    static void retire_bits(chunk_t& c, const int w, const uint64_t mask) {
+        // 소유권은 returned_head 의 release/acquire 로 넘어가므로 bit 를 지우는 것은 relaxed 로 충분하다.
+        if ((c.ready_bits[w].fetch_and(~mask, std::memory_order_relaxed) & ~mask) == 0) clear_summary_if_empty(c, w);
+    }
+
+    // read thread 가 slot 을 producer 에게 돌려준다. lock free MPSC push.
+    void push_returned_slot(producer_t& p, const int slot) {
+        auto& c = chunk_at(p, slot);
+        int h = p.returned_head.load(std::memory_order_relaxed);
+        do {
+            c.next[slot - c.base] = h;
+        } while(!p.returned_head.compare_exchange_weak(h, slot, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    // summary 로 비어있지 않은 word 만 골라 readable 객체를 돌려주는 iterator.
+    // summary / word 를 읽을 때의 snapshot 을 사용하므로 순회 중에 read_end 를 호출해도 된다.
+    class read_iterator {
+        nto_memory* owner_ = nullptr;
+        int thread_id_ = ThreadCount;
+        int chunk_ = 0;
+        int chunk_count_ = 0;
+        int summary_ = 0;
+        uint64_t summary_bits_ = 0;
+        int word_ = 0;
+        uint64_t bits_ = 0;
+        chunk_t* c_ = nullptr;
+
+        bool next_chunk() {
+            ++chunk_;
+            while (chunk_ >= chunk_count_) {
+                if (++thread_id_ == ThreadCount) return false;
+                chunk_ = 0;
+                chunk_count_ = owner_->producers_[thread_id_].chunk_count.load(std::memory_order_acquire);
+            }
+            c_ = owner_->producers_[thread_id_].chunks[chunk_];
+            summary_ = -1;
+            summary_bits_ = 0;
+            return true;
+        }
+
+        void seek() {
+            while (bits_ == 0) {
+                if (summary_bits_ == 0) {
+                    if (c_ == nullptr || ++summary_ == c_->summary_count) {
+                        if (!next_chunk()) return;
+                        continue;
+                    }
+                    summary_bits_ = c_->summary_bits[summary_].load(std::memory_order_acquire);
+                    continue;
+                }
+                word_ = summary_ * word_bits + std::countr_zero(summary_bits_);
+                summary_bits_ &= summary_bits_ - 1;
+                bits_ = c_->ready_bits[word_].load(std::memory_order_acquire);
+                // 켜진 채 남은 summary bit. 다음 순회에서 다시 읽지 않도록 끈다.
+                if (bits_ == 0) clear_summary_if_empty(*c_, word_);
+            }
+        }
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Type*;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Type**;
+        using reference = Type*;
+
+        read_iterator() = default;
+        explicit read_iterator(nto_memory* owner) : owner_(owner), thread_id_(-1), chunk_(-1) { seek(); }
+
+        Type* operator*() const {
+            return object_of(c_->objects[word_ * word_bits + std::countr_zero(bits_)]);
+        }
+        read_iterator& operator++() {
+            bits_ &= bits_ - 1;
+            seek();
+            return *this;
+        }
+        read_iterator operator++(int) {
+            auto r = *this;
+            ++*this;
+            return r;
+        }
+        bool operator==(const read_iterator& other) const {
+            return thread_id_ == other.thread_id_ &&
+                (thread_id_ == ThreadCount || (c_ == other.c_ && word_ == other.word_ && bits_ == other.bits_ &&
+                    summary_bits_ == other.summary_bits_));
+        }
+    };
+
+    struct read_range {
+        nto_memory* owner;
+        read_iterator begin() const { return read_iterator(owner); }
+        read_iterator end() const { return read_iterator(); }
+    };
 public:
-    explicit nto_memory() : mem_(Max * ThreadCount), mem_ptr_(Max * ThreadCount) {
-        for (int i = 0; i < ThreadCount; ++i) {
-            for (int j = 0; j < Max; ++j) 
-                mem_[i * Max + j].thread_id = i;
-            index_q_[i].reserve(Max);
+    explicit nto_memory(const nto_memory_options& options = {}) : options_(options), producers_(ThreadCount) {
+        if (options_.initial_capacity < 1) options_.initial_capacity = 1;
+        for (int i = 0; i < ThreadCount; ++i) grow(i);
+    }
+    ~nto_memory() {
+        for (auto& p : producers_) {
+            for (int k = 0; k < p.chunk_count.load(); ++k) destroy_chunk(p.chunks[k]);
         }
     }
+    nto_memory(const nto_memory&) = delete;
+    nto_memory& operator=(const nto_memory&) = delete;
+
+    /**
+     * \brief write thread 가 쓸 객체를 하나 가져옵니다. 비어있는 객체가 없으면 chunk 를 늘립니다.
+     * \return max_capacity 에 도달해 더이상 늘릴 수 없으면 false
+     */
     bool try_push(const int thread_id, Type*& out) {
-        const int idx = find_first_false(thread_id);
+        const int idx = pop_free_slot(thread_id);
         if(idx == -1) return false;
-        out = &mem_[idx];
+        out = object_at(thread_id, idx);
         return true;
     }
 
@@ -60,8 +342,10 @@ public:
      * \param obj read thread가 권한을 가질 수 있게 되는 객체
      */
     void make_readable(Type*& obj) {
-        auto idx = (obj - mem_.data()) % Max;
-        used_[obj->thread_id * Max + idx] = true;
+        const auto idx = index_of(obj);
+        auto& c = chunk_at(producers_[obj->thread_id], idx);
+        const int i = idx - c.base;
+        publish_bits(c, i / word_bits, bit_of(i));
         obj = nullptr;
     }
 
@@ -71,17 +355,133 @@ public:
      * \param obj write thread 가 객체에 쓸 수 있도록 객체를 반환합니다.
      */
     void read_end(Type*& obj) {
-        auto idx = (obj - mem_.data()) % Max;
-        used_[obj->thread_id * Max + idx] = false;
+        const auto idx = index_of(obj);
+        auto& p = producers_[obj->thread_id];
+        auto& c = chunk_at(p, idx);
+        const int i = idx - c.base;
+        retire_bits(c, i / word_bits, bit_of(i));
+        push_returned_slot(p, idx);
         obj = nullptr;
     }
-    
-    auto& get_read_ranges() {
-        mem_ptr_.clear();
-        for(auto& i : std::views::filter(used_, [](auto& b) { return b; })) {
-            mem_ptr_.push_back(&mem_[&i - used_]);
+
+    /**
+     * \brief write thread 가 쓸 객체를 최대 out.size() 개 한번에 가져옵니다.
+     * \return 가져온 객체 수. max_capacity 에 도달하면 out.size() 보다 작을 수 있습니다.
+     */
+    size_t try_push_n(const int thread_id, std::span<Type*> out) {
+        size_t n = 0;
+        for (; n < out.size(); ++n) {
+            const int idx = pop_free_slot(thread_id);
+            if (idx == -1) break;
+            out[n] = object_at(thread_id, idx);
         }
-        return mem_ptr_;
+        return n;
+    }
+
+    /**
+     * \brief 여러 객체를 한번에 read thread 에게 넘깁니다.
+     * 같은 bitmap word 에 속한 객체는 release fetch_or 한번으로 묶습니다. 호출 후 objs 의 원소는 nullptr 이 됩니다.
+     * \param objs 같은 write thread 에서 try_push(_n) 으로 얻은 객체들
+     */
+    void make_readable_n(std::span<Type*> objs) {
+        chunk_t* chunk = nullptr;
+        int word = -1;
+        uint64_t mask = 0;
+        for (auto& obj : objs) {
+            const auto idx = index_of(obj);
+            auto& c = chunk_at(producers_[obj->thread_id], idx);
+            const int i = idx - c.base;
+            if (&c != chunk || i / word_bits != word) {
+                if (chunk) publish_bits(*chunk, word, mask);
+                chunk = &c;
+                word = i / word_bits;
+                mask = 0;
+            }
+            mask |= bit_of(i);
+            obj = nullptr;
+        }
+        if (chunk) publish_bits(*chunk, word, mask);
+    }
+
+    /**
+     * \brief readable 한 객체를 최대 out.size() 개 모아 옵니다. read thread 에서만 호출해야 합니다.
+     * \return 모아 온 객체 수
+     */
+    size_t read_batch(std::span<Type*> out) {
+        size_t n = 0;
+        for (auto it = get_read_ranges().begin(); n < out.size() && it != read_iterator(); ++it) {
+            out[n++] = *it;
+        }
+        return n;
+    }
+
+    /**
+     * \brief 여러 객체의 참조를 한번에 그만합니다.
+     * 객체들을 write thread 별로 하나의 list 로 엮어 CAS 한번에 돌려줍니다. 호출 후 objs 의 원소는 nullptr 이 됩니다.
+     */
+    void read_end_n(std::span<Type*> objs) {
+        int head[ThreadCount];
+        int tail[ThreadCount];
+        for (int t = 0; t < ThreadCount; ++t) head[t] = tail[t] = -1;
+
+        for (auto& obj : objs) {
+            const int t = obj->thread_id;
+            const auto idx = index_of(obj);
+            auto& c = chunk_at(producers_[t], idx);
+            const int i = idx - c.base;
+            retire_bits(c, i / word_bits, bit_of(i));
+            c.next[i] = head[t];
+            head[t] = idx;
+            if (tail[t] == -1) tail[t] = idx;
+            obj = nullptr;
+        }
+
+        for (int t = 0; t < ThreadCount; ++t) {
+            if (head[t] == -1) continue;
+            auto& p = producers_[t];
+            auto& c = chunk_at(p, tail[t]);
+            int h = p.returned_head.load(std::memory_order_relaxed);
+            do {
+                c.next[tail[t] - c.base] = h;
+            } while(!p.returned_head.compare_exchange_weak(h, head[t], std::memory_order_release, std::memory_order_relaxed));
+        }
+    }
+
+    /**
+     * \brief readable 한 객체를 순회하는 range 를 반환합니다. vector 를 새로 만들지 않습니다.
+     * summary word 하나로 빈 bitmap word 64개(객체 4096개)를 건너뛰므로 비용은 chunk 수 + (capacity / 4096) 와
+     * readable 객체가 있는 word 수에 비례합니다.
+     */
+    read_range get_read_ranges() {
+        return read_range{ this };
+    }
+
+    /**
+     * \brief readable 한 객체마다 f(Type*) 를 호출합니다.
+     */
+    template <typename F>
+    void for_each_readable(F&& f) {
+        for (auto& p : producers_) {
+            const int n = p.chunk_count.load(std::memory_order_acquire);
+            for (int k = 0; k < n; ++k) {
+                chunk_t* c = p.chunks[k];
+                for (int s = 0; s < c->summary_count; ++s) {
+                    for (uint64_t words = c->summary_bits[s].load(std::memory_order_acquire); words; words &= words - 1) {
+                        const int w = s * word_bits + std::countr_zero(words);
+                        for (uint64_t bits = c->ready_bits[w].load(std::memory_order_acquire); bits; bits &= bits - 1) {
+                            f(object_of(c->objects[w * word_bits + std::countr_zero(bits)]));
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * \brief write thread 가 현재 가지고 있는 객체 수. 해당 write thread 에서만 호출해야 합니다.
+     */
+    int capacity(const int thread_id) const {
+        return producers_[thread_id].capacity;
     }
 };
 
@@ -1,21 +1,65 @@
 #pragma once
 
+#include <algorithm>
 #include <iostream>
 #include <functional>
 #include <vector>
 #include <queue>
+#include <deque>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <latch>
 
 #include <thread>
 #include <mutex>
 #include <condition_variable>
 
+#include "memory/yc_pool_allocator.hpp"
+#include "memory/yc_pool_function.hpp"
+#include "diag/yc_trace.hpp"
+#include "diag/yc_metrics.hpp"
+
+/**
+ * \brief task 의 우선순위 lane.
+ * worker 는 항상 높은 lane(realtime -> tick -> background) 부터 비웁니다.
+ */
+enum class task_priority : int {
+    realtime,
+    tick,
+    background,
+    count
+};
+
 class test_thread_pool {
+public:
+    using clock_type = std::chrono::steady_clock;
+
 private:
+    static constexpr size_t lane_count = static_cast<size_t>(task_priority::count);
+
+    // job 의 capture 는 inline 에 들어가지 않으면 thread cache pool 에 할당된다.
+    struct task_t {
+        yc_mem::pool_function<void()> job;
+        std::optional<clock_type::time_point> deadline;
+    };
+
     size_t size;
     std::vector<std::thread> pool;
 
     bool end_threads;
-    std::queue<std::function<void()>> jobs;
+    // lane 의 deque block 은 add_task / worker thread 사이를 오가므로 thread cache pool 에서 할당한다.
+    std::array<std::queue<task_t, std::deque<task_t, yc_mem::pool_allocator<task_t>>>, lane_count> jobs;
+
+    // background 작업이 모든 worker 를 점유하지 못하도록 동시 실행 수를 제한한다.
+    size_t background_limit;
+    size_t running_background;
+
+    std::array<std::atomic<size_t>, lane_count> deadline_miss_count {};
+
+    // lane 별 대기 중인 작업 수. pool 이 여러개면 합쳐서 보인다.
+    std::array<yc_metrics::gauge_t*, lane_count> queue_depth {};
 
     std::mutex mutex_for_queue;
     std::condition_variable cv_for_queue;
@@ -23,23 +67,66 @@ private:
     std::condition_variable cv_finished;
 
 private:
+    static size_t lane_of(const task_priority priority) {
+        return static_cast<size_t>(priority);
+    }
+
+    bool empty_all_lanes() const {
+        for (auto &q : jobs) {
+            if (!q.empty()) return false;
+        }
+        return true;
+    }
+
+    // lock 을 잡은 상태에서 호출해야 한다. 꺼낼 수 있는 lane 이 없으면 lane_count 를 반환한다.
+    size_t find_ready_lane() const {
+        for (size_t lane = 0; lane < lane_count; ++lane) {
+            if (jobs[lane].empty()) continue;
+            if (lane == lane_of(task_priority::background) && running_background >= background_limit) continue;
+            return lane;
+        }
+        return lane_count;
+    }
+
     void execute_job() {
         while (true) {
             std::unique_lock<std::mutex> lock(mutex_for_queue);
-            cv_for_queue.wait(lock, [this]() { return !this->jobs.empty() || this->end_threads; });
+            cv_for_queue.wait(lock, [this]() {
+                return this->find_ready_lane() != lane_count || (this->end_threads && this->empty_all_lanes());
+            });
 
             // end thread
-            if (this->end_threads && this->jobs.empty()) {
+            if (this->end_threads && this->empty_all_lanes()) {
                 return;
             }
 
-            // fetch job from the queue
-            auto job = std::move(jobs.front());
-            jobs.pop();
+            const size_t lane = find_ready_lane();
+
+            // fetch job from the highest lane
+            auto task = std::move(jobs[lane].front());
+            jobs[lane].pop();
+            YC_METRICS(queue_depth[lane]->add(-1);)
+            const bool is_background = lane == lane_of(task_priority::background);
+            if (is_background) ++running_background;
             lock.unlock();
 
             // execute the job
-            job();
+            {
+                YC_TRACE_ZONE("test_thread_pool::job");
+                task.job();
+            }
+
+            if (task.deadline && clock_type::now() > *task.deadline) {
+                deadline_miss_count[lane].fetch_add(1, std::memory_order_relaxed);
+            }
+
+            if (is_background) {
+                lock.lock();
+                --running_background;
+                lock.unlock();
+                // 제한에 걸려 대기하던 background 작업을 깨운다.
+                cv_for_queue.notify_one();
+            }
 
             cv_finished.notify_one();
         }
@@ -47,7 +134,15 @@ private:
 
 public:
     test_thread_pool(size_t thread_count)
-      : size(thread_count), end_threads(false) {
+      : size(thread_count), end_threads(false),
+        background_limit(thread_count > 1 ? thread_count - 1 : 1), running_background(0) {
+        YC_METRICS(
+            static constexpr const char* lane_names[] = { "realtime", "tick", "background" };
+            for (size_t lane = 0; lane < lane_count; ++lane) {
+                queue_depth[lane] = &yc_metrics::gauge("yc_thread_pool_queue_depth", "lane 별 대기 중인 작업 수",
+                                                       std::string("lane=\"") + lane_names[lane] + "\"");
+            }
+        )
         // create threads
         new(&pool) std::vector<std::thread>(thread_count); // placement new
         for (auto &t : pool) {
@@ -57,35 +152,109 @@ public:
         }
     }
     ~test_thread_pool() {
-        this->end_threads = true;
+        {
+            std::lock_guard<std::mutex> lock(mutex_for_queue);
+            this->end_threads = true;
+        }
         cv_for_queue.notify_all();
         for (auto &t : pool) {
             t.join();
         }
     }
 
-    void add_task(std::function<void()> job) {
+    /**
+     * \brief tick lane 에 작업을 추가합니다.
+     */
+    void add_task(yc_mem::pool_function<void()> job) {
+        add_task(std::move(job), task_priority::tick);
+    }
+
+    /**
+     * \brief 지정한 lane 에 작업을 추가합니다.
+     * \param job 실행할 작업
+     * \param priority 작업이 들어갈 lane
+     * \param deadline 이 시각 이후에 작업이 끝나면 deadline miss 로 집계됩니다.
+     */
+    void add_task(yc_mem::pool_function<void()> job, const task_priority priority,
+                  const std::optional<clock_type::time_point> deadline = std::nullopt) {
         if (this->end_threads) {
             throw std::runtime_error("ThreadPool is ended");
         }
         {
             std::lock_guard<std::mutex> lock(mutex_for_queue);
-            jobs.push(std::move(job));
+            jobs[lane_of(priority)].push(task_t{ std::move(job), deadline });
+            YC_METRICS(queue_depth[lane_of(priority)]->add(1);)
         }
         cv_for_queue.notify_one();
     }
 
+    /**
+     * \brief 지금부터 budget 안에 끝나야 하는 작업을 추가합니다.
+     */
+    void add_task(yc_mem::pool_function<void()> job, const task_priority priority, const clock_type::duration budget) {
+        add_task(std::move(job), priority, clock_type::now() + budget);
+    }
+
+    /**
+     * \brief 동시에 실행될 수 있는 background 작업 수를 설정합니다. 최소값은 1입니다.
+     */
+    void set_background_limit(const size_t limit) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_for_queue);
+            background_limit = limit > 0 ? limit : 1;
+        }
+        cv_for_queue.notify_all();
+    }
+
+    size_t get_deadline_miss_count(const task_priority priority) const {
+        return deadline_miss_count[lane_of(priority)].load(std::memory_order_relaxed);
+    }
+
+    size_t get_queue_size(const task_priority priority) {
+        std::lock_guard<std::mutex> lock(mutex_for_queue);
+        return jobs[lane_of(priority)].size();
+    }
+
     bool is_busy() {
         bool poolbusy;
         {
             std::unique_lock<std::mutex> lock(mutex_for_queue);
-            poolbusy = jobs.empty();
+            poolbusy = empty_all_lanes();
         }
         return poolbusy;
     }
 
     void wait_all() {
         std::unique_lock<std::mutex> lock(mutex_for_queue);
-        cv_finished.wait(lock, [this](){ return this->jobs.empty(); });
+        cv_finished.wait(lock, [this](){ return this->empty_all_lanes(); });
+    }
+
+    /**
+     * \brief [0, count) 를 나눠 worker 들과 호출한 thread 가 함께 실행하고, 모두 끝날 때까지 기다립니다.
+     * [*** 중요! ***] worker thread 안(작업 안)에서 호출하면 안 됩니다. 자기가 처리해야 할 작업을 기다리며 멈출 수 있습니다.
+     * \param count 나눌 범위의 크기
+     * \param job [begin, end) 를 받아 처리하는 함수. 예외를 던지면 안 됩니다.
+     * \param priority 나눠진 작업이 들어갈 lane
+     */
+    void parallel_for(const size_t count, const std::function<void(size_t, size_t)>& job,
+                      const task_priority priority = task_priority::tick) {
+        if (count == 0) return;
+        const size_t chunks = std::min(count, size + 1);
+        if (chunks == 1) {
+            job(0, count);
+            return;
+        }
+        // 첫 조각은 호출한 thread 가 직접 처리한다.
+        std::latch done(static_cast<std::ptrdiff_t>(chunks - 1));
+        for (size_t c = 1; c < chunks; ++c) {
+            const size_t begin = count * c / chunks;
+            const size_t end = count * (c + 1) / chunks;
+            add_task([&job, &done, begin, end] {
+                job(begin, end);
+                done.count_down();
+            }, priority);
+        }
+        job(0, count / chunks);
+        done.wait();
     }
-};
\ No newline at end of file
+};
@@ -0,0 +1,56 @@
+#include "test_module/yc_test.hpp"
+#include "test_module/yc_alloc_counter.hpp"
+#include "test_module/bench_memory.hpp"
+#include "test_module/bench_container.hpp"
+#include "test_module/bench_packet.hpp"
+#include "test_module/bench_rudp.hpp"
+#include "test_module/bench_thread.hpp"
+#include "test_module/bench_lf_queue.hpp"
+#include "test_module/bench_physics.hpp"
+#include "test_module/bench_trace.hpp"
+#include "test_module/bench_metrics.hpp"
+#include "test_module/bench_log.hpp"
+
+/**
+ * yc_bench [--filter=이름] [--json=out.json] [--csv=out.csv] [--samples=N] [--min-time-ms=ms] [--clock=tsc]
+ *          [--baseline=baseline.csv] [--threshold=0.1] [--save-baseline=baseline.csv] [--trace=trace.json]
+ * --baseline 을 주면 p50 이 threshold 비율 이상 느려진 benchmark 가 있을 때 1 을 반환합니다.
+ * yc_alloc_counter.hpp 로 global operator new 를 세어 benchmark 마다 측정 구간의 allocs_per_iter 를 함께 보고합니다.
+ * --trace 는 YC_TRACE_ENABLED 로 build 했을 때 benchmark 중 기록된 구간을 chrome trace json 으로 저장합니다.
+ */
+int main(int argc, char* argv[]) {
+    std::vector<std::string> rest;
+    auto options = yc::test::parse_options(argc, argv, &rest);
+
+    std::string baseline_path;
+    std::string save_path;
+    std::string trace_path;
+    double threshold = 0.1;
+    for (const auto& arg : rest) {
+        if (arg.starts_with("--baseline=")) baseline_path = arg.substr(11);
+        else if (arg.starts_with("--save-baseline=")) save_path = arg.substr(16);
+        else if (arg.starts_with("--threshold=")) threshold = std::atof(arg.c_str() + 12);
+        else if (arg.starts_with("--trace=")) trace_path = arg.substr(8);
+        else {
+            std::cerr << "unknown option: " << arg << "\n";
+            return 2;
+        }
+    }
+
+    const auto results = yc::test::run_all(options);
+
+    if (!trace_path.empty() && !yc_trace::save(trace_path)) {
+        std::cerr << "failed to write " << trace_path << "\n";
+    }
+
+    if (!save_path.empty()) {
+        std::ofstream f(save_path);
+        yc::test::write_csv(f, results);
+    }
+
+    if (!baseline_path.empty()) {
+        const auto baseline = yc::test::load_baseline(baseline_path);
+        if (yc::test::compare_to_baseline(std::cout, results, baseline, threshold) > 0) return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,31 @@
+#include "test_module/yc_test.hpp"
+#include "test_module/yc_alloc_counter.hpp"
+#include "test_module/test_container.hpp"
+#include "test_module/test_diag.hpp"
+#include "test_module/test_memory.hpp"
+#include "test_module/test_packet.hpp"
+#include "test_module/test_physics.hpp"
+#include "test_module/test_thread.hpp"
+
+/**
+ * yc_test [--filter=이름]
+ * 실패한 test 가 있으면 1 을 반환합니다.
+ *
+ * g++ -std=c++20 -O2 -pthread -I. yc_test.cpp -o yc_test
+ * AVX2 kernel 은 -mavx2 -mfma 를 더한 build 에서만 검사됩니다.
+ * thread test 는 ThreadSanitizer build 로도 돌립니다. data race 가 보고되면 실패로 봅니다.
+ * g++ -std=c++20 -O1 -g -fsanitize=thread -pthread -I. yc_test.cpp -o yc_test_tsan
+ * TSAN_OPTIONS=halt_on_error=1 ./yc_test_tsan
+ */
+int main(int argc, char* argv[]) {
+    std::string filter;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg.starts_with("--filter=")) filter = arg.substr(9);
+        else {
+            std::cerr << "unknown option: " << arg << "\n";
+            return 2;
+        }
+    }
+    return yc::test::run_tests(filter) > 0 ? 1 : 0;
+}
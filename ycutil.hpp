@@ -1,7 +1,14 @@
 // ReSharper disable CppClangTidyCppcoreguidelinesSpecialMemberFunctions
 #pragma once
-#include <optional>
-#include <string>
+#include <cassert>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 
 template <class ContainerType>
 concept Container = requires(ContainerType a, const ContainerType b)
@@ -28,49 +35,205 @@ concept Container = requires(ContainerType a, const ContainerType b)
 };
 
 namespace yc {
+	/**
+	 * \brief 에러가 어느 모듈에서 왔는지.
+	 */
+	enum class err_category_t : uint8_t {
+		generic,
+		packet,
+		rudp,
+		thread,
+		physics,
+	};
+
+	/**
+	 * \brief 할당이 없는 에러 값. trivially copyable 합니다.
+	 * msg 는 string literal 같은 static 문자열만 가리켜야 합니다.
+	 * err_t{} (generic, 0) 는 에러 없음입니다. result_t::error() 는 값이 있으면 이것을 반환합니다.
+	 */
+	struct err_t {
+		// 문자열만으로 만든 에러의 code. 에러 없음(0)과 구별되고, 같은 code 끼리는 msg 내용으로 비교한다.
+		static constexpr int message_code = -1;
+
+		err_category_t category = err_category_t::generic;
+		int code = 0;
+		const char* msg = "";
+
+		constexpr err_t() = default;
+		// 문자열이 result_t 의 값인지 에러인지 헷갈리지 않도록 암시적 변환을 막는다.
+		constexpr explicit err_t(const char* msg) : code(message_code), msg(msg) {}
+		constexpr err_t(const err_category_t category, const int code, const char* msg = "")
+			: category(category), code(code), msg(msg) {}
+		template <typename E> requires std::is_enum_v<E>
+		constexpr err_t(const err_category_t category, const E code, const char* msg = "")
+			: category(category), code(static_cast<int>(code)), msg(msg) {}
+
+		/**
+		 * \brief category 와 code 로 비교합니다. 문자열만으로 만든 에러끼리는 msg 내용도 같아야 합니다.
+		 */
+		constexpr bool operator==(const err_t& other) const {
+			if (category != other.category || code != other.code) return false;
+			return code != message_code || std::string_view(msg) == std::string_view(other.msg);
+		}
+	};
+	static_assert(std::is_trivially_copyable_v<err_t>);
+
 	template <typename T>
-	struct err_opt_t : std::optional<T> {
-		std::string err;
-		
-		err_opt_t() {}
-		explicit err_opt_t(T& value) { *static_cast<std::optional<T>*>(this) = value; }
-		explicit err_opt_t(T&& value) { *static_cast<std::optional<T>*>(this) = std::move(value); }
-		err_opt_t(err_opt_t<T>& other) { operator=(other); }
-		err_opt_t(err_opt_t<T>&& other) noexcept { operator=(other); }
-
-		explicit err_opt_t(const char* e) { err = e;}
-		explicit err_opt_t(const std::string e) { err = e; }
-		explicit err_opt_t(const std::string&& e) { err = e; }
-		err_opt_t& operator= (const std::string&& e) { err = e; return *this; }
-		err_opt_t& operator= (const char* e) { err = e; return *this; }
-		
-		err_opt_t& operator= (err_opt_t<T>& other) {
-			if (other.has_value()) *static_cast<std::optional<T>*>(this) = other.value();
-			else													 err = other.err;
-			return *this;
+	class result_t;
+
+	template <typename R>
+	struct is_result : std::false_type {};
+	template <typename T>
+	struct is_result<result_t<T>> : std::true_type {};
+
+	/**
+	 * \brief std::expected 형태의 결과 값. T 또는 err_t 를 담습니다.
+	 * T 가 trivially copyable 하면 result_t 도 trivially copyable 합니다.
+	 * and_then / transform / or_else 로 이어 붙일 수 있고, 기존 err_opt_t 처럼 operator| 도 사용할 수 있습니다.
+	 * 에러는 err_t 로만 만들어집니다. result_t<std::string> r = "ok"; 는 값입니다.
+	 */
+	template <typename T>
+	class result_t {
+		union {
+			T value_;
+			err_t err_;
+		};
+		bool has_value_;
+
+	public:
+		using value_type = T;
+
+		constexpr result_t() requires std::is_default_constructible_v<T> : value_(), has_value_(true) {}
+		constexpr result_t(const T& value) : value_(value), has_value_(true) {}
+		constexpr result_t(T&& value) noexcept(std::is_nothrow_move_constructible_v<T>) : value_(std::move(value)), has_value_(true) {}
+		// T 로 만들 수 있는 값. (result_t<std::string> r = "ok"; 등) T 로 암시적 변환이 되지 않으면 explicit 이다.
+		template <typename U = T>
+			requires (!std::is_same_v<std::remove_cvref_t<U>, result_t> &&
+				!std::is_same_v<std::remove_cvref_t<U>, err_t> &&
+				std::is_constructible_v<T, U&&>)
+		constexpr explicit(!std::is_convertible_v<U&&, T>) result_t(U&& value) : value_(std::forward<U>(value)), has_value_(true) {}
+		constexpr result_t(const err_t err) : err_(err), has_value_(false) {}
+
+		constexpr result_t(const result_t&) requires std::is_trivially_copy_constructible_v<T> = default;
+		constexpr result_t(const result_t& other) : has_value_(other.has_value_) {
+			if (has_value_) std::construct_at(&value_, other.value_);
+			else std::construct_at(&err_, other.err_);
 		}
-		err_opt_t& operator= (err_opt_t<T>&& other) noexcept {
-			if (other.has_value()) *static_cast<std::optional<T>*>(this) = other.value();
-			else													 err = other.err;
-			return *this;
+		constexpr result_t(result_t&&) requires std::is_trivially_move_constructible_v<T> = default;
+		constexpr result_t(result_t&& other) noexcept(std::is_nothrow_move_constructible_v<T>) : has_value_(other.has_value_) {
+			if (has_value_) std::construct_at(&value_, std::move(other.value_));
+			else std::construct_at(&err_, other.err_);
 		}
-		err_opt_t& operator= (T& value) {
-			*static_cast<std::optional<T>*>(this) = value;
+
+		constexpr result_t& operator=(const result_t&) requires std::is_trivially_copy_assignable_v<T> && std::is_trivially_copy_constructible_v<T> = default;
+		constexpr result_t& operator=(const result_t& other) {
+			if (this != &other) assign(other);
 			return *this;
 		}
-		err_opt_t& operator= (T&& value) {
-			*static_cast<std::optional<T>*>(this) = std::move(value);
+		constexpr result_t& operator=(result_t&&) requires std::is_trivially_move_assignable_v<T> && std::is_trivially_move_constructible_v<T> = default;
+		constexpr result_t& operator=(result_t&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+			if (this != &other) assign(std::move(other));
 			return *this;
 		}
 
-		auto operator| (auto&& function) -> decltype(function(this->value())) {
-			if (this->has_value()) return function (this->value());
-			return err;
+		constexpr ~result_t() requires std::is_trivially_destructible_v<T> = default;
+		constexpr ~result_t() { if (has_value_) value_.~T(); }
+
+		[[nodiscard]] constexpr bool has_value() const { return has_value_; }
+		constexpr explicit operator bool() const { return has_value_; }
+
+		// [*** 중요! ***] 값이 없을 때 호출하면 안됩니다. debug build 에서는 assert 로 잡습니다.
+		constexpr T& value() & { assert(has_value_); return value_; }
+		constexpr const T& value() const & { assert(has_value_); return value_; }
+		constexpr T&& value() && { assert(has_value_); return std::move(value_); }
+		constexpr T& operator*() & { assert(has_value_); return value_; }
+		constexpr const T& operator*() const & { assert(has_value_); return value_; }
+		constexpr T* operator->() { assert(has_value_); return &value_; }
+		constexpr const T* operator->() const { assert(has_value_); return &value_; }
+
+		[[nodiscard]] constexpr err_t error() const { return has_value_ ? err_t{} : err_; }
+
+		template <typename U>
+		constexpr T value_or(U&& other) const & {
+			return has_value_ ? value_ : static_cast<T>(std::forward<U>(other));
+		}
+
+		/**
+		 * \brief 값이 있으면 f(value) 의 결과(result_t<U>)를, 없으면 에러를 그대로 반환합니다.
+		 */
+		template <typename F>
+		constexpr auto and_then(F&& f) & {
+			using R = std::remove_cvref_t<std::invoke_result_t<F, T&>>;
+			if (has_value_) return std::invoke(std::forward<F>(f), value_);
+			return R(err_);
+		}
+		template <typename F>
+		constexpr auto and_then(F&& f) && {
+			using R = std::remove_cvref_t<std::invoke_result_t<F, T&&>>;
+			if (has_value_) return std::invoke(std::forward<F>(f), std::move(value_));
+			return R(err_);
+		}
+
+		/**
+		 * \brief 값이 있으면 f(value) 를 result_t<U> 로 감싸서, 없으면 에러를 그대로 반환합니다.
+		 */
+		template <typename F>
+		constexpr auto transform(F&& f) & {
+			using U = std::remove_cvref_t<std::invoke_result_t<F, T&>>;
+			if (has_value_) return result_t<U>(std::invoke(std::forward<F>(f), value_));
+			return result_t<U>(err_);
+		}
+		template <typename F>
+		constexpr auto transform(F&& f) && {
+			using U = std::remove_cvref_t<std::invoke_result_t<F, T&&>>;
+			if (has_value_) return result_t<U>(std::invoke(std::forward<F>(f), std::move(value_)));
+			return result_t<U>(err_);
 		}
-		
-		auto operator| (auto&& function) -> decltype(function()) {
-			if (this->has_value()) return function();
-			return err;
+
+		/**
+		 * \brief 에러가 있으면 f(err) 의 결과(result_t<T>)를, 없으면 자신을 반환합니다.
+		 */
+		template <typename F>
+		constexpr result_t or_else(F&& f) const & {
+			if (has_value_) return *this;
+			return std::invoke(std::forward<F>(f), err_);
+		}
+
+		/**
+		 * \brief 기존 err_opt_t 의 pipe. f 가 result_t 를 반환하면 and_then, 아니면 transform 으로 동작합니다.
+		 */
+		template <typename F> requires std::invocable<F, T&>
+		constexpr auto operator| (F&& f) & {
+			if constexpr (is_result<std::remove_cvref_t<std::invoke_result_t<F, T&>>>::value) return and_then(std::forward<F>(f));
+			else return transform(std::forward<F>(f));
+		}
+		template <typename F> requires std::invocable<F, T&&>
+		constexpr auto operator| (F&& f) && {
+			if constexpr (is_result<std::remove_cvref_t<std::invoke_result_t<F, T&&>>>::value) return std::move(*this).and_then(std::forward<F>(f));
+			else return std::move(*this).transform(std::forward<F>(f));
+		}
+		template <typename F> requires (std::invocable<F> && !std::invocable<F, T&>)
+		constexpr auto operator| (F&& f) const {
+			using R = std::remove_cvref_t<std::invoke_result_t<F>>;
+			if (has_value_) return std::invoke(std::forward<F>(f));
+			return R(err_);
+		}
+
+	private:
+		template <typename Other>
+		constexpr void assign(Other&& other) {
+			if (has_value_ && other.has_value_) {
+				value_ = std::forward<Other>(other).value_;
+				return;
+			}
+			if (has_value_) value_.~T();
+			if (other.has_value_) std::construct_at(&value_, std::forward<Other>(other).value_);
+			else std::construct_at(&err_, other.err_);
+			has_value_ = other.has_value_;
 		}
 	};
+
+	// 이전 이름. 에러는 더이상 std::string 이 아니라 err_t 입니다.
+	template <typename T>
+	using err_opt_t = result_t<T>;
 }